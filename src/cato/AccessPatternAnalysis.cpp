@@ -0,0 +1,223 @@
+#include "AccessPatternAnalysis.h"
+
+#include <llvm/ADT/Triple.h>
+#include <llvm/IR/IntrinsicInst.h>
+#include <llvm/IR/Module.h>
+
+#include "debug.h"
+
+using namespace llvm;
+
+AccessPatternAnalysis::AccessPatternAnalysis(Function *function)
+    : _function(function), _tlii(Triple(function->getParent()->getTargetTriple())),
+      _tli(_tlii, function), _ac(*function), _dt(*function), _li(_dt),
+      _se(*function, _tli, _ac, _dt, _li),
+      _expander(_se, function->getParent()->getDataLayout(), "cato.range")
+{
+}
+
+AccessPatternAnalysis::~AccessPatternAnalysis() {}
+
+bool AccessPatternAnalysis::get_contiguous_access(Instruction *access, Value *index,
+                                                  ContiguousAccess *result)
+{
+    Loop *loop = _li.getLoopFor(access->getParent());
+    if (loop == nullptr || !index->getType()->isIntegerTy() ||
+        !_se.isSCEVable(index->getType()))
+    {
+        return false;
+    }
+
+    // Only loops in the canonical rotated form are supported. That way the exit
+    // condition is only checked at the end of an iteration
+    BasicBlock *preheader = loop->getLoopPreheader();
+    BasicBlock *latch = loop->getLoopLatch();
+    if (preheader == nullptr || latch == nullptr || loop->getExitingBlock() != latch ||
+        loop->getExitBlock() == nullptr)
+    {
+        return false;
+    }
+
+    // The access has to happen in every iteration
+    if (!_dt.dominates(access->getParent(), latch))
+    {
+        return false;
+    }
+
+    Type *i64_type = Type::getInt64Ty(access->getContext());
+    const SCEV *index_scev = _se.getSCEV(index);
+    if (index_scev->getType() != i64_type)
+    {
+        index_scev = _se.getSignExtendExpr(index_scev, i64_type);
+    }
+
+    auto *add_rec = dyn_cast<SCEVAddRecExpr>(index_scev);
+    if (add_rec == nullptr || add_rec->getLoop() != loop || !add_rec->isAffine())
+    {
+        return false;
+    }
+
+    auto *step = dyn_cast<SCEVConstant>(add_rec->getStepRecurrence(_se));
+    if (step == nullptr || !step->getValue()->isOne())
+    {
+        return false;
+    }
+
+    const SCEV *backedge_count = _se.getBackedgeTakenCount(loop);
+    if (isa<SCEVCouldNotCompute>(backedge_count))
+    {
+        return false;
+    }
+    const SCEV *count = _se.getAddExpr(_se.getTruncateOrZeroExtend(backedge_count, i64_type),
+                                       _se.getOne(i64_type));
+
+    Debug(errs() << "Contiguous access in loop " << loop->getHeader()->getName() << ":\n";);
+    Debug(access->dump(););
+    Debug(errs() << "  -> start: " << *add_rec->getStart() << "\n";);
+    Debug(errs() << "  -> count: " << *count << "\n";);
+
+    result->access = access;
+    result->loop = loop;
+    result->latch = latch;
+    result->exit = loop->getExitBlock();
+    result->start = add_rec->getStart();
+    result->count = count;
+    return true;
+}
+
+const SCEV *AccessPatternAnalysis::get_loop_invariant_index(Value *index, Loop *loop)
+{
+    if (!index->getType()->isIntegerTy() || !_se.isSCEVable(index->getType()))
+    {
+        return nullptr;
+    }
+
+    const SCEV *index_scev =
+        _se.getNoopOrSignExtend(_se.getSCEV(index), Type::getInt64Ty(index->getContext()));
+    if (!_se.isLoopInvariant(index_scev, loop))
+    {
+        return nullptr;
+    }
+    return index_scev;
+}
+
+const Loop *AccessPatternAnalysis::get_offset_to_loaded_start(Value *index, Value *start_ptr,
+                                                              long *offset)
+{
+    if (!index->getType()->isIntegerTy() || !_se.isSCEVable(index->getType()))
+    {
+        return nullptr;
+    }
+
+    const SCEV *index_scev =
+        _se.getNoopOrSignExtend(_se.getSCEV(index), Type::getInt64Ty(index->getContext()));
+    auto *add_rec = dyn_cast<SCEVAddRecExpr>(index_scev);
+    if (add_rec == nullptr || !add_rec->isAffine() ||
+        add_rec->getLoop()->getLoopPreheader() == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto *step = dyn_cast<SCEVConstant>(add_rec->getStepRecurrence(_se));
+    if (step == nullptr || !step->getValue()->isOne())
+    {
+        return nullptr;
+    }
+
+    // Split the start into the constant offset and the loaded value
+    const SCEV *start = add_rec->getStart();
+    *offset = 0;
+    if (auto *add = dyn_cast<SCEVAddExpr>(start))
+    {
+        auto *constant = dyn_cast<SCEVConstant>(add->getOperand(0));
+        if (add->getNumOperands() != 2 || constant == nullptr)
+        {
+            return nullptr;
+        }
+        *offset = constant->getAPInt().getSExtValue();
+        start = add->getOperand(1);
+    }
+    while (auto *cast = dyn_cast<SCEVCastExpr>(start))
+    {
+        start = cast->getOperand();
+    }
+
+    auto *unknown = dyn_cast<SCEVUnknown>(start);
+    auto *load = unknown != nullptr ? dyn_cast<LoadInst>(unknown->getValue()) : nullptr;
+    if (load == nullptr || load->getPointerOperand() != start_ptr)
+    {
+        return nullptr;
+    }
+    return add_rec->getLoop();
+}
+
+bool AccessPatternAnalysis::get_constant_distance(const SCEV *a, const SCEV *b, long *distance)
+{
+    if (auto *difference = dyn_cast<SCEVConstant>(_se.getMinusSCEV(a, b)))
+    {
+        *distance = difference->getAPInt().getSExtValue();
+        return true;
+    }
+    return false;
+}
+
+bool AccessPatternAnalysis::has_unknown_calls(Loop *loop, std::set<Function *> &ignored)
+{
+    for (BasicBlock *block : loop->blocks())
+    {
+        for (Instruction &inst : *block)
+        {
+            if (auto *call = dyn_cast<CallBase>(&inst))
+            {
+                Function *callee = call->getCalledFunction();
+                if (isa<IntrinsicInst>(call) || call->doesNotAccessMemory() ||
+                    (callee != nullptr && ignored.find(callee) != ignored.end()))
+                {
+                    continue;
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool AccessPatternAnalysis::depends_only_on_iteration(Value *value, Loop *loop)
+{
+    std::vector<Value *> worklist = {value};
+    std::set<Instruction *> visited;
+    while (!worklist.empty())
+    {
+        auto *inst = dyn_cast<Instruction>(worklist.back());
+        worklist.pop_back();
+        if (inst == nullptr || !loop->contains(inst) || !visited.insert(inst).second)
+        {
+            continue;
+        }
+
+        if (inst->mayReadOrWriteMemory() || inst->mayHaveSideEffects())
+        {
+            return false;
+        }
+        worklist.insert(worklist.end(), inst->op_begin(), inst->op_end());
+    }
+    return true;
+}
+
+bool AccessPatternAnalysis::is_expandable(const SCEV *expr, Loop *loop)
+{
+    return isSafeToExpandAt(expr, loop->getLoopPreheader()->getTerminator(), _se);
+}
+
+Value *AccessPatternAnalysis::expand_in_preheader(const SCEV *expr, long addend, Loop *loop)
+{
+    Type *i64_type = Type::getInt64Ty(_function->getContext());
+    const SCEV *sum = _se.getAddExpr(expr, _se.getConstant(i64_type, addend, true));
+    return _expander.expandCodeFor(sum, i64_type, loop->getLoopPreheader()->getTerminator());
+}
+
+DominatorTree &AccessPatternAnalysis::get_dominator_tree() { return _dt; }
+
+LoopInfo &AccessPatternAnalysis::get_loop_info() { return _li; }
+
+ScalarEvolution &AccessPatternAnalysis::get_scalar_evolution() { return _se; }
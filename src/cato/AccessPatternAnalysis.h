@@ -0,0 +1,124 @@
+#ifndef CATO_ACCESS_PATTERN_ANALYSIS_H
+#define CATO_ACCESS_PATTERN_ANALYSIS_H
+
+#include <set>
+
+#include <llvm/Analysis/AssumptionCache.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/TargetLibraryInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/Transforms/Utils/ScalarEvolutionExpander.h>
+
+/**
+ * Struct describing a shared memory access inside of a loop, whose index advances
+ * by exactly one element in each iteration of the loop
+ **/
+struct ContiguousAccess
+{
+    // The load or store instruction on the shared memory object
+    llvm::Instruction *access;
+
+    // The loop in which the accessed index is incremented
+    llvm::Loop *loop;
+
+    // The single edge on which the loop is left
+    llvm::BasicBlock *latch;
+    llvm::BasicBlock *exit;
+
+    // The accessed index in the first iteration of the loop (as i64)
+    const llvm::SCEV *start;
+
+    // The number of iterations of the loop (as i64)
+    const llvm::SCEV *count;
+};
+
+/**
+ * The AccessPatternAnalysis class sets up the LLVM loop and scalar evolution analyses
+ * for a single function and uses them to find shared memory accesses that can be
+ * combined into range transfers.
+ *
+ * The analyses are only valid as long as the control flow of the function is not
+ * changed, so all queries should happen before the accesses get replaced.
+ **/
+class AccessPatternAnalysis
+{
+  private:
+    llvm::Function *_function;
+
+    llvm::TargetLibraryInfoImpl _tlii;
+    llvm::TargetLibraryInfo _tli;
+    llvm::AssumptionCache _ac;
+    llvm::DominatorTree _dt;
+    llvm::LoopInfo _li;
+    llvm::ScalarEvolution _se;
+    llvm::SCEVExpander _expander;
+
+  public:
+    AccessPatternAnalysis(llvm::Function *function);
+
+    ~AccessPatternAnalysis();
+
+    /**
+     * Checks if the memory access instruction accesses the given index with a unit stride
+     * in its innermost surrounding loop. The loop has to be in a canonical rotated form
+     * and the access has to be executed in every iteration.
+     * Returns true and fills result if that is the case.
+     **/
+    bool get_contiguous_access(llvm::Instruction *access, llvm::Value *index,
+                               ContiguousAccess *result);
+
+    /**
+     * Returns the index as an i64 SCEV if its value does not change inside of the loop,
+     * nullptr otherwise
+     **/
+    const llvm::SCEV *get_loop_invariant_index(llvm::Value *index, llvm::Loop *loop);
+
+    /**
+     * Checks if the index advances by one in each iteration of a loop and starts at the
+     * value loaded from start_ptr plus a constant, like a neighbour access with the
+     * iteration variable of a worksharing loop. Returns the loop and writes the constant
+     * to offset, nullptr otherwise.
+     **/
+    const llvm::Loop *get_offset_to_loaded_start(llvm::Value *index, llvm::Value *start_ptr,
+                                                 long *offset);
+
+    /**
+     * Returns true if the difference between the two SCEVs is a compile time constant.
+     * The difference a - b is written to distance.
+     **/
+    bool get_constant_distance(const llvm::SCEV *a, const llvm::SCEV *b, long *distance);
+
+    /**
+     * Returns true if the loop contains a call instruction to a function that is
+     * neither an intrinsic, free of memory accesses nor part of the ignored functions.
+     **/
+    bool has_unknown_calls(llvm::Loop *loop, std::set<llvm::Function *> &ignored);
+
+    /**
+     * Returns true if the value is computed inside of the loop without accessing memory,
+     * only from values of the current iteration, like the iteration variable, and values
+     * defined outside of the loop
+     **/
+    bool depends_only_on_iteration(llvm::Value *value, llvm::Loop *loop);
+
+    /**
+     * Returns true if the SCEV expression can be materialized in the preheader of the loop
+     **/
+    bool is_expandable(const llvm::SCEV *expr, llvm::Loop *loop);
+
+    /**
+     * Materializes expr + addend as an i64 value at the end of the preheader of the loop
+     **/
+    llvm::Value *expand_in_preheader(const llvm::SCEV *expr, long addend, llvm::Loop *loop);
+
+    llvm::DominatorTree &get_dominator_tree();
+
+    llvm::LoopInfo &get_loop_info();
+
+    llvm::ScalarEvolution &get_scalar_evolution();
+};
+
+#endif
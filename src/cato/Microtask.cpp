@@ -42,6 +42,8 @@ Microtask::Microtask(CallInst *fork_call)
     ParallelForData tmp_parallel_for;
     tmp_parallel_for.init = nullptr;
     tmp_parallel_for.fini = nullptr;
+    tmp_parallel_for.owner_variable = nullptr;
+    tmp_parallel_for.owner_offset = 0;
     for (auto &call : call_instructions)
     {
         std::vector<std::string> function_list = {
@@ -65,7 +67,27 @@ Microtask::Microtask(CallInst *fork_call)
         }
     }
 
-    // Look for a reduction inside the microtask;
+    // Look for dynamically scheduled parallel for loops. The dispatch_next and dispatch_fini
+    // calls belong to the preceding dispatch_init
+    for (auto &call : call_instructions)
+    {
+        StringRef name = call->getCalledFunction()->getName();
+        if (name.startswith("__kmpc_dispatch_init_"))
+        {
+            _dynamic_for.push_back({call, {}, {}});
+        }
+        else if (name.startswith("__kmpc_dispatch_next_") && !_dynamic_for.empty())
+        {
+            _dynamic_for.back().next.push_back(call);
+        }
+        else if (name.startswith("__kmpc_dispatch_fini_") && !_dynamic_for.empty())
+        {
+            _dynamic_for.back().fini.push_back(call);
+        }
+    }
+
+    // Look for a reduction inside the microtask. A blocking reduction ends with a
+    // __kmpc_end_reduce in both cases of its switch, only the first one belongs to the pair.
     ReductionData tmp_reduction_data;
     tmp_reduction_data.reduce = nullptr;
     tmp_reduction_data.end_reduce = nullptr;
@@ -80,7 +102,8 @@ Microtask::Microtask(CallInst *fork_call)
         {
             tmp_reduction_data.reduce = call;
         }
-        else if (is_in_list(call->getCalledFunction()->getName(), function_list_end))
+        else if (tmp_reduction_data.reduce != nullptr &&
+                 is_in_list(call->getCalledFunction()->getName(), function_list_end))
         {
             tmp_reduction_data.end_reduce = call;
         }
@@ -135,6 +158,18 @@ std::vector<ParallelForData> *Microtask::get_parallel_for()
     }
 }
 
+std::vector<DynamicForData> *Microtask::get_dynamic_for()
+{
+    if (_dynamic_for.size() > 0)
+    {
+        return &_dynamic_for;
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
 std::vector<ReductionData> *Microtask::get_reductions()
 {
     if (_reduction.size() > 0)
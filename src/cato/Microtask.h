@@ -18,6 +18,24 @@ struct ParallelForData
 {
     llvm::CallInst *init;
     llvm::CallInst *fini;
+
+    // The shared pointer variable whose memory the loop accesses at the iteration variable
+    // plus owner_offset, nullptr if there is none. The iterations get distributed like
+    // the elements of that memory.
+    llvm::Value *owner_variable;
+    long owner_offset;
+};
+
+/**
+ * Struct with pointers to OpenMP Runtime Library calls for parallel for loops with a
+ * dynamic, guided or runtime schedule. A loop can have several dispatch_next calls and
+ * dispatch_fini calls are only emitted for ordered loops.
+ **/
+struct DynamicForData
+{
+    llvm::CallInst *init;
+    std::vector<llvm::CallInst *> next;
+    std::vector<llvm::CallInst *> fini;
 };
 
 /**
@@ -58,6 +76,9 @@ class Microtask
     // Parallel for inside the microtask
     std::vector<ParallelForData> _parallel_for;
 
+    // Dynamically scheduled parallel for inside the microtask
+    std::vector<DynamicForData> _dynamic_for;
+
     // Reduction inside the microtask
     std::vector<ReductionData> _reduction;
 
@@ -78,6 +99,8 @@ class Microtask
 
     std::vector<ParallelForData> *get_parallel_for();
 
+    std::vector<DynamicForData> *get_dynamic_for();
+
     std::vector<ReductionData> *get_reductions();
 
     std::vector<CriticalData> *get_critical();
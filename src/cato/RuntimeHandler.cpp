@@ -85,6 +85,8 @@ bool RuntimeHandler::load_external_functions()
     match_function(&functions.get_mpi_rank, "_Z12get_mpi_rankv");
     match_function(&functions.get_mpi_size, "_Z12get_mpi_sizev");
     match_function(&functions.mpi_barrier, "_Z11mpi_barrierv");
+    match_function(&functions.shared_memory_epoch_begin, "_Z25shared_memory_epoch_beginv");
+    match_function(&functions.shared_memory_epoch_end, "_Z23shared_memory_epoch_endv");
     match_function(&functions.allocate_shared_memory, "_Z22allocate_shared_memorylii");
     match_function(&functions.shared_memory_store, "_Z19shared_memory_storePvS_iz");
     match_function(&functions.shared_memory_load, "_Z18shared_memory_loadPvS_iz");
@@ -95,15 +97,134 @@ bool RuntimeHandler::load_external_functions()
                    "_Z29shared_memory_sequential_loadPvS_iz");
     match_function(&functions.shared_memory_pointer_store,
                    "_Z27shared_memory_pointer_storePvS_l");
+    match_function(&functions.shared_memory_store_range,
+                   "_Z25shared_memory_store_rangePvS_ll");
+    match_function(&functions.shared_memory_load_range, "_Z24shared_memory_load_rangePvS_ll");
+    match_function(&functions.shared_memory_store_range_2d,
+                   "_Z28shared_memory_store_range_2dPvS_lll");
+    match_function(&functions.shared_memory_load_range_2d,
+                   "_Z27shared_memory_load_range_2dPvS_lll");
+    match_function(&functions.shared_memory_exchange_halo,
+                   "_Z27shared_memory_exchange_haloPvll");
+    match_function(&functions.shared_memory_sequential_local_range,
+                   "_Z36shared_memory_sequential_local_rangePvllPlS0_");
+    match_function(&functions.shared_memory_sequential_local_range_2d,
+                   "_Z39shared_memory_sequential_local_range_2dPvlllPlS0_");
+    match_function(&functions.shared_memory_sequential_local_end,
+                   "_Z34shared_memory_sequential_local_endv");
+    match_function(&functions.shared_memory_sequential_snapshot,
+                   "_Z33shared_memory_sequential_snapshotPvi");
+    match_function(&functions.shared_memory_handle, "_Z20shared_memory_handlePv");
+    match_function(&functions.shared_memory_store_with_handle,
+                   "_Z31shared_memory_store_with_handlelPviz");
+    match_function(&functions.shared_memory_load_with_handle,
+                   "_Z30shared_memory_load_with_handlelPviz");
+    match_function(&functions.shared_memory_store_1d, "_Z22shared_memory_store_1dPvS_l");
+    match_function(&functions.shared_memory_store_2d, "_Z22shared_memory_store_2dPvS_ll");
+    match_function(&functions.shared_memory_store_3d, "_Z22shared_memory_store_3dPvS_lll");
+    match_function(&functions.shared_memory_load_1d, "_Z21shared_memory_load_1dPvS_l");
+    match_function(&functions.shared_memory_load_2d, "_Z21shared_memory_load_2dPvS_ll");
+    match_function(&functions.shared_memory_load_3d, "_Z21shared_memory_load_3dPvS_lll");
+    match_function(&functions.shared_memory_sequential_store_1d,
+                   "_Z33shared_memory_sequential_store_1dPvS_l");
+    match_function(&functions.shared_memory_sequential_store_2d,
+                   "_Z33shared_memory_sequential_store_2dPvS_ll");
+    match_function(&functions.shared_memory_sequential_store_3d,
+                   "_Z33shared_memory_sequential_store_3dPvS_lll");
+    match_function(&functions.shared_memory_sequential_load_1d,
+                   "_Z32shared_memory_sequential_load_1dPvS_l");
+    match_function(&functions.shared_memory_sequential_load_2d,
+                   "_Z32shared_memory_sequential_load_2dPvS_ll");
+    match_function(&functions.shared_memory_sequential_load_3d,
+                   "_Z32shared_memory_sequential_load_3dPvS_lll");
+    match_function(&functions.shared_memory_store_with_handle_1d,
+                   "_Z34shared_memory_store_with_handle_1dlPvl");
+    match_function(&functions.shared_memory_store_with_handle_2d,
+                   "_Z34shared_memory_store_with_handle_2dlPvll");
+    match_function(&functions.shared_memory_store_with_handle_3d,
+                   "_Z34shared_memory_store_with_handle_3dlPvlll");
+    match_function(&functions.shared_memory_load_with_handle_1d,
+                   "_Z33shared_memory_load_with_handle_1dlPvl");
+    match_function(&functions.shared_memory_load_with_handle_2d,
+                   "_Z33shared_memory_load_with_handle_2dlPvll");
+    match_function(&functions.shared_memory_load_with_handle_3d,
+                   "_Z33shared_memory_load_with_handle_3dlPvlll");
+    match_function(&functions.shared_memory_atomic_with_handle,
+                   "_Z32shared_memory_atomic_with_handlelPvS_iiz");
+    match_function(&functions.shared_memory_compare_and_swap_with_handle,
+                   "_Z42shared_memory_compare_and_swap_with_handlelPvS_S_iz");
+
+    _fixed_arity_variants[functions.shared_memory_store] = {
+        functions.shared_memory_store_1d,
+        functions.shared_memory_store_2d,
+        functions.shared_memory_store_3d};
+    _fixed_arity_variants[functions.shared_memory_load] = {
+        functions.shared_memory_load_1d,
+        functions.shared_memory_load_2d,
+        functions.shared_memory_load_3d};
+    _fixed_arity_variants[functions.shared_memory_sequential_store] = {
+        functions.shared_memory_sequential_store_1d,
+        functions.shared_memory_sequential_store_2d,
+        functions.shared_memory_sequential_store_3d};
+    _fixed_arity_variants[functions.shared_memory_sequential_load] = {
+        functions.shared_memory_sequential_load_1d,
+        functions.shared_memory_sequential_load_2d,
+        functions.shared_memory_sequential_load_3d};
+    _fixed_arity_variants[functions.shared_memory_store_with_handle] = {
+        functions.shared_memory_store_with_handle_1d,
+        functions.shared_memory_store_with_handle_2d,
+        functions.shared_memory_store_with_handle_3d};
+    _fixed_arity_variants[functions.shared_memory_load_with_handle] = {
+        functions.shared_memory_load_with_handle_1d,
+        functions.shared_memory_load_with_handle_2d,
+        functions.shared_memory_load_with_handle_3d};
+
     match_function(&functions.allocate_shared_value, "_Z21allocate_shared_valuePvi");
     match_function(&functions.shared_value_store, "_Z18shared_value_storePvS_");
     match_function(&functions.shared_value_load, "_Z17shared_value_loadPvS_");
+    match_function(&functions.shared_value_accumulate, "_Z23shared_value_accumulatePvS_i");
+    match_function(&functions.shared_value_fetch_and_op, "_Z25shared_value_fetch_and_opPvS_S_i");
+    match_function(&functions.shared_value_compare_and_swap,
+                   "_Z29shared_value_compare_and_swapPvS_S_S_");
     match_function(&functions.shared_value_synchronize, "_Z24shared_value_synchronizePv");
-    match_function(&functions.reduce_local_vars, "_Z17reduce_local_varsPvii");
+    match_function(&functions.reduce_local_vars, "_Z17reduce_local_varsPvPFvS_S_Eiz");
+    match_function(&functions.reduce_scatter_local_array,
+                   "_Z26reduce_scatter_local_arrayPvPFvS_S_ES_ll");
+    match_function(&functions.start_reduce_local_vars,
+                   "_Z23start_reduce_local_varsPvPFvS_S_Eiz");
+    match_function(&functions.reduction_wait, "_Z14reduction_waitPv");
     match_function(&functions.modify_parallel_for_bounds_4,
                    "_Z26modify_parallel_for_boundsPiS_i");
+    match_function(&functions.modify_parallel_for_bounds_4u,
+                   "_Z26modify_parallel_for_boundsPjS_i");
     match_function(&functions.modify_parallel_for_bounds_8,
                    "_Z26modify_parallel_for_boundsPlS_l");
+    match_function(&functions.modify_parallel_for_bounds_8u,
+                   "_Z26modify_parallel_for_boundsPmS_l");
+    match_function(&functions.modify_parallel_for_bounds_aligned_4,
+                   "_Z34modify_parallel_for_bounds_alignedPiS_iPvl");
+    match_function(&functions.modify_parallel_for_bounds_aligned_4u,
+                   "_Z34modify_parallel_for_bounds_alignedPjS_iPvl");
+    match_function(&functions.modify_parallel_for_bounds_aligned_8,
+                   "_Z34modify_parallel_for_bounds_alignedPlS_lPvl");
+    match_function(&functions.modify_parallel_for_bounds_aligned_8u,
+                   "_Z34modify_parallel_for_bounds_alignedPmS_lPvl");
+    match_function(&functions.parallel_for_dispatch_init_4,
+                   "_Z26parallel_for_dispatch_initiiiii");
+    match_function(&functions.parallel_for_dispatch_init_4u,
+                   "_Z26parallel_for_dispatch_initijjii");
+    match_function(&functions.parallel_for_dispatch_init_8,
+                   "_Z26parallel_for_dispatch_initillll");
+    match_function(&functions.parallel_for_dispatch_init_8u,
+                   "_Z26parallel_for_dispatch_initimmll");
+    match_function(&functions.parallel_for_dispatch_next_4,
+                   "_Z26parallel_for_dispatch_nextPiS_S_S_");
+    match_function(&functions.parallel_for_dispatch_next_4u,
+                   "_Z26parallel_for_dispatch_nextPiPjS0_S_");
+    match_function(&functions.parallel_for_dispatch_next_8,
+                   "_Z26parallel_for_dispatch_nextPiPlS0_S0_");
+    match_function(&functions.parallel_for_dispatch_next_8u,
+                   "_Z26parallel_for_dispatch_nextPiPmS0_Pl");
     match_function(&functions.critical_section_init, "_Z21critical_section_initv");
     match_function(&functions.critical_section_enter, "_Z22critical_section_enterPv");
     match_function(&functions.critical_section_leave, "_Z22critical_section_leavePv");
@@ -224,6 +345,31 @@ void RuntimeHandler::replace_omp_functions()
     }
 }
 
+CallInst *RuntimeHandler::create_shared_memory_access(IRBuilder<> &builder, Function *function,
+                                                      std::vector<Value *> args)
+{
+    // The number of indices is the last fixed parameter of the varargs function
+    unsigned num_indices_pos = function->getFunctionType()->getNumParams() - 1;
+    auto *num_indices = cast<ConstantInt>(args[num_indices_pos]);
+
+    // The rtlib reads the indices as long values
+    for (unsigned i = num_indices_pos + 1; i < args.size(); i++)
+    {
+        args[i] = builder.CreateSExtOrTrunc(args[i], builder.getInt64Ty());
+    }
+
+    auto variants = _fixed_arity_variants.find(function);
+    long dimensions = num_indices->getSExtValue();
+    if (variants != _fixed_arity_variants.end() && dimensions >= 1 && dimensions <= 3 &&
+        variants->second[dimensions - 1] != nullptr)
+    {
+        args.erase(args.begin() + num_indices_pos);
+        return builder.CreateCall(variants->second[dimensions - 1], args);
+    }
+
+    return builder.CreateCall(function, args);
+}
+
 llvm::BasicBlock *RuntimeHandler::get_entry_block() { return _entry_block; }
 
 llvm::BasicBlock *RuntimeHandler::get_finalize_block() { return _finalize_block; }
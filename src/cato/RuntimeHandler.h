@@ -3,9 +3,13 @@
 
 #include <llvm/ADT/StringRef.h>
 #include <llvm/IR/Constants.h>
+#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Module.h>
 
+#include <array>
+#include <map>
 #include <memory>
+#include <vector>
 
 /**
  * All rtlib functions that can be called from inside the pass
@@ -28,24 +32,78 @@ struct external_functions
     llvm::Function *get_mpi_rank;
     llvm::Function *get_mpi_size;
     llvm::Function *mpi_barrier;
+    llvm::Function *shared_memory_epoch_begin;
+    llvm::Function *shared_memory_epoch_end;
     llvm::Function *allocate_shared_memory;
     llvm::Function *shared_memory_load;
+    llvm::Function *shared_memory_load_1d;
+    llvm::Function *shared_memory_load_2d;
+    llvm::Function *shared_memory_load_3d;
     llvm::Function *shared_memory_store;
+    llvm::Function *shared_memory_store_1d;
+    llvm::Function *shared_memory_store_2d;
+    llvm::Function *shared_memory_store_3d;
     llvm::Function *shared_memory_free;
     llvm::Function *shared_memory_sequential_store;
+    llvm::Function *shared_memory_sequential_store_1d;
+    llvm::Function *shared_memory_sequential_store_2d;
+    llvm::Function *shared_memory_sequential_store_3d;
     llvm::Function *shared_memory_sequential_load;
+    llvm::Function *shared_memory_sequential_load_1d;
+    llvm::Function *shared_memory_sequential_load_2d;
+    llvm::Function *shared_memory_sequential_load_3d;
     llvm::Function *shared_memory_pointer_store;
+    llvm::Function *shared_memory_store_range;
+    llvm::Function *shared_memory_store_range_2d;
+    llvm::Function *shared_memory_handle;
+    llvm::Function *shared_memory_store_with_handle;
+    llvm::Function *shared_memory_store_with_handle_1d;
+    llvm::Function *shared_memory_store_with_handle_2d;
+    llvm::Function *shared_memory_store_with_handle_3d;
+    llvm::Function *shared_memory_load_with_handle;
+    llvm::Function *shared_memory_load_with_handle_1d;
+    llvm::Function *shared_memory_load_with_handle_2d;
+    llvm::Function *shared_memory_load_with_handle_3d;
+    llvm::Function *shared_memory_atomic_with_handle;
+    llvm::Function *shared_memory_compare_and_swap_with_handle;
+    llvm::Function *shared_memory_load_range;
+    llvm::Function *shared_memory_load_range_2d;
+    llvm::Function *shared_memory_exchange_halo;
+    llvm::Function *shared_memory_sequential_local_range;
+    llvm::Function *shared_memory_sequential_local_range_2d;
+    llvm::Function *shared_memory_sequential_local_end;
+    llvm::Function *shared_memory_sequential_snapshot;
     llvm::Function *allocate_shared_value;
     llvm::Function *shared_value_store;
     llvm::Function *shared_value_load;
+    llvm::Function *shared_value_accumulate;
+    llvm::Function *shared_value_fetch_and_op;
+    llvm::Function *shared_value_compare_and_swap;
     llvm::Function *shared_value_synchronize;
     llvm::Function *modify_parallel_for_bounds_4;
+    llvm::Function *modify_parallel_for_bounds_4u;
     llvm::Function *modify_parallel_for_bounds_8;
+    llvm::Function *modify_parallel_for_bounds_8u;
+    llvm::Function *modify_parallel_for_bounds_aligned_4;
+    llvm::Function *modify_parallel_for_bounds_aligned_4u;
+    llvm::Function *modify_parallel_for_bounds_aligned_8;
+    llvm::Function *modify_parallel_for_bounds_aligned_8u;
+    llvm::Function *parallel_for_dispatch_init_4;
+    llvm::Function *parallel_for_dispatch_init_4u;
+    llvm::Function *parallel_for_dispatch_init_8;
+    llvm::Function *parallel_for_dispatch_init_8u;
+    llvm::Function *parallel_for_dispatch_next_4;
+    llvm::Function *parallel_for_dispatch_next_4u;
+    llvm::Function *parallel_for_dispatch_next_8;
+    llvm::Function *parallel_for_dispatch_next_8u;
     llvm::Function *critical_section_init;
     llvm::Function *critical_section_enter;
     llvm::Function *critical_section_leave;
     llvm::Function *critical_section_finalize;
     llvm::Function *reduce_local_vars;
+    llvm::Function *reduce_scatter_local_array;
+    llvm::Function *start_reduce_local_vars;
+    llvm::Function *reduction_wait;
 
     // MPI library functions
 };
@@ -72,6 +130,9 @@ class RuntimeHandler
     // the external functions used by the pass
     std::unique_ptr<llvm::Module> _rtlib_module;
 
+    // The fixed arity 1D, 2D and 3D variants of the varargs shared memory access functions
+    std::map<llvm::Function *, std::array<llvm::Function *, 3>> _fixed_arity_variants;
+
     /**
      * Load the rtlib.bc file in the build directory
      **/
@@ -120,6 +181,18 @@ class RuntimeHandler
      **/
     void replace_omp_functions();
 
+    /**
+     * Creates a call to one of the varargs shared memory access functions of rtlib
+     * (e.g. shared_memory_sequential_store) in front of the insert point of builder.
+     * args are the arguments of the varargs function: the leading arguments, the number
+     * of indices and the indices.
+     * If the function has a fixed arity variant for the number of indices, that variant
+     * is called instead. The indices are converted to i64 in both cases.
+     **/
+    llvm::CallInst *create_shared_memory_access(llvm::IRBuilder<> &builder,
+                                                llvm::Function *function,
+                                                std::vector<llvm::Value *> args);
+
     llvm::BasicBlock *get_entry_block();
 
     llvm::BasicBlock *get_finalize_block();
@@ -26,12 +26,24 @@ void UserTree::generate_tree(UserTreeNode *curr_node)
         // recursively call this function again to keep generating the tree
         for (auto *user : curr_node->value->users())
         {
+            // Values that are carried around a loop through a phi node, like the old value
+            // of a compare and swap loop, lead back to an instruction of the path
+            if (is_on_path(curr_node, user))
+            {
+                continue;
+            }
+
             auto new_node = new UserTreeNode;
             new_node->value = user;
             new_node->parent = curr_node;
             curr_node->neighbours.push_back(new_node);
             generate_tree(new_node);
         }
+
+        if (curr_node->neighbours.empty())
+        {
+            _leafs.push_back(curr_node);
+        }
     }
     // If the current instruction does not have any users it is either a leaf
     // or the following users are not in this function and we have to follow
@@ -100,6 +112,18 @@ void UserTree::generate_tree(UserTreeNode *curr_node)
     }
 }
 
+bool UserTree::is_on_path(UserTreeNode *curr_node, Value *value)
+{
+    for (UserTreeNode *node = curr_node; node != nullptr; node = node->parent)
+    {
+        if (node->value == value)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void UserTree::delete_tree(UserTreeNode *curr_node)
 {
     if (curr_node->neighbours.size() > 0)
@@ -48,6 +48,11 @@ class UserTree
      **/
     void generate_tree(UserTreeNode *curr_node);
 
+    /**
+     * Returns true if value is the value of curr_node or of one of its ancestors
+     **/
+    bool is_on_path(UserTreeNode *curr_node, llvm::Value *value);
+
     /**
      * Delete the tree recursively and free all memory
      **/
@@ -3,8 +3,11 @@
 #include <llvm/Transforms/IPO/PassManagerBuilder.h>
 
 #include <llvm/ADT/StringRef.h>
+#include <llvm/Analysis/ValueTracking.h>
 #include <llvm/IR/BasicBlock.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/Module.h>
 
 #include <llvm/Passes/PassBuilder.h>
@@ -12,12 +15,16 @@
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Transforms/Utils/BasicBlockUtils.h>
 
+#include <algorithm>
+#include <map>
 #include <memory>
 #include <set>
+#include <tuple>
 // #include <vector>
 
 // #include "Microtask.h"
 // #include "RuntimeHandler.h"
+#include "AccessPatternAnalysis.h"
 #include "UserTree.h"
 #include "cato.hpp"
 #include "debug.h"
@@ -98,13 +105,16 @@ std::vector<CallInst *> CatoPass::find_memory_deallocations(Module &M)
  *values. no pointer stores) load_paths: Output parameter for all load paths in paths (only
  *loads of acrual values. no pointer loads) ptr_store_paths: Output parameter for all paths
  *where a pointer is stored free_paths: Output parameter for all free paths in paths
+ * atomic_paths: Optional output parameter for all atomicrmw and cmpxchg instructions on non
+ * pointer values of the shared memory
  **/
 void CatoPass::categorize_memory_access_paths(
     std::vector<std::vector<Value *>> &paths,
     std::vector<std::pair<int, std::vector<Value *>>> *store_paths,
     std::vector<std::pair<int, std::vector<Value *>>> *load_paths,
     std::vector<std::pair<int, std::vector<Value *>>> *ptr_store_paths,
-    std::vector<std::vector<Value *>> *free_paths)
+    std::vector<std::vector<Value *>> *free_paths,
+    std::vector<std::pair<int, std::vector<Value *>>> *atomic_paths)
 {
     std::set<Value *> categorized_instructions;
 
@@ -174,6 +184,29 @@ void CatoPass::categorize_memory_access_paths(
                     }
                 }
             }
+            else if (isa<AtomicRMWInst>(u) || isa<AtomicCmpXchgInst>(u))
+            {
+                // Only atomic operations on the shared memory, not the ones that use a
+                // value of it as operand
+                Value *pointer = nullptr;
+                Type *type = nullptr;
+                if (auto *rmw = dyn_cast<AtomicRMWInst>(u))
+                {
+                    pointer = rmw->getPointerOperand();
+                    type = rmw->getValOperand()->getType();
+                }
+                else
+                {
+                    pointer = cast<AtomicCmpXchgInst>(u)->getPointerOperand();
+                    type = cast<AtomicCmpXchgInst>(u)->getNewValOperand()->getType();
+                }
+                if (atomic_paths != nullptr && !type->isPointerTy() &&
+                    std::find(path.begin(), path.begin() + i, pointer) != path.begin() + i &&
+                    categorized_instructions.insert(u).second)
+                {
+                    atomic_paths->push_back({i, path});
+                }
+            }
             else if (auto *call_inst = dyn_cast<CallInst>(u))
             {
                 if (call_inst->getCalledFunction()->getName().equals("free"))
@@ -251,13 +284,21 @@ CatoPass::get_memory_access_indices(Module &M,
 
     int ptr_depth = get_pointer_depth(ptr_type);
 
+    // Accesses through a bitcast, like the integer accesses of atomic updates of floating
+    // point values, have the indices of the original pointer
+    Value *pointer = instruction->getPointerOperand();
+    if (auto *cast = dyn_cast<BitCastInst>(pointer))
+    {
+        pointer = cast->getOperand(0);
+    }
+
     builder.SetInsertPoint(instruction);
 
     // Check for all known access patterns to 1D/2D arrays/pointers
     // and determine the offsets for the memory access
     if (ptr_depth == 1)
     {
-        if (auto *gep = dyn_cast<GetElementPtrInst>(instruction->getPointerOperand()))
+        if (auto *gep = dyn_cast<GetElementPtrInst>(pointer))
         {
             // TODO fix this case
             if (auto *gep2 = dyn_cast<GetElementPtrInst>(gep->getOperand(0)))
@@ -287,7 +328,7 @@ CatoPass::get_memory_access_indices(Module &M,
     else if (ptr_depth == 2)
     {
         Debug(errs() << "Pointer depth of 2\n";);
-        if (auto *last_inst = dyn_cast<LoadInst>(instruction->getPointerOperand()))
+        if (auto *last_inst = dyn_cast<LoadInst>(pointer))
         {
             if (auto *gep = dyn_cast<GetElementPtrInst>(last_inst->getPointerOperand()))
             {
@@ -312,7 +353,7 @@ CatoPass::get_memory_access_indices(Module &M,
                 indices.push_back(builder.getInt64(0));
             }
         }
-        else if (auto *gep2 = dyn_cast<GetElementPtrInst>(instruction->getPointerOperand()))
+        else if (auto *gep2 = dyn_cast<GetElementPtrInst>(pointer))
         {
             if (auto *inst = dyn_cast<LoadInst>(gep2->getPointerOperand()))
             {
@@ -357,7 +398,7 @@ CatoPass::get_memory_access_indices(Module &M,
     {
         Debug(errs() << "Pointer depth of 3\n";);
 
-        if (auto *load = dyn_cast<LoadInst>(instruction->getPointerOperand()))
+        if (auto *load = dyn_cast<LoadInst>(pointer))
         {
             if (auto *load1 = dyn_cast<LoadInst>(load->getPointerOperand()))
             {
@@ -401,7 +442,7 @@ CatoPass::get_memory_access_indices(Module &M,
                 }
             }
         }
-        else if (auto *gep = dyn_cast<GetElementPtrInst>(instruction->getPointerOperand()))
+        else if (auto *gep = dyn_cast<GetElementPtrInst>(pointer))
         {
             if (auto *load1 = dyn_cast<LoadInst>(gep->getPointerOperand()))
             {
@@ -614,6 +655,9 @@ void CatoPass::replace_sequential_shared_memory_accesses(Module &M, RuntimeHandl
     categorize_memory_access_paths(paths, &store_paths, &load_paths, &ptr_store_paths,
                                    &free_paths);
 
+    replace_sequential_init_loops(M, runtime, load_paths, store_paths);
+    insert_sequential_snapshots(M, runtime, load_paths, store_paths);
+
     IRBuilder<> builder(M.getContext());
     LLVMContext &Ctx = M.getContext();
     // Now we need to find the offsets of the shared memory accesses
@@ -682,8 +726,8 @@ void CatoPass::replace_sequential_shared_memory_accesses(Module &M, RuntimeHandl
             builder.SetInsertPoint(load);
             Value *void_ptr = builder.CreateBitCast(load_value, Type::getInt8PtrTy(Ctx));
             args.insert(args.begin() + 1, void_ptr);
-            CallInst *load_call =
-                builder.CreateCall(runtime.functions.shared_memory_sequential_load, args);
+            CallInst *load_call = runtime.create_shared_memory_access(
+                builder, runtime.functions.shared_memory_sequential_load, args);
             Value *bitcast = builder.CreateBitCast(void_ptr, load->getPointerOperandType());
             Value *new_load = builder.CreateLoad(bitcast->getType()->getPointerElementType(),
                                                  bitcast, "CATO: New Load Call");
@@ -761,8 +805,8 @@ void CatoPass::replace_sequential_shared_memory_accesses(Module &M, RuntimeHandl
             builder.CreateStore(store->getOperand(0), store_value);
             Value *void_ptr = builder.CreateBitCast(store_value, Type::getInt8PtrTy(Ctx));
             args.insert(args.begin() + 1, void_ptr);
-            Value *new_store_call =
-                builder.CreateCall(runtime.functions.shared_memory_sequential_store, args);
+            Value *new_store_call = runtime.create_shared_memory_access(
+                builder, runtime.functions.shared_memory_sequential_store, args);
             store->replaceAllUsesWith(new_store_call);
             store->eraseFromParent();
         }
@@ -925,6 +969,9 @@ void CatoPass::replace_sequential_pointers_to_shared_memory(
         }
     }
 
+    replace_sequential_init_loops(M, runtime, load_paths, store_paths);
+    insert_sequential_snapshots(M, runtime, load_paths, store_paths);
+
     IRBuilder<> builder(M.getContext());
     LLVMContext &Ctx = M.getContext();
 
@@ -990,8 +1037,8 @@ void CatoPass::replace_sequential_pointers_to_shared_memory(
             builder.SetInsertPoint(load);
             Value *void_ptr = builder.CreateBitCast(load_value, Type::getInt8PtrTy(Ctx));
             args.insert(args.begin() + 1, void_ptr);
-            auto *load_call =
-                builder.CreateCall(runtime.functions.shared_memory_sequential_load, args);
+            auto *load_call = runtime.create_shared_memory_access(
+                builder, runtime.functions.shared_memory_sequential_load, args);
             Value *bitcast = builder.CreateBitCast(void_ptr, load->getPointerOperandType());
             Value *new_load = builder.CreateLoad(bitcast->getType()->getPointerElementType(),
                                                  bitcast, "CATO: Replacement of load call");
@@ -1067,8 +1114,8 @@ void CatoPass::replace_sequential_pointers_to_shared_memory(
             builder.CreateStore(store->getOperand(0), store_value);
             Value *void_ptr = builder.CreateBitCast(store_value, Type::getInt8PtrTy(Ctx));
             args.insert(args.begin() + 1, void_ptr);
-            Value *new_store_call =
-                builder.CreateCall(runtime.functions.shared_memory_sequential_store, args);
+            Value *new_store_call = runtime.create_shared_memory_access(
+                builder, runtime.functions.shared_memory_sequential_store, args);
             store->replaceAllUsesWith(new_store_call);
             store->eraseFromParent();
         }
@@ -1076,215 +1123,1284 @@ void CatoPass::replace_sequential_pointers_to_shared_memory(
 }
 
 /**
- * Looks at all load, store and free instructions that are used on shared memory segments
- * in Microtasks
- * The memory allocations for the shared memory segments have to already be done through
- * the runtime library call 'allocate_shared_memory'.
- *
- * The functions creates UserTrees for each shared memory allocation and looks
- * for store/load instructions on non pointer values (also free memory calls) to the shared
- * memory object and replaces them by corresponding calls to the cato runtime library.
- *
- * Accesses to shared memory outside of Microtasks are not handled by this function.
+ * Different paths can start with separate loads of the same shared variable, so
+ * conflicting accesses are identified by the shared variable and not the base pointer
  **/
-void CatoPass::replace_microtask_shared_memory_accesses(
-    Module &M, RuntimeHandler &runtime, std::vector<std::unique_ptr<Microtask>> &microtasks)
+static Value *get_shared_variable(std::vector<Value *> &path)
 {
-    for (auto &microtask : microtasks)
+    if (auto *load = dyn_cast<LoadInst>(path[0]))
     {
-        std::vector<Value *> shared_value_variables, shared_pointer_variables,
-            shared_struct_variables;
+        return load->getPointerOperand();
+    }
+    return path[0];
+}
 
-        for (auto &shared_variable : microtask->get_shared_variables())
+/**
+ * Returns the number of accesses of the paths to the shared variable inside of the loop
+ **/
+static int count_accesses_in_loop(std::vector<std::pair<int, std::vector<Value *>>> &paths,
+                                  Value *shared_variable, Loop *loop)
+{
+    int count = 0;
+    for (auto &p : paths)
+    {
+        auto *inst = dyn_cast<Instruction>(p.second[p.first]);
+        if (get_shared_variable(p.second) == shared_variable && loop->contains(inst))
         {
-            if (get_pointer_depth(shared_variable) == 1)
+            count++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Looks for loops in the non OpenMP sections of the program, whose only access to a 1D
+ * shared memory object, or to one row of a 2D shared memory object, stores to an index that
+ * is incremented by one in every loop iteration, with a value that only depends on the
+ * iteration, like the initialization a[i] = 2 * i.
+ * All processes execute the sequential code and can compute each value on their own, so
+ * instead of a shared_memory_sequential_store for every element, which synchronizes all
+ * processes, each process only writes the elements of the range that it stores locally.
+ * The local part of the range is requested with shared_memory_sequential_local_range in
+ * front of the loop, inside the loop the store is skipped for all other elements and
+ * shared_memory_sequential_local_end makes the values visible behind the loop.
+ * All replaced stores are removed from store_paths.
+ **/
+void CatoPass::replace_sequential_init_loops(
+    Module &M, RuntimeHandler &runtime,
+    std::vector<std::pair<int, std::vector<Value *>>> &load_paths,
+    std::vector<std::pair<int, std::vector<Value *>>> &store_paths)
+{
+    struct InitLoop
+    {
+        StoreInst *store;
+        Value *base_ptr;
+        Value *index;
+        ContiguousAccess range;
+        // The loop invariant row index for stores to a row of a 2D array
+        const SCEV *row_index;
+        Value *start;
+        Value *count;
+        Value *row;
+    };
+
+    std::set<Function *> functions;
+    for (auto &p : store_paths)
+    {
+        functions.insert(cast<Instruction>(p.second[p.first])->getFunction());
+    }
+
+    IRBuilder<> builder(M.getContext());
+    LLVMContext &Ctx = M.getContext();
+    Type *i64_type = builder.getInt64Ty();
+    std::set<Value *> replaced_stores;
+
+    for (Function *function : functions)
+    {
+        AccessPatternAnalysis analysis(function);
+        DominatorTree &dominator_tree = analysis.get_dominator_tree();
+
+        // Called functions could also access the shared memory object
+        std::set<Function *> ignored_calls;
+
+        std::vector<InitLoop> init_loops;
+        for (auto &p : store_paths)
+        {
+            // The stores replaced in other functions have already been deleted
+            if (replaced_stores.count(p.second[p.first]) > 0)
             {
-                // Special handling for struct shared variables needed
-                if (shared_variable->getType()->getPointerElementType()->isStructTy())
-                {
-                    shared_struct_variables.push_back(shared_variable);
-                    Debug(errs() << "Shared struct variable in Microtask: ";);
-                    Debug(shared_variable->dump(););
-                }
-                else
+                continue;
+            }
+            auto *store = cast<StoreInst>(p.second[p.first]);
+            auto *base_inst = dyn_cast<Instruction>(p.second[0]);
+            if (store->getFunction() != function || base_inst == nullptr ||
+                base_inst->getFunction() != function)
+            {
+                continue;
+            }
+
+            std::vector<Value *> indices = get_memory_access_indices<StoreInst>(M, p);
+            ContiguousAccess range;
+            if ((indices.size() != 2 && indices.size() != 3) ||
+                !analysis.get_contiguous_access(store, indices.back(), &range))
+            {
+                continue;
+            }
+
+            Loop *loop = range.loop;
+            const SCEV *row_index = nullptr;
+            if (indices.size() == 3)
+            {
+                row_index = analysis.get_loop_invariant_index(indices[1], loop);
+                if (row_index == nullptr || !analysis.is_expandable(row_index, loop))
                 {
-                    shared_value_variables.push_back(shared_variable);
-                    Debug(errs() << "Shared value variable in Microtask: ";);
-                    Debug(shared_variable->dump(););
+                    continue;
                 }
             }
-            else
+
+            Value *shared_variable = get_shared_variable(p.second);
+            Instruction *preheader_end = loop->getLoopPreheader()->getTerminator();
+            if (!dominator_tree.dominates(base_inst, preheader_end) ||
+                analysis.has_unknown_calls(loop, ignored_calls) ||
+                !analysis.is_expandable(range.start, loop) ||
+                !analysis.is_expandable(range.count, loop) ||
+                !analysis.depends_only_on_iteration(store->getValueOperand(), loop) ||
+                count_accesses_in_loop(load_paths, shared_variable, loop) > 0 ||
+                count_accesses_in_loop(store_paths, shared_variable, loop) > 1)
             {
-                shared_pointer_variables.push_back(shared_variable);
-                Debug(errs() << "Shared pointer variable in Microtask: ";);
-                Debug(shared_variable->dump(););
+                continue;
             }
+
+            init_loops.push_back(
+                {store, p.second[0], indices.back(), range, row_index, nullptr, nullptr,
+                 nullptr});
         }
 
-        // Check if the accessed struct member is a single value or pointer variable
-        for (auto *struct_var : shared_struct_variables)
+        // Materialize all range bounds before the IR gets modified
+        for (auto &init_loop : init_loops)
         {
-            for (auto *user : struct_var->users())
+            Loop *loop = init_loop.range.loop;
+            init_loop.start = analysis.expand_in_preheader(init_loop.range.start, 0, loop);
+            init_loop.count = analysis.expand_in_preheader(init_loop.range.count, 0, loop);
+            if (init_loop.row_index != nullptr)
             {
-                if (get_pointer_depth(user->getType()) == 1)
-                {
-                    shared_value_variables.push_back(user);
-                }
-                else if (get_pointer_depth(user->getType()) > 1)
-                {
-                    shared_pointer_variables.push_back(user);
-                }
+                init_loop.row = analysis.expand_in_preheader(init_loop.row_index, 0, loop);
             }
         }
 
-        for (auto &single_value_var : shared_value_variables)
+        // The stores of all processes are completed once behind each loop. The exit edge
+        // is split if the exit block can also be reached from somewhere else.
+        std::map<Loop *, BasicBlock *> exit_blocks;
+        for (auto &init_loop : init_loops)
         {
-            Debug(errs() << "Analysing single value shared variable: ";);
-            Debug(single_value_var->dump(););
-
-            // Check for stores to the shared value.
-            // If it is not modified in the microtask we don't need
-            // to create a memory abstraction for it.
-            bool has_stores = false;
-            for (auto *user : single_value_var->users())
+            Loop *loop = init_loop.range.loop;
+            if (exit_blocks.find(loop) == exit_blocks.end())
             {
-                if (auto *store = dyn_cast<StoreInst>(user))
+                BasicBlock *exit = init_loop.range.exit;
+                if (exit->getSinglePredecessor() != init_loop.range.latch)
                 {
-                    has_stores = true;
-                    break;
+                    exit = SplitEdge(init_loop.range.latch, exit);
                 }
+                exit_blocks[loop] = exit;
+                builder.SetInsertPoint(&*exit->getFirstInsertionPt());
+                builder.CreateCall(runtime.functions.shared_memory_sequential_local_end);
             }
+        }
 
-            if (has_stores)
+        for (auto &init_loop : init_loops)
+        {
+            StoreInst *store = init_loop.store;
+            Type *type = store->getValueOperand()->getType();
+
+            Debug(errs() << "Replacing sequential store in loop "
+                         << init_loop.range.loop->getHeader()->getName()
+                         << " with local stores\n";);
+
+            builder.SetInsertPoint(function->getEntryBlock().getFirstNonPHI());
+            Value *first_ptr = builder.CreateAlloca(i64_type);
+            Value *local_count_ptr = builder.CreateAlloca(i64_type);
+
+            builder.SetInsertPoint(init_loop.range.loop->getLoopPreheader()->getTerminator());
+            Value *void_base_ptr =
+                builder.CreateBitCast(init_loop.base_ptr, Type::getInt8PtrTy(Ctx));
+            std::vector<Value *> args = {void_base_ptr, init_loop.start, init_loop.count,
+                                         first_ptr, local_count_ptr};
+            Function *local_range = runtime.functions.shared_memory_sequential_local_range;
+            if (init_loop.row != nullptr)
             {
-                IRBuilder<> builder(M.getContext());
-                LLVMContext &Ctx = M.getContext();
-                builder.SetInsertPoint(
-                    microtask->get_function()->getEntryBlock().getFirstNonPHI());
+                args.insert(args.begin() + 1, init_loop.row);
+                local_range = runtime.functions.shared_memory_sequential_local_range_2d;
+            }
+            Value *local_ptr = builder.CreateBitCast(builder.CreateCall(local_range, args),
+                                                     type->getPointerTo());
+            Value *first = builder.CreateLoad(i64_type, first_ptr);
+            Value *local_count = builder.CreateLoad(i64_type, local_count_ptr);
 
-                Value *void_ptr = nullptr;
-                // If this is a GEP that means we are working with a struct
-                // and the base pointer to the single value shared var has to
-                // be declared at the beginning of the function
-                // for the mpi window to be created
-                if (auto *gep = dyn_cast<GetElementPtrInst>(single_value_var))
-                {
-                    auto *new_gep =
-                        builder.CreateGEP(nullptr, gep->getPointerOperand(),
-                                          {gep->getOperand(1), gep->getOperand(2)});
-                    void_ptr = builder.CreateBitCast(new_gep, Type::getInt8PtrTy(Ctx));
-                }
-                else
-                {
-                    void_ptr =
-                        builder.CreateBitCast(single_value_var, Type::getInt8PtrTy(Ctx));
-                }
-                Type *type = single_value_var->getType();
+            // The position of the element in the local part of the range, all other
+            // elements are skipped
+            builder.SetInsertPoint(store);
+            Value *index = builder.CreateSExtOrTrunc(init_loop.index, i64_type);
+            Value *position =
+                builder.CreateSub(builder.CreateSub(index, init_loop.start), first);
+            Value *is_local = builder.CreateICmpULT(position, local_count);
+            Instruction *then_end = SplitBlockAndInsertIfThen(is_local, store, false);
+            builder.SetInsertPoint(then_end);
+            builder.CreateStore(store->getValueOperand(),
+                                builder.CreateInBoundsGEP(type, local_ptr, position));
+
+            replaced_stores.insert(store);
+            store->eraseFromParent();
+        }
+    }
 
-                std::vector<Value *> args = {void_ptr,
-                                             builder.getInt32(get_mpi_datatype(type))};
+    store_paths.erase(std::remove_if(store_paths.begin(), store_paths.end(),
+                                     [&](std::pair<int, std::vector<Value *>> &p) {
+                                         return replaced_stores.count(p.second[p.first]) > 0;
+                                     }),
+                      store_paths.end());
+}
 
-                builder.CreateCall(runtime.functions.allocate_shared_value, args);
+/**
+ * Returns the rank that the branch compares the result of get_mpi_rank with, like in
+ * if (omp_get_thread_num() == 0), and writes the successor that is only taken by that
+ * process to rank_successor. Returns -1 if the branch does not depend on the rank.
+ **/
+static int get_rank_condition(Instruction *terminator, RuntimeHandler &runtime,
+                              BasicBlock **rank_successor)
+{
+    auto *branch = dyn_cast<BranchInst>(terminator);
+    if (branch == nullptr || !branch->isConditional())
+    {
+        return -1;
+    }
+    auto *compare = dyn_cast<ICmpInst>(branch->getCondition());
+    if (compare == nullptr || !compare->isEquality())
+    {
+        return -1;
+    }
 
-                // Find all store and load instructions on the shared value
+    for (int i = 0; i < 2; i++)
+    {
+        auto *call = dyn_cast<CallInst>(compare->getOperand(i));
+        auto *rank = dyn_cast<ConstantInt>(compare->getOperand(1 - i));
+        if (call != nullptr && rank != nullptr &&
+            call->getCalledFunction() == runtime.functions.get_mpi_rank &&
+            rank->getSExtValue() >= 0)
+        {
+            bool is_equal = compare->getPredicate() == CmpInst::ICMP_EQ;
+            *rank_successor = branch->getSuccessor(is_equal ? 0 : 1);
+            return rank->getSExtValue();
+        }
+    }
+    return -1;
+}
 
-                Debug(errs() << "Users for shared value:\n";);
-                for (auto *user : single_value_var->users())
+/**
+ * Looks for loops in the non OpenMP sections of the program that load from a shared memory
+ * object without storing to it, like the loops that compute a checksum or print the
+ * results. Every sequential load synchronizes all processes, so instead the whole object is
+ * copied once in front of the outermost such loop with shared_memory_sequential_snapshot
+ * and the loads are served from that copy until the object is written again.
+ * If the loop is only executed by one process, because it is guarded by a comparison of
+ * omp_get_thread_num with a constant, the snapshot is created in front of that branch,
+ * where all processes take part, and only the guarded process gets the values.
+ * The snapshot is not moved in front of loops that call a microtask or any other function
+ * that could write to the object, like the time step loop around a parallel region, since
+ * the write would drop it again in the first iteration.
+ **/
+void CatoPass::insert_sequential_snapshots(
+    Module &M, RuntimeHandler &runtime,
+    std::vector<std::pair<int, std::vector<Value *>>> &load_paths,
+    std::vector<std::pair<int, std::vector<Value *>>> &store_paths)
+{
+    std::set<Function *> functions;
+    for (auto &p : load_paths)
+    {
+        functions.insert(cast<Instruction>(p.second[p.first])->getFunction());
+    }
+
+    IRBuilder<> builder(M.getContext());
+    LLVMContext &Ctx = M.getContext();
+
+    // Calls to the runtime library that can not write to the shared memory objects
+    std::set<Function *> ignored_calls = {runtime.functions.shared_value_load,
+                                          runtime.functions.shared_value_store,
+                                          runtime.functions.shared_memory_sequential_load,
+                                          runtime.functions.shared_memory_sequential_load_1d,
+                                          runtime.functions.shared_memory_sequential_load_2d,
+                                          runtime.functions.shared_memory_sequential_load_3d,
+                                          runtime.functions.shared_memory_sequential_snapshot};
+
+    // Microtasks and the other functions of the module could write to the object, their
+    // accesses have not been replaced with calls to the runtime library yet
+    auto calls_module_function = [](Loop *loop) {
+        for (BasicBlock *block : loop->blocks())
+        {
+            for (Instruction &inst : *block)
+            {
+                auto *call = dyn_cast<CallBase>(&inst);
+                if (call != nullptr && !call->isInlineAsm() &&
+                    (call->getCalledFunction() == nullptr ||
+                     !call->getCalledFunction()->isDeclaration()))
                 {
-                    if (auto *store = dyn_cast<StoreInst>(user))
-                    {
-                        Debug(errs() << "Replacing store instruction for shared value: ";);
-                        Debug(store->dump(););
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
 
-                        builder.SetInsertPoint(
-                            store->getFunction()->getEntryBlock().getFirstNonPHI());
-                        Value *store_value =
-                            builder.CreateAlloca(store->getValueOperand()->getType());
-                        builder.SetInsertPoint(store);
-                        builder.CreateStore(store->getOperand(0), store_value);
-                        Value *store_value_ptr =
-                            builder.CreateBitCast(store_value, Type::getInt8PtrTy(Ctx));
+    for (Function *function : functions)
+    {
+        AccessPatternAnalysis analysis(function);
+        DominatorTree &dominator_tree = analysis.get_dominator_tree();
+        LoopInfo &loop_info = analysis.get_loop_info();
 
-                        std::vector<Value *> args = {void_ptr, store_value_ptr};
+        // The base pointer and the outermost loop that only reads the object, in the order
+        // of the loads
+        std::vector<std::pair<Instruction *, Loop *>> read_loops;
+        for (auto &p : load_paths)
+        {
+            auto *load = cast<Instruction>(p.second[p.first]);
+            auto *base_inst = dyn_cast<Instruction>(p.second[0]);
+            if (load->getFunction() != function || base_inst == nullptr ||
+                base_inst->getFunction() != function)
+            {
+                continue;
+            }
 
-                        Value *new_store_call =
-                            builder.CreateCall(runtime.functions.shared_value_store, args);
-                        store->replaceAllUsesWith(new_store_call);
-                        store->eraseFromParent();
-                    }
-                    else if (auto *load = dyn_cast<LoadInst>(user))
-                    {
-                        Debug(errs() << "Replacing load instruction for shared value: ";);
-                        Debug(load->dump(););
+            Value *shared_variable = get_shared_variable(p.second);
+            auto only_reads = [&](Loop *loop) {
+                return loop->getLoopPredecessor() != nullptr &&
+                       dominator_tree.dominates(base_inst,
+                                                loop->getLoopPredecessor()->getTerminator()) &&
+                       count_accesses_in_loop(store_paths, shared_variable, loop) == 0 &&
+                       !calls_module_function(loop);
+            };
+
+            Loop *loop = loop_info.getLoopFor(load->getParent());
+            if (loop == nullptr || !only_reads(loop))
+            {
+                continue;
+            }
+            // Other calls in the outer loops, like the local range of an init loop, could
+            // drop the snapshot as well
+            while (loop->getParentLoop() != nullptr && only_reads(loop->getParentLoop()) &&
+                   !analysis.has_unknown_calls(loop->getParentLoop(), ignored_calls))
+            {
+                loop = loop->getParentLoop();
+            }
 
-                        std::vector<Value *> args = {void_ptr, void_ptr};
+            std::pair<Instruction *, Loop *> read_loop = {base_inst, loop};
+            if (std::find(read_loops.begin(), read_loops.end(), read_loop) == read_loops.end())
+            {
+                read_loops.push_back(read_loop);
+            }
+        }
 
-                        builder.SetInsertPoint(load);
-                        builder.CreateCall(runtime.functions.shared_value_load, args);
-                    }
+        for (auto &read_loop : read_loops)
+        {
+            Instruction *base_inst = read_loop.first;
+            BasicBlock *header = read_loop.second->getHeader();
+            BasicBlock *predecessor = read_loop.second->getLoopPredecessor();
+            Instruction *insert_point = predecessor->getTerminator();
+            int reader = -1;
+
+            // Look for the innermost branch on the rank that decides whether the loop is
+            // executed
+            bool skip = false;
+            for (auto *node = dominator_tree.getNode(predecessor); node != nullptr;
+                 node = node->getIDom())
+            {
+                BasicBlock *rank_successor;
+                Instruction *terminator = node->getBlock()->getTerminator();
+                int rank = get_rank_condition(terminator, runtime, &rank_successor);
+                if (rank < 0)
+                {
+                    continue;
                 }
 
-                // synchronize shared value at the end of the microtask
-                auto return_instructions =
-                    get_instruction_in_function<ReturnInst>(microtask->get_function());
-                for (auto &ret : return_instructions)
+                BasicBlock *other_successor = rank_successor == terminator->getSuccessor(0)
+                                                  ? terminator->getSuccessor(1)
+                                                  : terminator->getSuccessor(0);
+                if (dominator_tree.dominates(BasicBlockEdge(node->getBlock(), rank_successor),
+                                             header))
                 {
-                    builder.SetInsertPoint(ret);
-                    builder.CreateCall(runtime.functions.shared_value_synchronize, void_ptr);
+                    reader = rank;
+                    insert_point = terminator;
+                    break;
+                }
+                if (dominator_tree.dominates(
+                        BasicBlockEdge(node->getBlock(), other_successor), header))
+                {
+                    // Only the other processes execute the loop
+                    skip = true;
+                    break;
                 }
             }
-        }
 
-        std::vector<std::vector<Value *>> paths;
-        for (auto *pointer_var : shared_pointer_variables)
-        {
-            for (auto *user : pointer_var->users())
+            if (skip || !dominator_tree.dominates(base_inst, insert_point))
             {
-                Debug(errs() << "USER: ";);
-                Debug(user->dump(););
-                UserTree T(user);
-                auto tmp_paths = T.get_all_paths();
-                paths.insert(paths.end(), tmp_paths.begin(), tmp_paths.end());
+                continue;
             }
+
+            Debug(errs() << "Inserting snapshot for sequential loads in loop "
+                         << read_loop.second->getHeader()->getName() << " for reader "
+                         << reader << "\n";);
+
+            builder.SetInsertPoint(insert_point);
+            Value *void_base_ptr = builder.CreateBitCast(base_inst, Type::getInt8PtrTy(Ctx));
+            builder.CreateCall(runtime.functions.shared_memory_sequential_snapshot,
+                               {void_base_ptr, builder.getInt32(reader)});
         }
+    }
+}
 
-        for (auto &path : paths)
+/**
+ * Looks for loads and stores on 1D shared memory objects inside the loops of the given
+ * microtask function, whose index is incremented by one in every loop iteration.
+ * Instead of transferring each element on its own, the accessed range is copied into a
+ * local buffer in front of the loop with one call to shared_memory_load_range, or written
+ * back from a local buffer behind the loop with one call to shared_memory_store_range.
+ * Inside the loop the accesses are redirected to the local buffer.
+ *
+ * Loads are only replaced if the shared memory object is not written in the same loop and
+ * stores only if they are the single access to the shared memory object in the loop.
+ * All replaced accesses are removed from load_paths and store_paths.
+ **/
+void CatoPass::replace_contiguous_loop_accesses(
+    Module &M, RuntimeHandler &runtime, Function *function,
+    std::vector<std::pair<int, std::vector<Value *>>> &load_paths,
+    std::vector<std::pair<int, std::vector<Value *>>> &store_paths)
+{
+    struct RangeAccess
+    {
+        Instruction *access;
+        Value *index;
+    };
+
+    struct RangeGroup
+    {
+        Value *base_ptr;
+        Type *type;
+        ContiguousAccess range;
+        long min_distance;
+        long max_distance;
+        std::vector<RangeAccess> accesses;
+        Value *start;
+        Value *count;
+        // The loop invariant row index for accesses to a row of a 2D array
+        const SCEV *row_index;
+        Value *row;
+    };
+
+    AccessPatternAnalysis analysis(function);
+    DominatorTree &dominator_tree = analysis.get_dominator_tree();
+    IRBuilder<> builder(M.getContext());
+    LLVMContext &Ctx = M.getContext();
+
+    // Calls to the runtime library inside of a loop that can not access the shared
+    // memory objects
+    std::set<Function *> ignored_calls = {runtime.functions.shared_value_load,
+                                          runtime.functions.shared_value_store};
+
+    // Checks if the access of the given path can be handled by a range transfer. Besides
+    // 1D accesses, accesses to one row of a 2D array are supported if the row index does
+    // not change inside of the loop. The row index is written to row_index.
+    auto find_range_access = [&](std::pair<int, std::vector<Value *>> &p,
+                                 std::vector<Value *> &indices, ContiguousAccess *range,
+                                 const SCEV **row_index) {
+        auto *inst = dyn_cast<Instruction>(p.second[p.first]);
+        auto *base_inst = dyn_cast<Instruction>(p.second[0]);
+        if (inst->getFunction() != function || base_inst == nullptr ||
+            base_inst->getFunction() != function)
         {
-            Debug(errs() << "MICROTASK PATH:\n";);
-            for (auto &u : path)
+            return false;
+        }
+
+        if ((indices.size() != 2 && indices.size() != 3) ||
+            !analysis.get_contiguous_access(inst, indices.back(), range))
+        {
+            return false;
+        }
+
+        Loop *loop = range->loop;
+        *row_index = nullptr;
+        if (indices.size() == 3)
+        {
+            *row_index = analysis.get_loop_invariant_index(indices[1], loop);
+            if (*row_index == nullptr || !analysis.is_expandable(*row_index, loop))
             {
-                Debug(u->dump(););
+                return false;
             }
-            Debug(errs() << "MICROTASK PATH END\n";);
         }
 
-        Debug(errs() << "========================================\n";);
+        Instruction *preheader_end = loop->getLoopPreheader()->getTerminator();
+        return dominator_tree.dominates(base_inst, preheader_end) &&
+               !analysis.has_unknown_calls(loop, ignored_calls) &&
+               analysis.is_expandable(range->start, loop) &&
+               analysis.is_expandable(range->count, loop);
+    };
 
-        std::vector<std::pair<int, std::vector<Value *>>> store_paths, load_paths,
-            ptr_store_paths;
-        std::vector<std::vector<Value *>> free_paths;
+    std::vector<RangeGroup> load_groups, store_groups;
+
+    for (auto &p : load_paths)
+    {
+        auto *load = dyn_cast<LoadInst>(p.second[p.first]);
+        if (load->getFunction() != function)
+        {
+            continue;
+        }
+
+        std::vector<Value *> indices = get_memory_access_indices<LoadInst>(M, p);
+        ContiguousAccess range;
+        const SCEV *row_index;
+        if (!find_range_access(p, indices, &range, &row_index) ||
+            count_accesses_in_loop(store_paths, get_shared_variable(p.second), range.loop) > 0)
+        {
+            continue;
+        }
+
+        // Loads with a constant distance to each other, like in stencil computations,
+        // share one buffer that covers all of them
+        RangeGroup *group = nullptr;
+        long distance = 0;
+        for (auto &g : load_groups)
+        {
+            if (g.base_ptr == p.second[0] && g.type == load->getType() &&
+                g.range.loop == range.loop && g.row_index == row_index &&
+                analysis.get_constant_distance(range.start, g.range.start, &distance))
+            {
+                group = &g;
+                break;
+            }
+        }
+
+        if (group == nullptr)
+        {
+            load_groups.push_back({p.second[0], load->getType(), range, 0, 0, {}, nullptr,
+                                   nullptr, row_index, nullptr});
+            group = &load_groups.back();
+            distance = 0;
+        }
+        group->min_distance = std::min(group->min_distance, distance);
+        group->max_distance = std::max(group->max_distance, distance);
+        group->accesses.push_back({load, indices.back()});
+    }
+
+    for (auto &p : store_paths)
+    {
+        auto *store = dyn_cast<StoreInst>(p.second[p.first]);
+        if (store->getFunction() != function)
+        {
+            continue;
+        }
+
+        std::vector<Value *> indices = get_memory_access_indices<StoreInst>(M, p);
+        ContiguousAccess range;
+        const SCEV *row_index;
+        Value *shared_variable = get_shared_variable(p.second);
+        if (!find_range_access(p, indices, &range, &row_index) ||
+            count_accesses_in_loop(load_paths, shared_variable, range.loop) > 0 ||
+            count_accesses_in_loop(store_paths, shared_variable, range.loop) > 1)
+        {
+            continue;
+        }
+
+        store_groups.push_back({p.second[0],
+                                store->getValueOperand()->getType(),
+                                range,
+                                0,
+                                0,
+                                {{store, indices.back()}},
+                                nullptr,
+                                nullptr,
+                                row_index,
+                                nullptr});
+    }
+
+    // Materialize all range bounds before the IR gets modified
+    for (auto *groups : {&load_groups, &store_groups})
+    {
+        for (auto &group : *groups)
+        {
+            group.start = analysis.expand_in_preheader(group.range.start, group.min_distance,
+                                                       group.range.loop);
+            group.count = analysis.expand_in_preheader(
+                group.range.count, group.max_distance - group.min_distance, group.range.loop);
+            if (group.row_index != nullptr)
+            {
+                group.row =
+                    analysis.expand_in_preheader(group.row_index, 0, group.range.loop);
+            }
+        }
+    }
+
+    std::set<Value *> replaced_accesses;
+    std::map<Loop *, BasicBlock *> exit_blocks;
+
+    for (auto *groups : {&load_groups, &store_groups})
+    {
+        bool is_load = groups == &load_groups;
+        for (auto &group : *groups)
+        {
+            Loop *loop = group.range.loop;
+            Instruction *preheader_end = loop->getLoopPreheader()->getTerminator();
+
+            // The code behind the loop must only run if the loop was entered, so the exit
+            // edge is split if the exit block can also be reached from somewhere else
+            if (exit_blocks.find(loop) == exit_blocks.end())
+            {
+                BasicBlock *exit = group.range.exit;
+                if (exit->getSinglePredecessor() != group.range.latch)
+                {
+                    exit = SplitEdge(group.range.latch, exit);
+                }
+                exit_blocks[loop] = exit;
+            }
+            Instruction *exit_begin = &*exit_blocks[loop]->getFirstInsertionPt();
+
+            Debug(errs() << "Replacing contiguous " << (is_load ? "loads" : "store")
+                         << " in loop " << loop->getHeader()->getName() << " with a range "
+                         << (is_load ? "load" : "store") << "\n";);
+
+            builder.SetInsertPoint(preheader_end);
+            Instruction *buffer = CallInst::CreateMalloc(
+                preheader_end, builder.getInt64Ty(), group.type,
+                builder.getInt64(M.getDataLayout().getTypeAllocSize(group.type)), group.count,
+                nullptr, "cato.range.buffer");
+            Value *void_base_ptr =
+                builder.CreateBitCast(group.base_ptr, Type::getInt8PtrTy(Ctx));
+            Value *void_buffer = builder.CreateBitCast(buffer, Type::getInt8PtrTy(Ctx));
+            std::vector<Value *> args = {void_base_ptr, void_buffer, group.start, group.count};
+            Function *load_range = runtime.functions.shared_memory_load_range;
+            Function *store_range = runtime.functions.shared_memory_store_range;
+            if (group.row != nullptr)
+            {
+                // The range lies inside of one row, which is transferred from its owner
+                args.insert(args.begin() + 2, group.row);
+                load_range = runtime.functions.shared_memory_load_range_2d;
+                store_range = runtime.functions.shared_memory_store_range_2d;
+            }
+
+            if (is_load)
+            {
+                builder.CreateCall(load_range, args);
+            }
+
+            for (auto &range_access : group.accesses)
+            {
+                builder.SetInsertPoint(range_access.access);
+                Value *index =
+                    builder.CreateSExtOrTrunc(range_access.index, builder.getInt64Ty());
+                Value *buffer_ptr = builder.CreateInBoundsGEP(
+                    group.type, buffer, builder.CreateSub(index, group.start));
+
+                if (auto *load = dyn_cast<LoadInst>(range_access.access))
+                {
+                    LoadInst *new_load = builder.CreateLoad(group.type, buffer_ptr);
+                    load->replaceAllUsesWith(new_load);
+                }
+                else if (auto *store = dyn_cast<StoreInst>(range_access.access))
+                {
+                    builder.CreateStore(store->getValueOperand(), buffer_ptr);
+                }
+                replaced_accesses.insert(range_access.access);
+                range_access.access->eraseFromParent();
+            }
+
+            builder.SetInsertPoint(exit_begin);
+            if (!is_load)
+            {
+                builder.CreateCall(store_range, args);
+            }
+            CallInst::CreateFree(buffer, exit_begin);
+        }
+    }
+
+    auto is_replaced = [&](std::pair<int, std::vector<Value *>> &p) {
+        return replaced_accesses.find(p.second[p.first]) != replaced_accesses.end();
+    };
+    load_paths.erase(std::remove_if(load_paths.begin(), load_paths.end(), is_replaced),
+                     load_paths.end());
+    store_paths.erase(std::remove_if(store_paths.begin(), store_paths.end(), is_replaced),
+                      store_paths.end());
+}
+
+/**
+ * Chooses the shared memory object that each worksharing loop of the microtask gets
+ * aligned with. The accesses whose (outermost) index is the iteration variable plus a
+ * constant are counted for each shared pointer variable and offset, and the one with the
+ * most stores (then loads) is written to the ParallelForData of the loop. With that,
+ * replace_parallel_for gives each process the iterations whose data it stores.
+ **/
+void CatoPass::find_owner_aligned_accesses(
+    Module &M, Microtask &microtask,
+    std::vector<std::pair<int, std::vector<Value *>>> &load_paths,
+    std::vector<std::pair<int, std::vector<Value *>>> &store_paths)
+{
+    Function *function = microtask.get_function();
+    std::vector<ParallelForData> *parallel_for_data = microtask.get_parallel_for();
+    if (parallel_for_data == nullptr)
+    {
+        return;
+    }
+
+    AccessPatternAnalysis analysis(function);
+
+    // The base pointer is loaded again in front of the loop, so the shared variable has
+    // to be an argument of the microtask that is never overwritten
+    auto get_owner_variable = [&](std::vector<Value *> &path) -> Value * {
+        auto *argument = dyn_cast<Argument>(get_shared_variable(path));
+        if (argument == nullptr || argument->getParent() != function ||
+            !isa<LoadInst>(path[0]))
+        {
+            return nullptr;
+        }
+        for (auto *user : argument->users())
+        {
+            if (isa<StoreInst>(user))
+            {
+                return nullptr;
+            }
+        }
+        return argument;
+    };
+
+    for (auto &parallel_for : *parallel_for_data)
+    {
+        // Number of stores and loads for each shared variable and offset
+        std::map<std::pair<Value *, long>, std::pair<int, int>> counts;
+
+        auto count_access = [&](std::pair<int, std::vector<Value *>> &p,
+                                std::vector<Value *> indices, bool is_store) {
+            auto *access = cast<Instruction>(p.second[p.first]);
+            Value *owner_variable = get_owner_variable(p.second);
+            if (access->getFunction() != function || owner_variable == nullptr ||
+                indices.size() < 2)
+            {
+                return;
+            }
+
+            long offset;
+            const Loop *loop = analysis.get_offset_to_loaded_start(
+                indices[1], parallel_for.init->getArgOperand(4), &offset);
+            if (loop == nullptr || !loop->contains(access))
+            {
+                return;
+            }
+
+            auto &count = counts[{owner_variable, offset}];
+            if (is_store)
+            {
+                count.first++;
+            }
+            else
+            {
+                count.second++;
+            }
+        };
+
+        for (auto &p : store_paths)
+        {
+            count_access(p, get_memory_access_indices<StoreInst>(M, p), true);
+        }
+        for (auto &p : load_paths)
+        {
+            count_access(p, get_memory_access_indices<LoadInst>(M, p), false);
+        }
+
+        // On a tie the offset closest to zero is used, which is the center of a stencil
+        auto rank = [](auto &entry) {
+            return std::make_tuple(entry.second.first, entry.second.second,
+                                   -std::abs(entry.first.second));
+        };
+        auto best = std::max_element(counts.begin(), counts.end(),
+                                     [&](auto &a, auto &b) { return rank(a) < rank(b); });
+        if (best != counts.end())
+        {
+            Debug(errs() << "Aligning parallel for loop with offset " << best->first.second
+                         << " to the shared variable: ";);
+            Debug(best->first.first->dump(););
+            parallel_for.owner_variable = best->first.first;
+            parallel_for.owner_offset = best->first.second;
+        }
+    }
+}
+
+/**
+ * Looks for loads in the worksharing loops of the microtask, whose (row) index is the
+ * iteration variable plus a constant, like the neighbour accesses of a stencil.
+ * If the shared memory object is not modified in the microtask, all elements (rows) that
+ * the process reads in the loop are fetched into ghost cells in front of the loop with one
+ * call to shared_memory_exchange_halo, so the loads at the borders of the partition are
+ * served locally.
+ *
+ * modified_variables are the shared variables that are stored to in the microtask.
+ **/
+void CatoPass::insert_halo_exchanges(
+    Module &M, RuntimeHandler &runtime, Microtask &microtask,
+    std::vector<std::pair<int, std::vector<Value *>>> &load_paths,
+    std::set<Value *> &modified_variables)
+{
+    struct HaloGroup
+    {
+        Value *base_ptr;
+        const Loop *loop;
+        CallInst *init;
+        long min_offset;
+        long max_offset;
+    };
+
+    Function *function = microtask.get_function();
+    std::vector<ParallelForData> *parallel_for_data = microtask.get_parallel_for();
+    if (parallel_for_data == nullptr)
+    {
+        return;
+    }
+
+    AccessPatternAnalysis analysis(function);
+    DominatorTree &dominator_tree = analysis.get_dominator_tree();
+    std::vector<HaloGroup> groups;
+
+    for (auto &p : load_paths)
+    {
+        auto *load = cast<LoadInst>(p.second[p.first]);
+        auto *base_ptr = dyn_cast<Instruction>(p.second[0]);
+        if (load->getFunction() != function || base_ptr == nullptr ||
+            base_ptr->getFunction() != function ||
+            modified_variables.count(get_shared_variable(p.second)) > 0)
+        {
+            continue;
+        }
+
+        std::vector<Value *> indices = get_memory_access_indices<LoadInst>(M, p);
+        if (indices.size() < 2 || indices.size() > 3)
+        {
+            continue;
+        }
+
+        for (auto &parallel_for : *parallel_for_data)
+        {
+            long offset;
+            const Loop *loop = analysis.get_offset_to_loaded_start(
+                indices[1], parallel_for.init->getArgOperand(4), &offset);
+            if (loop == nullptr || !loop->contains(load) ||
+                !dominator_tree.dominates(base_ptr, loop->getLoopPreheader()->getTerminator()))
+            {
+                continue;
+            }
+
+            auto group = std::find_if(groups.begin(), groups.end(), [&](HaloGroup &g) {
+                return g.base_ptr == base_ptr && g.loop == loop;
+            });
+            if (group == groups.end())
+            {
+                groups.push_back({base_ptr, loop, parallel_for.init, offset, offset});
+            }
+            else
+            {
+                group->min_offset = std::min(group->min_offset, offset);
+                group->max_offset = std::max(group->max_offset, offset);
+            }
+            break;
+        }
+    }
+
+    IRBuilder<> builder(M.getContext());
+    Type *i64_type = builder.getInt64Ty();
+    for (auto &group : groups)
+    {
+        // Only accesses to the neighbours can be located at another process
+        if (group.min_offset == 0 && group.max_offset == 0)
+        {
+            continue;
+        }
+
+        Debug(errs() << "Inserting halo exchange for the shared memory object: ";);
+        Debug(group.base_ptr->dump(););
+
+        builder.SetInsertPoint(group.loop->getLoopPreheader()->getTerminator());
+        Value *lower_ptr = group.init->getArgOperand(4);
+        Value *upper_ptr = group.init->getArgOperand(5);
+        Value *lower = builder.CreateSExt(
+            builder.CreateLoad(lower_ptr->getType()->getPointerElementType(), lower_ptr),
+            i64_type);
+        Value *upper = builder.CreateSExt(
+            builder.CreateLoad(upper_ptr->getType()->getPointerElementType(), upper_ptr),
+            i64_type);
+        Value *first = builder.CreateAdd(lower, builder.getInt64(group.min_offset));
+        Value *last = builder.CreateAdd(upper, builder.getInt64(group.max_offset));
+        Value *void_ptr = builder.CreateBitCast(group.base_ptr, builder.getInt8PtrTy());
+        builder.CreateCall(runtime.functions.shared_memory_exchange_halo,
+                           {void_ptr, first, last});
+    }
+}
+
+/**
+ * Replaces an atomicrmw or cmpxchg instruction on shared memory with a call to the CATO
+ *runtime library. args select the accessed memory, the operands of the atomic operation are
+ *passed through new allocas and inserted into args at operand_pos:
+ *      atomicrmw: value, destination of the old value (nullptr if it is unused), BinOp
+ *      cmpxchg: new value, compared value, destination of the old value
+ * MPI has no subtraction, so a subtraction adds the negated value instead.
+ * Returns false and leaves the instruction unchanged if the operation is not supported.
+ **/
+static bool replace_atomic_instruction(Instruction *atomic, RuntimeHandler &runtime,
+                                       Function *rmw_function, Function *cmpxchg_function,
+                                       std::vector<Value *> args, unsigned operand_pos)
+{
+    LLVMContext &Ctx = atomic->getContext();
+    IRBuilder<> builder(atomic->getFunction()->getEntryBlock().getFirstNonPHI());
+
+    Function *function = nullptr;
+    std::vector<Value *> operands;
+    Value *result_ptr = nullptr;
+    Type *type = nullptr;
+
+    if (auto *rmw = dyn_cast<AtomicRMWInst>(atomic))
+    {
+        // The runtime interprets the memory with its own type, so operations through a
+        // bitcast are only possible if they do not depend on the type
+        AtomicRMWInst::BinOp bin_op = rmw->getOperation();
+        if (bin_op == AtomicRMWInst::Nand ||
+            (bin_op != AtomicRMWInst::Xchg && isa<BitCastInst>(rmw->getPointerOperand())))
+        {
+            errs() << "Error: unsupported atomic operation on shared memory:\n";
+            rmw->dump();
+            return false;
+        }
+
+        type = rmw->getValOperand()->getType();
+        Value *value_ptr = builder.CreateAlloca(type);
+        if (!rmw->use_empty())
+        {
+            result_ptr = builder.CreateAlloca(type);
+        }
+
+        builder.SetInsertPoint(rmw);
+        Value *value = rmw->getValOperand();
+        if (bin_op == AtomicRMWInst::Sub)
+        {
+            value = builder.CreateNeg(value);
+            bin_op = AtomicRMWInst::Add;
+        }
+        else if (bin_op == AtomicRMWInst::FSub)
+        {
+            value = builder.CreateFNeg(value);
+            bin_op = AtomicRMWInst::FAdd;
+        }
+        builder.CreateStore(value, value_ptr);
+
+        operands.push_back(builder.CreateBitCast(value_ptr, Type::getInt8PtrTy(Ctx)));
+        operands.push_back(result_ptr != nullptr
+                               ? builder.CreateBitCast(result_ptr, Type::getInt8PtrTy(Ctx))
+                               : ConstantPointerNull::get(Type::getInt8PtrTy(Ctx)));
+        operands.push_back(builder.getInt32(bin_op));
+        function = rmw_function;
+    }
+    else if (auto *cmpxchg = dyn_cast<AtomicCmpXchgInst>(atomic))
+    {
+        type = cmpxchg->getNewValOperand()->getType();
+        Value *value_ptr = builder.CreateAlloca(type);
+        Value *compare_ptr = builder.CreateAlloca(type);
+        result_ptr = builder.CreateAlloca(type);
+
+        builder.SetInsertPoint(cmpxchg);
+        builder.CreateStore(cmpxchg->getNewValOperand(), value_ptr);
+        builder.CreateStore(cmpxchg->getCompareOperand(), compare_ptr);
+
+        operands.push_back(builder.CreateBitCast(value_ptr, Type::getInt8PtrTy(Ctx)));
+        operands.push_back(builder.CreateBitCast(compare_ptr, Type::getInt8PtrTy(Ctx)));
+        operands.push_back(builder.CreateBitCast(result_ptr, Type::getInt8PtrTy(Ctx)));
+        function = cmpxchg_function;
+    }
+    else
+    {
+        return false;
+    }
+
+    args.insert(args.begin() + operand_pos, operands.begin(), operands.end());
+    if (function->isVarArg())
+    {
+        runtime.create_shared_memory_access(builder, function, args);
+    }
+    else
+    {
+        builder.CreateCall(function, args);
+    }
+
+    if (result_ptr != nullptr)
+    {
+        Value *old_value = builder.CreateLoad(type, result_ptr);
+        Value *result = old_value;
+        // cmpxchg returns the old value together with the success of the exchange
+        if (auto *cmpxchg = dyn_cast<AtomicCmpXchgInst>(atomic))
+        {
+            Value *success = builder.CreateICmpEQ(old_value, cmpxchg->getCompareOperand());
+            result = builder.CreateInsertValue(UndefValue::get(cmpxchg->getType()), old_value,
+                                               0);
+            result = builder.CreateInsertValue(result, success, 1);
+        }
+        atomic->replaceAllUsesWith(result);
+    }
+    atomic->eraseFromParent();
+
+    return true;
+}
+
+/**
+ * Looks at all load, store and free instructions that are used on shared memory segments
+ * in Microtasks
+ * The memory allocations for the shared memory segments have to already be done through
+ * the runtime library call 'allocate_shared_memory'.
+ *
+ * The functions creates UserTrees for each shared memory allocation and looks
+ * for store/load instructions on non pointer values (also free memory calls) to the shared
+ * memory object and replaces them by corresponding calls to the cato runtime library.
+ *
+ * Accesses to shared memory outside of Microtasks are not handled by this function.
+ **/
+void CatoPass::replace_microtask_shared_memory_accesses(
+    Module &M, RuntimeHandler &runtime, std::vector<std::unique_ptr<Microtask>> &microtasks)
+{
+    for (auto &microtask : microtasks)
+    {
+        std::vector<Value *> shared_value_variables, shared_pointer_variables,
+            shared_struct_variables;
+
+        for (auto &shared_variable : microtask->get_shared_variables())
+        {
+            if (get_pointer_depth(shared_variable) == 1)
+            {
+                // Special handling for struct shared variables needed
+                if (shared_variable->getType()->getPointerElementType()->isStructTy())
+                {
+                    shared_struct_variables.push_back(shared_variable);
+                    Debug(errs() << "Shared struct variable in Microtask: ";);
+                    Debug(shared_variable->dump(););
+                }
+                else
+                {
+                    shared_value_variables.push_back(shared_variable);
+                    Debug(errs() << "Shared value variable in Microtask: ";);
+                    Debug(shared_variable->dump(););
+                }
+            }
+            else
+            {
+                shared_pointer_variables.push_back(shared_variable);
+                Debug(errs() << "Shared pointer variable in Microtask: ";);
+                Debug(shared_variable->dump(););
+            }
+        }
+
+        // Check if the accessed struct member is a single value or pointer variable
+        for (auto *struct_var : shared_struct_variables)
+        {
+            for (auto *user : struct_var->users())
+            {
+                if (get_pointer_depth(user->getType()) == 1)
+                {
+                    shared_value_variables.push_back(user);
+                }
+                else if (get_pointer_depth(user->getType()) > 1)
+                {
+                    shared_pointer_variables.push_back(user);
+                }
+            }
+        }
+
+        for (auto &single_value_var : shared_value_variables)
+        {
+            Debug(errs() << "Analysing single value shared variable: ";);
+            Debug(single_value_var->dump(););
+
+            // Accesses through a bitcast are type punned accesses, like the integer
+            // accesses of atomic updates of floating point values
+            std::vector<User *> accesses;
+            for (auto *user : single_value_var->users())
+            {
+                if (isa<BitCastInst>(user))
+                {
+                    accesses.insert(accesses.end(), user->user_begin(), user->user_end());
+                }
+                else
+                {
+                    accesses.push_back(user);
+                }
+            }
+
+            // Check for stores to the shared value.
+            // If it is not modified in the microtask we don't need
+            // to create a memory abstraction for it.
+            bool has_stores = false;
+            for (auto *user : accesses)
+            {
+                if (isa<StoreInst>(user) || isa<AtomicRMWInst>(user) ||
+                    isa<AtomicCmpXchgInst>(user))
+                {
+                    has_stores = true;
+                    break;
+                }
+            }
+
+            if (has_stores)
+            {
+                IRBuilder<> builder(M.getContext());
+                LLVMContext &Ctx = M.getContext();
+                builder.SetInsertPoint(
+                    microtask->get_function()->getEntryBlock().getFirstNonPHI());
+
+                Value *void_ptr = nullptr;
+                // If this is a GEP that means we are working with a struct
+                // and the base pointer to the single value shared var has to
+                // be declared at the beginning of the function
+                // for the mpi window to be created
+                if (auto *gep = dyn_cast<GetElementPtrInst>(single_value_var))
+                {
+                    auto *new_gep =
+                        builder.CreateGEP(nullptr, gep->getPointerOperand(),
+                                          {gep->getOperand(1), gep->getOperand(2)});
+                    void_ptr = builder.CreateBitCast(new_gep, Type::getInt8PtrTy(Ctx));
+                }
+                else
+                {
+                    void_ptr =
+                        builder.CreateBitCast(single_value_var, Type::getInt8PtrTy(Ctx));
+                }
+                Type *type = single_value_var->getType();
+
+                std::vector<Value *> args = {void_ptr,
+                                             builder.getInt32(get_mpi_datatype(type))};
+
+                builder.CreateCall(runtime.functions.allocate_shared_value, args);
+
+                // Find all store and load instructions on the shared value
+
+                Debug(errs() << "Users for shared value:\n";);
+                for (auto *user : accesses)
+                {
+                    if (auto *store = dyn_cast<StoreInst>(user))
+                    {
+                        Debug(errs() << "Replacing store instruction for shared value: ";);
+                        Debug(store->dump(););
+
+                        builder.SetInsertPoint(
+                            store->getFunction()->getEntryBlock().getFirstNonPHI());
+                        Value *store_value =
+                            builder.CreateAlloca(store->getValueOperand()->getType());
+                        builder.SetInsertPoint(store);
+                        builder.CreateStore(store->getOperand(0), store_value);
+                        Value *store_value_ptr =
+                            builder.CreateBitCast(store_value, Type::getInt8PtrTy(Ctx));
+
+                        std::vector<Value *> args = {void_ptr, store_value_ptr};
+
+                        Value *new_store_call =
+                            builder.CreateCall(runtime.functions.shared_value_store, args);
+                        store->replaceAllUsesWith(new_store_call);
+                        store->eraseFromParent();
+                    }
+                    else if (auto *load = dyn_cast<LoadInst>(user))
+                    {
+                        Debug(errs() << "Replacing load instruction for shared value: ";);
+                        Debug(load->dump(););
+
+                        std::vector<Value *> args = {void_ptr, void_ptr};
+
+                        builder.SetInsertPoint(load);
+                        builder.CreateCall(runtime.functions.shared_value_load, args);
+                    }
+                    else if (isa<AtomicRMWInst>(user) || isa<AtomicCmpXchgInst>(user))
+                    {
+                        Debug(errs() << "Replacing atomic instruction for shared value: ";);
+                        Debug(user->dump(););
+
+                        replace_atomic_instruction(
+                            cast<Instruction>(user), runtime,
+                            runtime.functions.shared_value_fetch_and_op,
+                            runtime.functions.shared_value_compare_and_swap, {void_ptr}, 1);
+                    }
+                }
+
+                // synchronize shared value at the end of the microtask
+                auto return_instructions =
+                    get_instruction_in_function<ReturnInst>(microtask->get_function());
+                for (auto &ret : return_instructions)
+                {
+                    builder.SetInsertPoint(ret);
+                    builder.CreateCall(runtime.functions.shared_value_synchronize, void_ptr);
+                }
+            }
+        }
+
+        std::vector<std::vector<Value *>> paths;
+        for (auto *pointer_var : shared_pointer_variables)
+        {
+            for (auto *user : pointer_var->users())
+            {
+                Debug(errs() << "USER: ";);
+                Debug(user->dump(););
+                UserTree T(user);
+                auto tmp_paths = T.get_all_paths();
+                paths.insert(paths.end(), tmp_paths.begin(), tmp_paths.end());
+            }
+        }
+
+        for (auto &path : paths)
+        {
+            Debug(errs() << "MICROTASK PATH:\n";);
+            for (auto &u : path)
+            {
+                Debug(u->dump(););
+            }
+            Debug(errs() << "MICROTASK PATH END\n";);
+        }
+
+        Debug(errs() << "========================================\n";);
+
+        std::vector<std::pair<int, std::vector<Value *>>> store_paths, load_paths,
+            ptr_store_paths, atomic_paths;
+        std::vector<std::vector<Value *>> free_paths;
 
         categorize_memory_access_paths(paths, &store_paths, &load_paths, &ptr_store_paths,
-                                       &free_paths);
+                                       &free_paths, &atomic_paths);
+
+        std::set<Value *> modified_variables;
+        for (auto &p : store_paths)
+        {
+            modified_variables.insert(get_shared_variable(p.second));
+        }
+        for (auto &p : atomic_paths)
+        {
+            modified_variables.insert(get_shared_variable(p.second));
+        }
+
+        find_owner_aligned_accesses(M, *microtask, load_paths, store_paths);
+
+        replace_contiguous_loop_accesses(M, runtime, microtask->get_function(), load_paths,
+                                         store_paths);
+
+        insert_halo_exchanges(M, runtime, *microtask, load_paths, modified_variables);
 
         IRBuilder<> builder(M.getContext());
         LLVMContext &Ctx = M.getContext();
-        // Now we need to find the offsets of the shared memory accesses
-        // Currently only 1D and 2D arrays/pointers are supported
-        for (auto &p : load_paths)
-        {
-            auto &path = p.second;
-            auto *load = dyn_cast<LoadInst>(path[p.first]);
 
-            // Get a vector of the number of indices followed by the indices for
-            // the memory access on the shared memory object
-            std::vector<Value *> args = get_memory_access_indices<LoadInst>(M, p);
+        // The shared memory object of each base pointer value is only looked up once,
+        // right after the base pointer is available. The loads and stores get the
+        // resulting handle instead of the base pointer.
+        std::map<Value *, Value *> handles;
+        auto get_handle = [&](Value *base_ptr) {
+            if (handles.find(base_ptr) == handles.end())
+            {
+                if (auto *argument = dyn_cast<Argument>(base_ptr))
+                {
+                    builder.SetInsertPoint(
+                        &*argument->getParent()->getEntryBlock().getFirstInsertionPt());
+                }
+                else if (isa<PHINode>(base_ptr))
+                {
+                    builder.SetInsertPoint(
+                        &*cast<Instruction>(base_ptr)->getParent()->getFirstInsertionPt());
+                }
+                else
+                {
+                    builder.SetInsertPoint(cast<Instruction>(base_ptr)->getNextNode());
+                }
+                Value *void_ptr = builder.CreateBitCast(base_ptr, Type::getInt8PtrTy(Ctx));
+                handles[base_ptr] =
+                    builder.CreateCall(runtime.functions.shared_memory_handle, void_ptr);
+            }
+            return handles[base_ptr];
+        };
 
-            // Find the correct value for the base pointer.
-            // If the allocate call is not in the same function as the load
-            // the base pointer value has to be the argument value from the current
-            // function.
-            Function *current_func = load->getFunction();
+        // Find the correct value for the base pointer of the access in a categorized path.
+        // If the allocate call is not in the same function as the access the base pointer
+        // value has to be the argument value from the current function.
+        auto get_path_handle = [&](std::pair<int, std::vector<Value *>> &p) -> Value * {
+            auto &path = p.second;
+            Function *current_func = cast<Instruction>(path[p.first])->getFunction();
             if (dyn_cast<Instruction>(path[0])->getFunction() != current_func)
             {
                 for (int i = p.first; i > 0; i--)
@@ -1312,19 +2428,28 @@ void CatoPass::replace_microtask_shared_memory_accesses(
                             }
                         }
 
-                        builder.SetInsertPoint(load);
-                        Value *void_ptr =
-                            builder.CreateBitCast(matching_argument, Type::getInt8PtrTy(Ctx));
-                        args.insert(args.begin(), void_ptr);
-                        break;
+                        return get_handle(matching_argument);
                     }
                 }
+                return nullptr;
             }
-            else
+            return get_handle(path[0]);
+        };
+        // Now we need to find the offsets of the shared memory accesses
+        // Currently only 1D and 2D arrays/pointers are supported
+        for (auto &p : load_paths)
+        {
+            auto &path = p.second;
+            auto *load = dyn_cast<LoadInst>(path[p.first]);
+
+            // Get a vector of the number of indices followed by the indices for
+            // the memory access on the shared memory object
+            std::vector<Value *> args = get_memory_access_indices<LoadInst>(M, p);
+
+            Value *handle = get_path_handle(p);
+            if (handle != nullptr)
             {
-                builder.SetInsertPoint(load);
-                Value *void_ptr = builder.CreateBitCast(path[0], Type::getInt8PtrTy(Ctx));
-                args.insert(args.begin(), void_ptr);
+                args.insert(args.begin(), handle);
             }
 
             // Do the actual replacement of the load instruction with a call to the cato
@@ -1336,11 +2461,11 @@ void CatoPass::replace_microtask_shared_memory_accesses(
                 builder.SetInsertPoint(load);
                 Value *void_ptr = builder.CreateBitCast(load_value, Type::getInt8PtrTy(Ctx));
                 args.insert(args.begin() + 1, void_ptr);
-                CallInst *load_call =
-                    builder.CreateCall(runtime.functions.shared_memory_load, args);
+                CallInst *load_call = runtime.create_shared_memory_access(
+                    builder, runtime.functions.shared_memory_load_with_handle, args);
                 Value *bitcast =
                     builder.CreateBitCast(void_ptr, load->getPointerOperandType());
-                LoadInst *new_load = builder.CreateLoad(bitcast->getType(), bitcast);
+                LoadInst *new_load = builder.CreateLoad(load->getType(), bitcast);
                 load->replaceAllUsesWith(new_load);
                 load->eraseFromParent();
             }
@@ -1357,51 +2482,10 @@ void CatoPass::replace_microtask_shared_memory_accesses(
             // the memory access on the shared memory object
             std::vector<Value *> args = get_memory_access_indices<StoreInst>(M, p);
 
-            // Find the correct value for the base pointer.
-            // If the allocate call is not in the same function as the load
-            // the base pointer value has to be the argument value from the current
-            // function.
-            Function *current_func = store->getFunction();
-            if (dyn_cast<Instruction>(path[0])->getFunction() != current_func)
-            {
-                for (int i = p.first; i > 0; i--)
-                {
-                    if (auto *call_inst = dyn_cast<CallInst>(path[i]))
-                    {
-                        errs() << "   CallInst: ";
-                        call_inst->dump();
-
-                        // Identify the argument argument of the current function that is
-                        // the shared memory object
-                        auto *last_inst = path[i - 1];
-                        Value *matching_argument = nullptr;
-
-                        for (unsigned int j = 0; j < call_inst->arg_size(); j++)
-                        {
-                            if (last_inst == call_inst->getArgOperand(j))
-                            {
-                                Function *called_function = call_inst->getCalledFunction();
-                                if (called_function->arg_begin() + j <
-                                    called_function->arg_end())
-                                {
-                                    matching_argument = called_function->arg_begin() + j;
-                                }
-                            }
-                        }
-
-                        builder.SetInsertPoint(store);
-                        Value *void_ptr =
-                            builder.CreateBitCast(matching_argument, Type::getInt8PtrTy(Ctx));
-                        args.insert(args.begin(), void_ptr);
-                        break;
-                    }
-                }
-            }
-            else
+            Value *handle = get_path_handle(p);
+            if (handle != nullptr)
             {
-                builder.SetInsertPoint(store);
-                Value *void_ptr = builder.CreateBitCast(path[0], Type::getInt8PtrTy(Ctx));
-                args.insert(args.begin(), void_ptr);
+                args.insert(args.begin(), handle);
             }
 
             // Do the acutal replacement of the load instruction with a call to the cato
@@ -1417,13 +2501,37 @@ void CatoPass::replace_microtask_shared_memory_accesses(
                 builder.CreateStore(store->getOperand(0), store_value);
                 Value *void_ptr = builder.CreateBitCast(store_value, Type::getInt8PtrTy(Ctx));
                 args.insert(args.begin() + 1, void_ptr);
-                Value *new_store_call =
-                    builder.CreateCall(runtime.functions.shared_memory_store, args);
+                Value *new_store_call = runtime.create_shared_memory_access(
+                    builder, runtime.functions.shared_memory_store_with_handle, args);
                 store->replaceAllUsesWith(new_store_call);
                 store->eraseFromParent();
             }
         }
 
+        // OpenMP atomic constructs on elements of the shared memory become MPI atomic
+        // operations on the element
+        for (auto &p : atomic_paths)
+        {
+            auto *atomic = cast<Instruction>(p.second[p.first]);
+            std::vector<Value *> args =
+                isa<AtomicRMWInst>(atomic)
+                    ? get_memory_access_indices<AtomicRMWInst>(M, p)
+                    : get_memory_access_indices<AtomicCmpXchgInst>(M, p);
+
+            Value *handle = get_path_handle(p);
+            if (handle != nullptr)
+            {
+                args.insert(args.begin(), handle);
+            }
+
+            if (args.size() >= 3)
+            {
+                replace_atomic_instruction(
+                    atomic, runtime, runtime.functions.shared_memory_atomic_with_handle,
+                    runtime.functions.shared_memory_compare_and_swap_with_handle, args, 1);
+            }
+        }
+
         // Replace freeing of shared memory with corresponding call to the cato runtime
         // library
         for (auto &path : free_paths)
@@ -1503,9 +2611,14 @@ void CatoPass::replace_fork_calls(Module &M, RuntimeHandler &runtime,
                 args.push_back(fork_call_inst->getArgOperand(3 + i));
             }
 
-            // Replace the fork_call with a direct call to the microtask function
+            // Replace the fork_call with a direct call to the microtask function.
+            // The shared memory accesses of the microtask all happen inside of one
+            // passive target epoch. The barrier is removed again by
+            // remove_redundant_barriers if no process can observe these accesses.
             builder.SetInsertPoint(fork_call_inst);
+            builder.CreateCall(runtime.functions.shared_memory_epoch_begin);
             builder.CreateCall(microtask->get_function(), args);
+            builder.CreateCall(runtime.functions.shared_memory_epoch_end);
             builder.CreateCall(runtime.functions.mpi_barrier);
             fork_call_inst->eraseFromParent();
         }
@@ -1545,6 +2658,8 @@ void CatoPass::replace_memory_allocations(Module &M, RuntimeHandler &runtime)
  * This function goes through all Microtasks and modifies the existing parallel for loops
  *for the use with MPI. To achieve this the lower- and upper-bound values of the for loops
  *are modified for each MPI process.
+ * Loops with a dynamic, guided or runtime schedule keep their structure, their chunks are
+ * handed out by the CATO Runtime Library through a global iteration counter instead.
  **/
 void CatoPass::replace_parallel_for(Module &M, RuntimeHandler &runtime,
                                     std::vector<std::unique_ptr<Microtask>> &microtasks)
@@ -1585,34 +2700,455 @@ void CatoPass::replace_parallel_for(Module &M, RuntimeHandler &runtime,
 
                 std::vector<Value *> args = {lower_bound, upper_bound, increment};
 
+                // The _4u and _8u variants are used for unsigned iteration variables, which
+                // is not visible in the types of the bounds
+                bool is_unsigned =
+                    parallel_for_data.init->getCalledFunction()->getName().endswith("u");
+                bool is_64_bit = lower_bound->getType() == Type::getInt64PtrTy(Ctx);
+
                 // Modify the lower and upper bound values
-                CallInst *new_call = nullptr;
-                if (lower_bound->getType() == Type::getInt32PtrTy(Ctx))
+                external_functions &functions = runtime.functions;
+                Function *modify_function = nullptr;
+                if (Value *owner_variable = parallel_for_data.owner_variable)
+                {
+                    // Distribute the iterations like the memory the loop works on
+                    Value *base_ptr = builder.CreateLoad(
+                        owner_variable->getType()->getPointerElementType(), owner_variable);
+                    args.push_back(builder.CreateBitCast(base_ptr, Type::getInt8PtrTy(Ctx)));
+                    args.push_back(builder.getInt64(parallel_for_data.owner_offset));
+                    if (is_64_bit)
+                    {
+                        modify_function = is_unsigned
+                                              ? functions.modify_parallel_for_bounds_aligned_8u
+                                              : functions.modify_parallel_for_bounds_aligned_8;
+                    }
+                    else
+                    {
+                        modify_function = is_unsigned
+                                              ? functions.modify_parallel_for_bounds_aligned_4u
+                                              : functions.modify_parallel_for_bounds_aligned_4;
+                    }
+                }
+                else if (is_64_bit)
                 {
-                    new_call = builder.CreateCall(
-                        runtime.functions.modify_parallel_for_bounds_4, args);
+                    modify_function = is_unsigned ? functions.modify_parallel_for_bounds_8u
+                                                  : functions.modify_parallel_for_bounds_8;
                 }
-                else if (lower_bound->getType() == Type::getInt64PtrTy(Ctx))
+                else
                 {
-                    new_call = builder.CreateCall(
-                        runtime.functions.modify_parallel_for_bounds_8, args);
+                    modify_function = is_unsigned ? functions.modify_parallel_for_bounds_4u
+                                                  : functions.modify_parallel_for_bounds_4;
                 }
+                CallInst *new_call = builder.CreateCall(modify_function, args);
                 // Replace and remove OpenMP Runtime Library calls
                 parallel_for_data.init->replaceAllUsesWith(new_call);
                 parallel_for_data.init->eraseFromParent();
                 parallel_for_data.fini->eraseFromParent();
             }
         }
+
+        std::vector<DynamicForData> *dynamic_for_data_vec = microtask->get_dynamic_for();
+        if (dynamic_for_data_vec != nullptr)
+        {
+            for (DynamicForData &dynamic_for_data : *dynamic_for_data_vec)
+            {
+                Debug(errs() << "Replacing dynamic parallel for in Microtask.\n";);
+                Debug(errs() << "    ";);
+                Debug(dynamic_for_data.init->dump(););
+
+                // The suffix of the OpenMP function gives the type of the loop variable
+                StringRef suffix =
+                    dynamic_for_data.init->getCalledFunction()->getName().rsplit('_').second;
+                Function *init_function = nullptr;
+                Function *next_function = nullptr;
+                if (suffix == "4")
+                {
+                    init_function = runtime.functions.parallel_for_dispatch_init_4;
+                    next_function = runtime.functions.parallel_for_dispatch_next_4;
+                }
+                else if (suffix == "4u")
+                {
+                    init_function = runtime.functions.parallel_for_dispatch_init_4u;
+                    next_function = runtime.functions.parallel_for_dispatch_next_4u;
+                }
+                else if (suffix == "8")
+                {
+                    init_function = runtime.functions.parallel_for_dispatch_init_8;
+                    next_function = runtime.functions.parallel_for_dispatch_next_8;
+                }
+                else if (suffix == "8u")
+                {
+                    init_function = runtime.functions.parallel_for_dispatch_init_8u;
+                    next_function = runtime.functions.parallel_for_dispatch_next_8u;
+                }
+                else
+                {
+                    errs() << "Unknown dispatch function: "
+                           << dynamic_for_data.init->getCalledFunction()->getName() << "\n";
+                    continue;
+                }
+
+                // __kmpc_dispatch_init(loc, gtid, schedule, lb, ub, stride, chunk)
+                CallInst *init = dynamic_for_data.init;
+                IRBuilder<> builder(init);
+                std::vector<Value *> init_args = {
+                    init->getArgOperand(2), init->getArgOperand(3), init->getArgOperand(4),
+                    init->getArgOperand(5), init->getArgOperand(6)};
+                builder.CreateCall(init_function, init_args);
+                init->eraseFromParent();
+
+                // __kmpc_dispatch_next(loc, gtid, p_last, p_lb, p_ub, p_stride)
+                for (CallInst *next : dynamic_for_data.next)
+                {
+                    builder.SetInsertPoint(next);
+                    std::vector<Value *> next_args = {
+                        next->getArgOperand(2), next->getArgOperand(3), next->getArgOperand(4),
+                        next->getArgOperand(5)};
+                    CallInst *new_call = builder.CreateCall(next_function, next_args);
+                    next->replaceAllUsesWith(new_call);
+                    next->eraseFromParent();
+                }
+
+                // Chunks are not executed in order, so the end of a chunk needs no signal
+                for (CallInst *fini : dynamic_for_data.fini)
+                {
+                    fini->eraseFromParent();
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Finds the values that are stored into the reduction list list_ptr, which starts at the
+ * given index of the list
+ **/
+static void collect_reduction_list_entries(Value *list_ptr, long index,
+                                           std::vector<Value *> &entries)
+{
+    for (User *user : list_ptr->users())
+    {
+        if (auto *store = dyn_cast<StoreInst>(user))
+        {
+            if (store->getPointerOperand() == list_ptr && index >= 0 &&
+                index < (long)entries.size())
+            {
+                entries[index] = store->getValueOperand();
+            }
+        }
+        else if (auto *gep = dyn_cast<GetElementPtrInst>(user))
+        {
+            // The list is an array of pointers, so only the last index selects an entry
+            auto *offset = dyn_cast<ConstantInt>(gep->getOperand(gep->getNumOperands() - 1));
+            if (gep->hasAllConstantIndices() && offset != nullptr)
+            {
+                collect_reduction_list_entries(gep, index + offset->getSExtValue(), entries);
+            }
+        }
+        else if (auto *bitcast = dyn_cast<BitCastInst>(user))
+        {
+            collect_reduction_list_entries(bitcast, index, entries);
+        }
+    }
+}
+
+/**
+ * Returns true if the reduction list entry holds the length of the variable length array
+ * section in the entry before it instead of a pointer to a local variable
+ **/
+static bool is_array_section_length(Value *entry)
+{
+    auto *op = dyn_cast<Operator>(entry);
+    return op != nullptr && op->getOpcode() == Instruction::IntToPtr;
+}
+
+/**
+ * Adds the blocks of a case of a reduction switch to blocks. These are all blocks that are
+ * reachable from the first block of the case without passing the default block.
+ **/
+static void collect_reduction_case_blocks(BasicBlock *case_block, BasicBlock *case_default,
+                                          std::set<BasicBlock *> &blocks)
+{
+    std::vector<BasicBlock *> worklist = {case_block};
+    while (!worklist.empty())
+    {
+        BasicBlock *block = worklist.back();
+        worklist.pop_back();
+        if (block == case_default || !blocks.insert(block).second)
+        {
+            continue;
+        }
+        for (BasicBlock *successor : successors(block))
+        {
+            worklist.push_back(successor);
+        }
+    }
+}
+
+/**
+ * Returns the start of the shared array section that the first case of a reduction switch
+ * combines with the local copy local_section, or nullptr if it can not be found.
+ * The combination is a loop over both sections, so the start of the shared section is the
+ * only other pointer of the type of the sections that comes from outside of the case.
+ **/
+static Value *find_array_section_target(BasicBlock *case1, BasicBlock *case_default,
+                                        Value *local_section)
+{
+    std::set<BasicBlock *> blocks;
+    collect_reduction_case_blocks(case1, case_default, blocks);
+
+    const Value *local_object = getUnderlyingObject(local_section);
+    std::set<Value *> targets;
+    for (BasicBlock *block : blocks)
+    {
+        for (Instruction &instr : *block)
+        {
+            if (!isa<PHINode>(&instr) && !isa<GetElementPtrInst>(&instr) &&
+                !isa<ICmpInst>(&instr))
+            {
+                continue;
+            }
+            for (Value *operand : instr.operands())
+            {
+                auto *operand_instr = dyn_cast<Instruction>(operand);
+                bool outside = isa<Argument>(operand) ||
+                               (operand_instr != nullptr &&
+                                blocks.count(operand_instr->getParent()) == 0);
+                if (outside && operand->getType() == local_section->getType() &&
+                    getUnderlyingObject(operand) != local_object)
+                {
+                    targets.insert(operand);
+                }
+            }
+        }
+    }
+    return targets.size() == 1 ? *targets.begin() : nullptr;
+}
+
+/**
+ * Returns the shared variable of the microtask that the first case of a reduction switch
+ * combines the scalar local variable local_var into, or nullptr if it can not be found.
+ * The combined value is either stored into the shared variable directly or, if that is a
+ * shared single value, into a temporary variable that is passed to shared_value_store.
+ **/
+static Argument *find_reduction_target(const std::set<BasicBlock *> &case1_blocks,
+                                       Value *local_var, RuntimeHandler &runtime)
+{
+    std::set<Value *> combined_values;
+    std::vector<Value *> worklist;
+    for (User *user : local_var->users())
+    {
+        auto *load = dyn_cast<LoadInst>(user);
+        if (load != nullptr && case1_blocks.count(load->getParent()) > 0)
+        {
+            worklist.push_back(load);
+        }
+    }
+
+    std::set<Argument *> targets;
+    while (!worklist.empty())
+    {
+        Value *value = worklist.back();
+        worklist.pop_back();
+        if (!combined_values.insert(value).second)
+        {
+            continue;
+        }
+        for (User *user : value->users())
+        {
+            auto *instr = dyn_cast<Instruction>(user);
+            if (instr == nullptr || case1_blocks.count(instr->getParent()) == 0 ||
+                isa<CallBase>(instr))
+            {
+                continue;
+            }
+            auto *store = dyn_cast<StoreInst>(instr);
+            if (store == nullptr)
+            {
+                worklist.push_back(instr);
+                continue;
+            }
+            if (store->getValueOperand() != value)
+            {
+                continue;
+            }
+
+            Value *ptr = store->getPointerOperand()->stripPointerCasts();
+            if (auto *arg = dyn_cast<Argument>(ptr))
+            {
+                targets.insert(arg);
+                continue;
+            }
+            std::vector<Value *> temporaries = {ptr};
+            for (User *ptr_user : ptr->users())
+            {
+                if (isa<BitCastInst>(ptr_user))
+                {
+                    temporaries.push_back(ptr_user);
+                }
+            }
+            for (Value *temporary : temporaries)
+            {
+                for (User *temporary_user : temporary->users())
+                {
+                    auto *call = dyn_cast<CallInst>(temporary_user);
+                    if (call != nullptr &&
+                        call->getCalledFunction() == runtime.functions.shared_value_store &&
+                        call->getArgOperand(1) == temporary)
+                    {
+                        Value *base_ptr = call->getArgOperand(0)->stripPointerCasts();
+                        if (auto *arg = dyn_cast<Argument>(base_ptr))
+                        {
+                            targets.insert(arg);
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return targets.size() == 1 ? *targets.begin() : nullptr;
+}
+
+/**
+ * Returns true if the shared variable target is only accessed by the cases of a reduction
+ * switch and by the allocation and synchronization of its shared single value
+ **/
+static bool is_only_reduction_target(Value *target, const std::set<BasicBlock *> &case_blocks,
+                                     RuntimeHandler &runtime)
+{
+    for (User *user : target->users())
+    {
+        auto *instr = dyn_cast<Instruction>(user);
+        if (instr == nullptr)
+        {
+            return false;
+        }
+        if (isa<BitCastInst>(instr))
+        {
+            if (!is_only_reduction_target(instr, case_blocks, runtime))
+            {
+                return false;
+            }
+            continue;
+        }
+        auto *call = dyn_cast<CallInst>(instr);
+        bool shared_value_call =
+            call != nullptr &&
+            (call->getCalledFunction() == runtime.functions.allocate_shared_value ||
+             call->getCalledFunction() == runtime.functions.shared_value_synchronize);
+        if (!shared_value_call && case_blocks.count(instr->getParent()) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Collects the instructions that access the local variable ptr or pass it to a microtask.
+ * Returns false if the variable is used in any other way, so it might be accessed through
+ * another pointer.
+ **/
+static bool collect_variable_accesses(Value *ptr,
+                                      const std::set<Function *> &microtask_functions,
+                                      std::vector<Instruction *> &accesses)
+{
+    for (User *user : ptr->users())
+    {
+        if (isa<BitCastInst>(user))
+        {
+            if (!collect_variable_accesses(user, microtask_functions, accesses))
+            {
+                return false;
+            }
+            continue;
+        }
+        auto *store = dyn_cast<StoreInst>(user);
+        auto *call = dyn_cast<CallInst>(user);
+        bool access =
+            isa<LoadInst>(user) || (store != nullptr && store->getPointerOperand() == ptr) ||
+            (call != nullptr && (call->isLifetimeStartOrEnd() ||
+                                 microtask_functions.count(call->getCalledFunction()) > 0));
+        if (!access)
+        {
+            return false;
+        }
+        accesses.push_back(cast<Instruction>(user));
+    }
+    return true;
+}
+
+/**
+ * Inserts a reduction_wait for the local variable before its first access in each basic
+ * block and before every return, so a lazy reduction into it is completed before the
+ * variable is used again or goes out of scope. Only microtask calls start reductions, so
+ * after a wait no other one is needed until the next microtask call.
+ **/
+static void insert_reduction_waits(AllocaInst *variable,
+                                   const std::set<Function *> &microtask_functions,
+                                   RuntimeHandler &runtime)
+{
+    std::vector<Instruction *> accesses;
+    collect_variable_accesses(variable, microtask_functions, accesses);
+    std::set<Instruction *> wait_points(accesses.begin(), accesses.end());
+
+    Function *function = variable->getFunction();
+    std::vector<Instruction *> insert_points;
+    for (BasicBlock &block : *function)
+    {
+        bool waited = false;
+        for (Instruction &instr : block)
+        {
+            if (!waited && (wait_points.count(&instr) > 0 || isa<ReturnInst>(&instr)))
+            {
+                insert_points.push_back(&instr);
+                waited = true;
+            }
+            auto *call = dyn_cast<CallInst>(&instr);
+            if (call != nullptr && microtask_functions.count(call->getCalledFunction()) > 0)
+            {
+                waited = false;
+            }
+        }
+    }
+
+    for (Instruction *instr : insert_points)
+    {
+        IRBuilder<> builder(instr);
+        Value *target = builder.CreatePointerCast(variable, builder.getInt8PtrTy());
+        builder.CreateCall(runtime.functions.reduction_wait, {target});
     }
 }
 
 /**
  * This function replaces OpenMP reduction operations in the given Microtasks
  * into CATO reduction operations.
+ *
+ * All local reduction variables of one __kmpc_reduce are reduced over all processes with a
+ * single reduce_local_vars call, which applies the reduction function of the OpenMP code
+ * to them, so every reduction operator works without recognizing it in the IR. Afterwards
+ * the first case of the switch that follows the __kmpc_reduce, which combines the local
+ * variables with the shared ones without atomics, is only executed by rank 0.
+ * A reduction of a single array section is first tried with reduce_scatter_local_array,
+ * which combines the section directly with a distributed shared memory object.
+ * A reduction of scalars that are local variables of the callers is first tried with
+ * start_reduce_local_vars, which completes it lazily if CATO_LAZY_REDUCTIONS is set.
  **/
 void CatoPass::replace_reductions(Module &M, RuntimeHandler &runtime,
                                   std::vector<std::unique_ptr<Microtask>> &microtasks)
 {
+    LLVMContext &Ctx = M.getContext();
+    const DataLayout &data_layout = M.getDataLayout();
+
+    std::set<Function *> microtask_functions;
+    for (auto &microtask : microtasks)
+    {
+        microtask_functions.insert(microtask->get_function());
+    }
+
+    // Local variables of the callers of the microtasks that lazy reductions are combined into
+    std::vector<AllocaInst *> lazy_variables;
+
     for (auto &microtask : microtasks)
     {
         std::vector<ReductionData> *reduction_data_vec = microtask->get_reductions();
@@ -1626,262 +3162,497 @@ void CatoPass::replace_reductions(Module &M, RuntimeHandler &runtime,
                 Debug(errs() << "    End Reduce: ";);
                 Debug(reduction_data.end_reduce->dump(););
 
-                Value *num_reduction_variables = reduction_data.reduce->getOperand(2);
-                Value *reduction_data_size = reduction_data.reduce->getOperand(3);
+                auto *num_reduction_variables =
+                    dyn_cast<ConstantInt>(reduction_data.reduce->getOperand(2));
+                auto *reduction_data_size =
+                    dyn_cast<ConstantInt>(reduction_data.reduce->getOperand(3));
+                Value *reduction_lst = reduction_data.reduce->getOperand(4);
                 Function *reduction_function = dyn_cast<Function>(
                     reduction_data.reduce->getOperand(5)->stripPointerCasts());
-                // To get to the declaration of the reduction_lst we need to extract
-                // it from the bitcast to void which is given to the kmpc call
-                Value *reduction_lst = nullptr;
-                if (auto *bitcast =
-                        dyn_cast<BitCastInst>(reduction_data.reduce->getOperand(4)))
-                {
-                    reduction_lst = bitcast->getOperand(0);
-                }
-                // To get the local variable to be reduced we look for stores to the
-                // reduction_lst. A pointer to the local variable will be stored into the
-                // reduction_lst at some point.
-                Value *local_reduction_var = nullptr;
-                for (User *user : reduction_lst->users())
+                auto *switch_inst = dyn_cast<SwitchInst>(reduction_data.reduce->getNextNode());
+
+                if (num_reduction_variables == nullptr || reduction_data_size == nullptr ||
+                    reduction_function == nullptr || switch_inst == nullptr)
                 {
-                    if (auto *gep = dyn_cast<GetElementPtrInst>(user))
-                    {
-                        for (User *user2 : gep->users())
-                        {
-                            if (auto *store = dyn_cast<StoreInst>(user2))
-                            {
-                                local_reduction_var = store->getValueOperand();
-                            }
-                        }
-                    }
+                    errs() << "Error: Unknown IR pattern for a reduction pragma!\n";
+                    continue;
                 }
 
+                // To get the local variables to be reduced we look for stores to the
+                // reduction_lst. A pointer to each local variable will be stored into the
+                // reduction_lst at some point, variable length array sections are followed
+                // by an entry with their length.
+                std::vector<Value *> entries(reduction_data_size->getZExtValue() /
+                                                 data_layout.getPointerSize(),
+                                             nullptr);
+                collect_reduction_list_entries(reduction_lst->stripPointerCasts(), 0,
+                                               entries);
+
                 Debug(errs() << "    Number reduction variables: ";);
                 Debug(num_reduction_variables->dump(););
-                Debug(errs() << "    Reduction data size: ";);
-                Debug(reduction_data_size->dump(););
                 Debug(errs() << "    Reduction reduction_lst: ";);
-                Debug(reduction_lst->dump(););
-                Debug(errs() << "    Reduction local var: ";);
-                Debug(local_reduction_var->dump(););
-
-                // The __kmpc_reduce... function calls are always followed by a switch
-                // statement which handles their return values and implements the actual
-                // reduction. The two cases of the switch statement will be removed and the
-                // control flow will be redirected to the default case, where the CATO
-                // version of the reduction operation is inserted.
-                if (auto *switch_inst =
-                        dyn_cast<SwitchInst>(reduction_data.reduce->getNextNode()))
-                {
-                    BasicBlock *case_default = switch_inst->getDefaultDest();
-                    BasicBlock *case1 = switch_inst->getSuccessor(1);
-                    BasicBlock *case2 = switch_inst->getSuccessor(2);
-                    AtomicRMWInst::BinOp bin_op = AtomicRMWInst::BinOp::BAD_BINOP;
-                    Value *reduction_target = nullptr;
-                    // Reduction operations on integer and floating point create different
-                    // IR
-                    bool integer_type = true;
-
-                    // To determine the type of the reduction operation we search for the
-                    // case2 branch of the switch statement for an AtomicRMWInst. This
-                    // instruction is used by the OpenMP code to reduce the result of the
-                    // local variable reduction with its preexisting value
-                    Debug(errs() << "";);
-                    for (Instruction &instr : *case2)
-                    {
-                        if (auto *atomicrmw = dyn_cast<AtomicRMWInst>(&instr))
-                        {
-                            bin_op = atomicrmw->getOperation();
-                            switch (bin_op)
-                            {
-                            case AtomicRMWInst::BinOp::Add:
-                                Debug(errs() << "    Reduction operation: ADD\n";);
-                                break;
-                            case AtomicRMWInst::BinOp::Max:
-                                Debug(errs() << "    Reduction operation: MAX\n";);
-                                break;
-                            case AtomicRMWInst::BinOp::Min:
-                                Debug(errs() << "    Reduction operation: MIN\n";);
-                                break;
-                            default:
-                                errs() << "    Reduction operation: UNKWOWN\n";
-                                break;
-                            }
-
-                            // We can get a pointer to the shared variable of the reduction
-                            // from the AtomicRMWInst that reduces it with the result of
-                            // the local reduction
-                            reduction_target = atomicrmw->getOperand(0);
-                            Debug(errs() << "    Shared variable reduction target: ";);
-                            Debug(reduction_target->dump());
-                        }
-                        // If the reduction is not on an integer type the IR code differs
-                        // and an additional branch is created from which we have to
-                        // extract the needed information about the reduction operation
-                        else if (auto *branch = dyn_cast<BranchInst>(&instr))
-                        {
-                            if (bin_op == AtomicRMWInst::BinOp::BAD_BINOP)
-                            {
-                                integer_type = false;
-                                Debug(errs() << "   Reduction on non integer type\n";);
-
-                                for (auto &instr : *(branch->getSuccessor(0)))
-                                {
-                                    // ADD/SUB reductions both produce the same IR
-                                    if (auto *binary_op = dyn_cast<BinaryOperator>(&instr))
-                                    {
-                                        if (binary_op->getOpcode() ==
-                                            Instruction::BinaryOps::FAdd)
-                                        {
-                                            Debug(errs() << "    Reduction operation: ADD\n";);
-                                            bin_op = AtomicRMWInst::BinOp::Add;
-                                            break;
-                                        }
-                                    }
-                                    // For MAX/MIN we need to find the compare instruction
-                                    // and extract the type of comparison
-                                    else if (auto *cmp_inst = dyn_cast<FCmpInst>(&instr))
-                                    {
-                                        if (cmp_inst->getPredicate() ==
-                                            CmpInst::Predicate::FCMP_OGT)
-                                        {
-                                            Debug(errs() << "    Reduction operation: MAX\n";);
-                                            bin_op = AtomicRMWInst::BinOp::Max;
-                                            break;
-                                        }
-                                        else if (cmp_inst->getPredicate() ==
-                                                 CmpInst::Predicate::FCMP_OLT)
-                                        {
-                                            Debug(errs() << "    Reduction operation: MIN\n";);
-                                            bin_op = AtomicRMWInst::BinOp::Min;
-                                            break;
-                                        }
-                                        else
-                                        {
-                                            errs() << "Reduction operation: UNKNOWN\n";
-                                        }
-                                    }
-                                }
+                Debug(reduction_lst->dump(););
 
-                                // Find the pointer to the shared variable that gets the
-                                // reduction result
-                                for (Instruction &instr : *case2)
-                                {
-                                    if (auto *load = dyn_cast<LoadInst>(&instr))
-                                    {
-                                        if (auto *bitcast =
-                                                dyn_cast<BitCastInst>(load->getOperand(0)))
-                                        {
-                                            reduction_target = bitcast->getOperand(0);
-                                            Debug(errs() << "    Shared variable reduction "
-                                                            "target: ";);
-                                            Debug(reduction_target->dump());
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                IRBuilder<> builder(switch_inst);
+                Type *reduction_function_type =
+                    runtime.functions.reduce_local_vars->getFunctionType()->getParamType(1);
+                Value *reduction_function_ptr =
+                    builder.CreatePointerCast(reduction_function, reduction_function_type);
+                std::vector<Value *> args = {reduction_lst, reduction_function_ptr,
+                                             builder.getInt32(entries.size())};
+                std::vector<Value *> section_lengths(entries.size(), nullptr);
+                uint64_t num_variables = 0;
+                bool valid = true;
+                for (size_t i = 0; i < entries.size() && valid; i++)
+                {
+                    if (entries[i] == nullptr)
+                    {
+                        valid = false;
                     }
-
-                    LLVMContext &Ctx = M.getContext();
-                    IRBuilder<> builder(switch_inst);
-
-                    // Replace the switch statement with a direct branch to the default
-                    // case, where we will insert the CATO reduction code
-                    builder.CreateBr(case_default);
-                    switch_inst->eraseFromParent();
-                    reduction_data.reduce->eraseFromParent();
-                    reduction_data.end_reduce->eraseFromParent();
-
-                    // Do a MPI reduction for the local values of the reduction variable
-                    // after this all processes will have the reduced value in their local
-                    // variable
-                    std::vector<Value *> args = {
-                        local_reduction_var, builder.getInt32(bin_op),
-                        builder.getInt32(get_mpi_datatype(reduction_target))};
-                    builder.SetInsertPoint(case_default->getFirstNonPHI());
-                    builder.CreateCall(runtime.functions.reduce_local_vars, args);
-
-                    // Now local_reduction var contains the reduction result for all local
-                    // variables and it needs to be reduced once more with the initial
-                    // value of the reduction target variable This only needs to be done by
-                    // one MPI process
-                    // TODO clean up this part of the code
-                    CallInst *mpi_rank = builder.CreateCall(runtime.functions.get_mpi_rank);
-                    BasicBlock *split_block =
-                        SplitBlock(case_default, &*builder.GetInsertPoint());
-                    BasicBlock *master_reduction_block =
-                        BasicBlock::Create(Ctx, "master_reduction", case_default->getParent());
-                    builder.SetInsertPoint(case_default->getTerminator());
-                    Value *condition = builder.CreateICmpEQ(mpi_rank, builder.getInt32(0));
-                    builder.CreateCondBr(condition, master_reduction_block, split_block);
-                    case_default->getTerminator()->eraseFromParent();
-
-                    builder.SetInsertPoint(master_reduction_block);
-
-                    Value *load = builder.CreateLoad(
-                        dyn_cast<BitCastInst>(local_reduction_var)
-                            ->getOperand(0)
-                            ->getType()
-                            ->getPointerElementType(),
-                        dyn_cast<BitCastInst>(local_reduction_var)->getOperand(0));
-
-                    if (integer_type)
+                    else if (is_array_section_length(entries[i]))
                     {
-                        auto *add =
-                            builder.CreateAtomicRMW(bin_op, reduction_target, load,
-                                                    MaybeAlign(), AtomicOrdering::Monotonic);
+                        args.push_back(builder.getInt64(0));
                     }
-                    // For floating point types we need to add more specific IR code
                     else
                     {
-                        if (bin_op == AtomicRMWInst::BinOp::Add)
+                        num_variables++;
+                        Value *local_reduction_var = entries[i]->stripPointerCasts();
+                        Debug(errs() << "    Reduction local var: ";);
+                        Debug(local_reduction_var->dump(););
+
+                        Type *type = local_reduction_var->getType()->getPointerElementType();
+                        Value *size = builder.getInt64(data_layout.getTypeAllocSize(type));
+                        if (i + 1 < entries.size() && entries[i + 1] != nullptr &&
+                            is_array_section_length(entries[i + 1]))
                         {
-                            auto *add = builder.CreateAtomicRMW(
-                                AtomicRMWInst::BinOp::FAdd, reduction_target, load,
-                                MaybeAlign(), AtomicOrdering::Monotonic);
+                            section_lengths[i] = builder.CreatePtrToInt(entries[i + 1],
+                                                                        builder.getInt64Ty());
+                            size = builder.CreateMul(section_lengths[i], size);
                         }
-                        // TODO see if shared_value load/store calls are necessary here
-                        else if (bin_op == AtomicRMWInst::BinOp::Max)
-                        {
-                            auto *target_load = builder.CreateLoad(
-                                reduction_target->getType()->getPointerElementType(),
-                                reduction_target);
-                            auto *fcmp = builder.CreateFCmp(CmpInst::Predicate::FCMP_OGT,
-                                                            target_load, load);
-                            auto *select = builder.CreateSelect(fcmp, target_load, load);
-                            auto *store = builder.CreateStore(select, reduction_target);
-                        }
-                        // TODO see if shared_value load/store calls are necessary here
-                        else if (bin_op == AtomicRMWInst::BinOp::Min)
+                        args.push_back(size);
+                    }
+                }
+                if (!valid || num_variables != num_reduction_variables->getZExtValue())
+                {
+                    errs() << "Error: Could not find the local variables of a reduction!\n";
+                    continue;
+                }
+
+                BasicBlock *case_default = switch_inst->getDefaultDest();
+                BasicBlock *case1 =
+                    switch_inst->findCaseValue(builder.getInt32(1))->getCaseSuccessor();
+                BasicBlock *reduce_block = switch_inst->getParent();
+
+                // A single array section is reduced directly into its shared memory object,
+                // if it is one. Otherwise it takes the same way as all other reductions.
+                Value *handled = nullptr;
+                if (entries.size() == 2 && section_lengths[0] != nullptr)
+                {
+                    Value *local_section = entries[0]->stripPointerCasts();
+                    Value *target =
+                        find_array_section_target(case1, case_default, local_section);
+                    if (target != nullptr)
+                    {
+                        Debug(errs() << "    Array section reduction target: ";);
+                        Debug(target->dump(););
+
+                        Type *type = local_section->getType()->getPointerElementType();
+                        std::vector<Value *> scatter_args = {
+                            reduction_lst, reduction_function_ptr,
+                            builder.CreatePointerCast(target, builder.getInt8PtrTy()),
+                            section_lengths[0],
+                            builder.getInt64(data_layout.getTypeAllocSize(type))};
+                        handled = builder.CreateCall(
+                            runtime.functions.reduce_scatter_local_array, scatter_args);
+                    }
+                }
+
+                // A reduction of scalars that are only combined into local variables of the
+                // callers of the microtask can be completed lazily. It is started with
+                // start_reduce_local_vars and the callers wait for it right before they
+                // access one of the variables again.
+                std::vector<Value *> lazy_args = {args[0], args[1], args[2]};
+                std::vector<AllocaInst *> variables;
+                std::set<BasicBlock *> case1_blocks, case_blocks;
+                collect_reduction_case_blocks(case1, case_default, case1_blocks);
+                for (auto &switch_case : switch_inst->cases())
+                {
+                    collect_reduction_case_blocks(switch_case.getCaseSuccessor(), case_default,
+                                                  case_blocks);
+                }
+                bool lazy = handled == nullptr;
+                for (size_t i = 0; i < entries.size() && lazy; i++)
+                {
+                    Value *local_var = entries[i]->stripPointerCasts();
+                    Argument *target = nullptr;
+                    if (section_lengths[i] == nullptr &&
+                        local_var->getType()->getPointerElementType()->isSingleValueType())
+                    {
+                        target = find_reduction_target(case1_blocks, local_var, runtime);
+                    }
+                    if (target == nullptr ||
+                        !is_only_reduction_target(target, case_blocks, runtime))
+                    {
+                        lazy = false;
+                        break;
+                    }
+
+                    // The bitcasts of the microtask for the replaced fork calls are left
+                    microtask->get_function()->removeDeadConstantUsers();
+                    for (User *user : microtask->get_function()->users())
+                    {
+                        auto *call = dyn_cast<CallInst>(user);
+                        auto *variable =
+                            call != nullptr
+                                ? dyn_cast<AllocaInst>(call->getArgOperand(target->getArgNo()))
+                                : nullptr;
+                        std::vector<Instruction *> accesses;
+                        if (variable == nullptr ||
+                            !collect_variable_accesses(variable, microtask_functions,
+                                                       accesses))
                         {
-                            auto *target_load = builder.CreateLoad(
-                                reduction_target->getType()->getPointerElementType(),
-                                reduction_target);
-                            auto *fcmp = builder.CreateFCmp(CmpInst::Predicate::FCMP_OLT,
-                                                            target_load, load);
-                            auto *select = builder.CreateSelect(fcmp, target_load, load);
-                            auto *store = builder.CreateStore(select, reduction_target);
+                            lazy = false;
+                            break;
                         }
-                        else
+                        variables.push_back(variable);
+                    }
+                    lazy_args.push_back(args[3 + i]);
+                    lazy_args.push_back(
+                        builder.CreatePointerCast(target, builder.getInt8PtrTy()));
+                }
+                if (lazy && !variables.empty())
+                {
+                    Debug(errs() << "    Reduction can be completed lazily\n";);
+                    handled = builder.CreateCall(runtime.functions.start_reduce_local_vars,
+                                                 lazy_args);
+                    for (AllocaInst *variable : variables)
+                    {
+                        if (std::find(lazy_variables.begin(), lazy_variables.end(),
+                                      variable) == lazy_variables.end())
                         {
-                            // TODO
+                            lazy_variables.push_back(variable);
                         }
                     }
-                    builder.CreateBr(split_block);
-
-                    // TODO erase unneeded basicblocks case1/case2 and possible successors
-                    // This might also be done automatically by the following llvm passes
-                    // need to check final IR output to confirm
-                    reduction_function->eraseFromParent();
                 }
-                else
+
+                if (handled != nullptr)
                 {
-                    errs() << "Error: Unknown IR pattern for a reduction pragma!\n";
+                    BasicBlock *all_reduce_block = BasicBlock::Create(
+                        Ctx, "reduce_local_vars", reduce_block->getParent(), case1);
+                    Value *condition = builder.CreateICmpNE(handled, builder.getInt32(0));
+                    builder.CreateCondBr(condition, case_default, all_reduce_block);
+                    for (PHINode &phi : case_default->phis())
+                    {
+                        phi.addIncoming(phi.getIncomingValueForBlock(reduce_block),
+                                        all_reduce_block);
+                    }
+                    case1->replacePhiUsesWith(reduce_block, all_reduce_block);
+                    builder.SetInsertPoint(all_reduce_block);
                 }
+
+                // Do a MPI reduction for the local values of the reduction variables
+                // after this all processes will have the reduced values in their local
+                // variables
+                builder.CreateCall(runtime.functions.reduce_local_vars, args);
+
+                // Now the local reduction variables contain the reduction result for all
+                // local variables and they need to be reduced once more with the initial
+                // values of the reduction target variables. This only needs to be done by
+                // one MPI process, which takes the case of the switch that does it without
+                // atomics. The other case is unreachable afterwards and is left to the
+                // following llvm passes.
+                CallInst *mpi_rank = builder.CreateCall(runtime.functions.get_mpi_rank);
+                Value *condition = builder.CreateICmpEQ(mpi_rank, builder.getInt32(0));
+                builder.CreateCondBr(condition, case1, case_default);
+
+                switch_inst->eraseFromParent();
+                reduction_data.reduce->eraseFromParent();
+                reduction_data.end_reduce->eraseFromParent();
+            }
+        }
+    }
+
+    for (AllocaInst *variable : lazy_variables)
+    {
+        insert_reduction_waits(variable, microtask_functions, runtime);
+    }
+}
+
+/**
+ * Returns the AtomicRMWInst operation that computes the update value from the old value of a
+ * shared variable, or BAD_BINOP if it is no update of the old value. Sets operand to the
+ * other value of the operation and adds the instructions that compute it to
+ * update_instructions.
+ **/
+static AtomicRMWInst::BinOp
+get_update_operation(Value *update, Value *old_value, Value **operand,
+                     std::vector<Instruction *> &update_instructions)
+{
+    Value *lhs = nullptr;
+    Value *rhs = nullptr;
+    AtomicRMWInst::BinOp bin_op = AtomicRMWInst::BAD_BINOP;
+    bool commutative = true;
+
+    if (auto *binary = dyn_cast<BinaryOperator>(update))
+    {
+        lhs = binary->getOperand(0);
+        rhs = binary->getOperand(1);
+        switch (binary->getOpcode())
+        {
+        case Instruction::Add:
+            bin_op = AtomicRMWInst::Add;
+            break;
+        case Instruction::FAdd:
+            bin_op = AtomicRMWInst::FAdd;
+            break;
+        case Instruction::Sub:
+            bin_op = AtomicRMWInst::Sub;
+            commutative = false;
+            break;
+        case Instruction::FSub:
+            bin_op = AtomicRMWInst::FSub;
+            commutative = false;
+            break;
+        case Instruction::And:
+            bin_op = AtomicRMWInst::And;
+            break;
+        case Instruction::Or:
+            bin_op = AtomicRMWInst::Or;
+            break;
+        case Instruction::Xor:
+            bin_op = AtomicRMWInst::Xor;
+            break;
+        default:
+            return AtomicRMWInst::BAD_BINOP;
+        }
+        update_instructions.push_back(binary);
+    }
+    else if (auto *intrinsic = dyn_cast<IntrinsicInst>(update))
+    {
+        switch (intrinsic->getIntrinsicID())
+        {
+        case Intrinsic::smax:
+        case Intrinsic::maxnum:
+            bin_op = AtomicRMWInst::Max;
+            break;
+        case Intrinsic::smin:
+        case Intrinsic::minnum:
+            bin_op = AtomicRMWInst::Min;
+            break;
+        case Intrinsic::umax:
+            bin_op = AtomicRMWInst::UMax;
+            break;
+        case Intrinsic::umin:
+            bin_op = AtomicRMWInst::UMin;
+            break;
+        default:
+            return AtomicRMWInst::BAD_BINOP;
+        }
+        lhs = intrinsic->getArgOperand(0);
+        rhs = intrinsic->getArgOperand(1);
+        update_instructions.push_back(intrinsic);
+    }
+    else if (auto *select = dyn_cast<SelectInst>(update))
+    {
+        // max = max > x ? max : x and the other compare and select forms of min and max
+        auto *compare = dyn_cast<CmpInst>(select->getCondition());
+        if (compare == nullptr || !compare->hasOneUse())
+        {
+            return AtomicRMWInst::BAD_BINOP;
+        }
+        lhs = select->getTrueValue();
+        rhs = select->getFalseValue();
+
+        CmpInst::Predicate predicate = compare->getPredicate();
+        if (compare->getOperand(0) == rhs && compare->getOperand(1) == lhs)
+        {
+            predicate = CmpInst::getSwappedPredicate(predicate);
+        }
+        else if (compare->getOperand(0) != lhs || compare->getOperand(1) != rhs)
+        {
+            return AtomicRMWInst::BAD_BINOP;
+        }
+
+        switch (predicate)
+        {
+        case CmpInst::ICMP_SGT:
+        case CmpInst::ICMP_SGE:
+        case CmpInst::FCMP_OGT:
+        case CmpInst::FCMP_OGE:
+        case CmpInst::FCMP_UGT:
+        case CmpInst::FCMP_UGE:
+            bin_op = AtomicRMWInst::Max;
+            break;
+        case CmpInst::ICMP_SLT:
+        case CmpInst::ICMP_SLE:
+        case CmpInst::FCMP_OLT:
+        case CmpInst::FCMP_OLE:
+        case CmpInst::FCMP_ULT:
+        case CmpInst::FCMP_ULE:
+            bin_op = AtomicRMWInst::Min;
+            break;
+        case CmpInst::ICMP_UGT:
+        case CmpInst::ICMP_UGE:
+            bin_op = AtomicRMWInst::UMax;
+            break;
+        case CmpInst::ICMP_ULT:
+        case CmpInst::ICMP_ULE:
+            bin_op = AtomicRMWInst::UMin;
+            break;
+        default:
+            return AtomicRMWInst::BAD_BINOP;
+        }
+        update_instructions.push_back(compare);
+        update_instructions.push_back(select);
+    }
+
+    if (commutative && rhs == old_value)
+    {
+        std::swap(lhs, rhs);
+    }
+    if (lhs != old_value || rhs == old_value)
+    {
+        return AtomicRMWInst::BAD_BINOP;
+    }
+
+    *operand = rhs;
+    return bin_op;
+}
+
+/**
+ * Replaces a critical section that only updates one shared single value variable, like
+ * sum += x or max = max > x ? max : x, with one shared_value_accumulate call, so it needs
+ * no mutex. The shared value accesses inside the critical section have already been
+ * replaced, so it has to consist of a shared_value_load followed by the load of the old
+ * value, the update and the store of the new value followed by a shared_value_store.
+ * Returns false and leaves the critical section unchanged if it does anything else.
+ **/
+static bool replace_critical_with_accumulate(CriticalData &critical_data,
+                                             RuntimeHandler &runtime)
+{
+    CallInst *critical = critical_data.critical;
+    CallInst *end_critical = critical_data.end_critical;
+    if (critical->getParent() != end_critical->getParent())
+    {
+        return false;
+    }
+
+    CallInst *value_load_call = nullptr;
+    CallInst *value_store_call = nullptr;
+    std::vector<StoreInst *> stores;
+    for (Instruction *inst = critical->getNextNode(); inst != end_critical;
+         inst = inst->getNextNode())
+    {
+        if (inst == nullptr)
+        {
+            return false;
+        }
+        else if (auto *call = dyn_cast<CallInst>(inst))
+        {
+            Function *callee = call->getCalledFunction();
+            if (callee == runtime.functions.shared_value_load && value_load_call == nullptr)
+            {
+                value_load_call = call;
+            }
+            else if (callee == runtime.functions.shared_value_store &&
+                     value_store_call == nullptr)
+            {
+                value_store_call = call;
             }
+            else if (callee != runtime.functions.get_mpi_rank &&
+                     callee != runtime.functions.get_mpi_size &&
+                     !isa<DbgInfoIntrinsic>(call))
+            {
+                return false;
+            }
+        }
+        else if (auto *store = dyn_cast<StoreInst>(inst))
+        {
+            stores.push_back(store);
+        }
+        else if (inst->mayHaveSideEffects())
+        {
+            return false;
+        }
+    }
+
+    if (value_load_call == nullptr || value_store_call == nullptr || stores.size() != 1 ||
+        value_load_call->getArgOperand(0) != value_store_call->getArgOperand(0) ||
+        value_store_call->comesBefore(value_load_call))
+    {
+        return false;
+    }
+
+    // The store of the new value into the temporary the shared_value_store reads from
+    auto *value_ptr = dyn_cast<BitCastInst>(value_store_call->getArgOperand(1));
+    StoreInst *value_store = stores.front();
+    if (value_ptr == nullptr || value_store->getPointerOperand() != value_ptr->getOperand(0))
+    {
+        return false;
+    }
+
+    auto *old_value = dyn_cast<LoadInst>(value_load_call->getNextNode());
+    Value *update = value_store->getValueOperand();
+    Type *type = update->getType();
+    // i8 is mapped to MPI_CHAR, which MPI_Accumulate does not accept, so it keeps the mutex
+    if (old_value == nullptr || !update->hasOneUse() ||
+        !(type->isIntegerTy(32) || type->isIntegerTy(64) || type->isFloatTy() ||
+          type->isDoubleTy()))
+    {
+        return false;
+    }
+
+    Value *operand = nullptr;
+    std::vector<Instruction *> update_instructions;
+    AtomicRMWInst::BinOp bin_op =
+        get_update_operation(update, old_value, &operand, update_instructions);
+    if (bin_op == AtomicRMWInst::BAD_BINOP)
+    {
+        return false;
+    }
+
+    // The old value must only be used to compute the new value
+    for (auto *user : old_value->users())
+    {
+        if (std::find(update_instructions.begin(), update_instructions.end(), user) ==
+            update_instructions.end())
+        {
+            return false;
         }
     }
+
+    Debug(errs() << "Replacing critical section with a shared value accumulate\n";);
+
+    // MPI has no subtraction, so the negated value is added instead
+    IRBuilder<> builder(value_store);
+    if (bin_op == AtomicRMWInst::Sub)
+    {
+        operand = builder.CreateNeg(operand);
+        bin_op = AtomicRMWInst::Add;
+    }
+    else if (bin_op == AtomicRMWInst::FSub)
+    {
+        operand = builder.CreateFNeg(operand);
+        bin_op = AtomicRMWInst::FAdd;
+    }
+    value_store->setOperand(0, operand);
+
+    builder.SetInsertPoint(value_store_call);
+    builder.CreateCall(runtime.functions.shared_value_accumulate,
+                       {value_store_call->getArgOperand(0), value_ptr,
+                        builder.getInt32(bin_op)});
+
+    value_store_call->eraseFromParent();
+    for (auto it = update_instructions.rbegin(); it != update_instructions.rend(); ++it)
+    {
+        (*it)->eraseFromParent();
+    }
+    old_value->eraseFromParent();
+    value_load_call->eraseFromParent();
+    critical->eraseFromParent();
+    end_critical->eraseFromParent();
+
+    return true;
 }
 
 /**
@@ -1899,6 +3670,20 @@ void CatoPass::replace_criticals(Module &M, RuntimeHandler &runtime,
             IRBuilder<> builder(M.getContext());
             LLVMContext &Ctx = M.getContext();
 
+            // Critical sections that only update one shared value need no mutex
+            std::vector<CriticalData> locked_critical_data;
+            for (CriticalData critical_data : *critical_data_vec)
+            {
+                if (!replace_critical_with_accumulate(critical_data, runtime))
+                {
+                    locked_critical_data.push_back(critical_data);
+                }
+            }
+            if (locked_critical_data.empty())
+            {
+                continue;
+            }
+
             // Create a MPI Mutex for the microtask
             builder.SetInsertPoint(
                 microtask->get_function()->getEntryBlock().getFirstNonPHI());
@@ -1907,7 +3692,7 @@ void CatoPass::replace_criticals(Module &M, RuntimeHandler &runtime,
 
             // Replace the begin an end of the OpenMP critical section with mutex
             // acquisition / release
-            for (CriticalData critical_data : *critical_data_vec)
+            for (CriticalData critical_data : locked_critical_data)
             {
                 Debug(errs() << "Microtask contains a critical section.\n";);
                 Debug(errs() << "    Critical: ";);
@@ -1965,6 +3750,312 @@ void CatoPass::replace_memory_deallocations(Module &M, RuntimeHandler &runtime)
     }
 }
 
+/**
+ * The ways a function can access the shared memory objects, ordered by their strength
+ **/
+enum SharedMemoryAccess
+{
+    SHARED_MEMORY_NO_ACCESS,
+    SHARED_MEMORY_READ,
+    SHARED_MEMORY_WRITE
+};
+
+/**
+ * Returns how a call of the CATO Runtime Library function accesses the shared memory objects.
+ * Shared single values are not included, they are synchronized at the end of each microtask.
+ **/
+static SharedMemoryAccess get_runtime_function_access(Function *function,
+                                                      RuntimeHandler &runtime)
+{
+    auto &functions = runtime.functions;
+    std::set<Function *> loads = {
+        functions.shared_memory_load,
+        functions.shared_memory_load_1d,
+        functions.shared_memory_load_2d,
+        functions.shared_memory_load_3d,
+        functions.shared_memory_sequential_load,
+        functions.shared_memory_sequential_load_1d,
+        functions.shared_memory_sequential_load_2d,
+        functions.shared_memory_sequential_load_3d,
+        functions.shared_memory_load_with_handle,
+        functions.shared_memory_load_with_handle_1d,
+        functions.shared_memory_load_with_handle_2d,
+        functions.shared_memory_load_with_handle_3d,
+        functions.shared_memory_load_range,
+        functions.shared_memory_load_range_2d,
+        functions.shared_memory_exchange_halo,
+        functions.shared_memory_sequential_snapshot};
+    std::set<Function *> stores = {
+        functions.allocate_shared_memory,
+        functions.shared_memory_free,
+        functions.shared_memory_store,
+        functions.shared_memory_store_1d,
+        functions.shared_memory_store_2d,
+        functions.shared_memory_store_3d,
+        functions.shared_memory_sequential_store,
+        functions.shared_memory_sequential_store_1d,
+        functions.shared_memory_sequential_store_2d,
+        functions.shared_memory_sequential_store_3d,
+        functions.shared_memory_sequential_local_range,
+        functions.shared_memory_sequential_local_range_2d,
+        functions.shared_memory_sequential_local_end,
+        functions.shared_memory_pointer_store,
+        functions.shared_memory_store_range,
+        functions.shared_memory_store_range_2d,
+        functions.shared_memory_store_with_handle,
+        functions.shared_memory_store_with_handle_1d,
+        functions.shared_memory_store_with_handle_2d,
+        functions.shared_memory_store_with_handle_3d,
+        functions.shared_memory_atomic_with_handle,
+        functions.shared_memory_compare_and_swap_with_handle,
+        functions.reduce_scatter_local_array};
+
+    if (stores.count(function) > 0)
+    {
+        return SHARED_MEMORY_WRITE;
+    }
+    return loads.count(function) > 0 ? SHARED_MEMORY_READ : SHARED_MEMORY_NO_ACCESS;
+}
+
+/**
+ * Returns true if ptr is one of the local buffers for range accesses. These are allocated with
+ * malloc after all other allocations have been replaced, but their free calls are replaced
+ * like all others.
+ **/
+static bool is_range_buffer(Value *ptr)
+{
+    auto *allocation = dyn_cast<CallInst>(getUnderlyingObject(ptr));
+    return allocation != nullptr && allocation->getCalledFunction() != nullptr &&
+           allocation->getCalledFunction()->getName() == "malloc";
+}
+
+/**
+ * Returns how the function and all functions it calls access the shared memory objects.
+ * Indirect and recursive calls are assumed to write.
+ **/
+static SharedMemoryAccess
+get_shared_memory_access(Function *function, RuntimeHandler &runtime,
+                         std::map<Function *, SharedMemoryAccess> &cache)
+{
+    auto cached = cache.find(function);
+    if (cached != cache.end())
+    {
+        return cached->second;
+    }
+    cache[function] = SHARED_MEMORY_WRITE;
+
+    SharedMemoryAccess access = SHARED_MEMORY_NO_ACCESS;
+    for (Instruction &instr : instructions(function))
+    {
+        auto *call = dyn_cast<CallBase>(&instr);
+        if (call == nullptr)
+        {
+            continue;
+        }
+        Function *callee = call->getCalledFunction();
+        if (callee == nullptr && !call->isInlineAsm())
+        {
+            access = SHARED_MEMORY_WRITE;
+        }
+        else if (callee == runtime.functions.shared_memory_free &&
+                 is_range_buffer(call->getArgOperand(0)))
+        {
+            continue;
+        }
+        else if (callee != nullptr && callee->isDeclaration())
+        {
+            access = std::max(access, get_runtime_function_access(callee, runtime));
+        }
+        else if (callee != nullptr)
+        {
+            access = std::max(access, get_shared_memory_access(callee, runtime, cache));
+        }
+    }
+    cache[function] = access;
+    return access;
+}
+
+/**
+ * Returns true if every return of the microtask is preceded by a shared_value_synchronize,
+ * whose barrier all processes pass only after all their accesses in the microtask
+ **/
+static bool ends_with_synchronization(Function *microtask, RuntimeHandler &runtime)
+{
+    for (BasicBlock &block : *microtask)
+    {
+        if (!isa<ReturnInst>(block.getTerminator()))
+        {
+            continue;
+        }
+        auto *call = dyn_cast_or_null<CallInst>(block.getTerminator()->getPrevNode());
+        if (call == nullptr ||
+            call->getCalledFunction() != runtime.functions.shared_value_synchronize)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Returns true if a process can access the shared memory objects in a way that conflicts
+ * with the reads of another process that is still in the read only microtask, after it
+ * left microtask_call and before the next barrier in synchronizations. The control flow of
+ * the caller is followed from the call. Reads by other read only microtasks do not
+ * conflict, but the sequential accesses use MPI_Win_fence on the windows, which must not
+ * overlap with the passive target epoch of the microtask. Leaving the caller does conflict.
+ **/
+static bool has_conflicting_access(CallInst *microtask_call,
+                                   const std::set<CallInst *> &synchronizations,
+                                   const std::set<Function *> &microtask_functions,
+                                   RuntimeHandler &runtime,
+                                   std::map<Function *, SharedMemoryAccess> &cache)
+{
+    std::set<BasicBlock *> visited;
+    std::vector<Instruction *> worklist = {microtask_call->getNextNode()};
+    while (!worklist.empty())
+    {
+        Instruction *instr = worklist.back();
+        worklist.pop_back();
+        for (; instr != nullptr; instr = instr->getNextNode())
+        {
+            auto *call = dyn_cast<CallBase>(instr);
+            if (call != nullptr)
+            {
+                Function *callee = call->getCalledFunction();
+                if (synchronizations.count(dyn_cast<CallInst>(call)) > 0 ||
+                    callee == runtime.functions.cato_finalize)
+                {
+                    break;
+                }
+                if (callee == nullptr && !call->isInlineAsm())
+                {
+                    return true;
+                }
+                SharedMemoryAccess access = SHARED_MEMORY_NO_ACCESS;
+                if (callee != nullptr && callee->isDeclaration())
+                {
+                    access = get_runtime_function_access(callee, runtime);
+                }
+                else if (callee != nullptr)
+                {
+                    access = get_shared_memory_access(callee, runtime, cache);
+                }
+                bool microtask = microtask_functions.count(callee) > 0;
+                if (access == SHARED_MEMORY_WRITE ||
+                    (access == SHARED_MEMORY_READ && !microtask))
+                {
+                    return true;
+                }
+            }
+            if (isa<ReturnInst>(instr) || isa<ResumeInst>(instr))
+            {
+                return true;
+            }
+            if (instr->isTerminator())
+            {
+                for (BasicBlock *successor : successors(instr->getParent()))
+                {
+                    if (visited.insert(successor).second)
+                    {
+                        worklist.push_back(&successor->front());
+                    }
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Removes the barriers after microtask calls that are not needed, because no process can
+ * observe the shared memory accesses of another process in the microtask before the next
+ * synchronization. This is the case if the microtask does not access the shared memory
+ * objects at all. A microtask that only reads them only has to be kept from overlapping
+ * with the writes that follow it, which is already done if it ends with the barrier of a
+ * shared value synchronization, like the one of a reduction, or if no write and no
+ * sequential access can follow before the next barrier. Shared single values are
+ * synchronized at the end of the microtask anyway.
+ **/
+void CatoPass::remove_redundant_barriers(Module &M, RuntimeHandler &runtime,
+                                         std::vector<std::unique_ptr<Microtask>> &microtasks)
+{
+    std::map<Function *, SharedMemoryAccess> cache;
+
+    // The barrier that replace_fork_calls inserted after each call of a microtask
+    std::set<Function *> microtask_functions;
+    std::map<CallInst *, CallInst *> microtask_barriers;
+    for (auto &microtask : microtasks)
+    {
+        Function *function = microtask->get_function();
+        microtask_functions.insert(function);
+        function->removeDeadConstantUsers();
+        for (User *user : function->users())
+        {
+            auto *call = dyn_cast<CallInst>(user);
+            if (call == nullptr || call->getCalledFunction() != function)
+            {
+                continue;
+            }
+            auto *epoch_end = dyn_cast_or_null<CallInst>(call->getNextNode());
+            auto *barrier = epoch_end != nullptr
+                                ? dyn_cast_or_null<CallInst>(epoch_end->getNextNode())
+                                : nullptr;
+            if (epoch_end != nullptr &&
+                epoch_end->getCalledFunction() == runtime.functions.shared_memory_epoch_end &&
+                barrier != nullptr &&
+                barrier->getCalledFunction() == runtime.functions.mpi_barrier)
+            {
+                microtask_barriers[call] = barrier;
+            }
+        }
+    }
+
+    // Only the barriers that are kept for sure are synchronizations for the other microtasks
+    std::set<CallInst *> synchronizations;
+    for (Function &function : M)
+    {
+        for (Instruction &instr : instructions(function))
+        {
+            auto *call = dyn_cast<CallInst>(&instr);
+            if (call != nullptr && call->getCalledFunction() == runtime.functions.mpi_barrier)
+            {
+                synchronizations.insert(call);
+            }
+        }
+    }
+    for (auto &microtask_barrier : microtask_barriers)
+    {
+        Function *microtask = microtask_barrier.first->getCalledFunction();
+        if (get_shared_memory_access(microtask, runtime, cache) != SHARED_MEMORY_WRITE)
+        {
+            synchronizations.erase(microtask_barrier.second);
+        }
+    }
+
+    std::vector<CallInst *> redundant_barriers;
+    for (auto &microtask_barrier : microtask_barriers)
+    {
+        CallInst *call = microtask_barrier.first;
+        Function *microtask = call->getCalledFunction();
+        SharedMemoryAccess access = get_shared_memory_access(microtask, runtime, cache);
+        if (access == SHARED_MEMORY_NO_ACCESS ||
+            (access == SHARED_MEMORY_READ &&
+             (ends_with_synchronization(microtask, runtime) ||
+              !has_conflicting_access(call, synchronizations, microtask_functions, runtime,
+                                      cache))))
+        {
+            Debug(errs() << "Removing the barrier after the call of " << microtask->getName()
+                         << "\n";);
+            redundant_barriers.push_back(microtask_barrier.second);
+        }
+    }
+    for (CallInst *barrier : redundant_barriers)
+    {
+        barrier->eraseFromParent();
+    }
+}
+
 /**
  * Only use during development!
  * Inserting the test_func function into the program
@@ -2036,6 +4127,8 @@ bool CatoPass::runOnModule(Module &M)
 
     replace_memory_deallocations(M, runtime);
 
+    remove_redundant_barriers(M, runtime, microtasks);
+
     // insert_test_func(M, runtime);
     Debug(errs() << "*----------------------------------*\n";);
     Debug(errs() << "|      IR CODE AFTER THE PASS:     |\n";);
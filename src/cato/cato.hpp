@@ -22,6 +22,7 @@
 #include <llvm/IR/Module.h>
 #include <llvm/IR/PassManager.h>
 #include <llvm/Passes/PassPlugin.h>
+#include <set>
 #include <vector>
 
 struct CatoPass : public llvm::PassInfoMixin<CatoPass>
@@ -39,7 +40,8 @@ struct CatoPass : public llvm::PassInfoMixin<CatoPass>
         std::vector<std::pair<int, std::vector<llvm::Value *>>> *store_paths,
         std::vector<std::pair<int, std::vector<llvm::Value *>>> *load_paths,
         std::vector<std::pair<int, std::vector<llvm::Value *>>> *ptr_store_paths,
-        std::vector<std::vector<llvm::Value *>> *free_paths);
+        std::vector<std::vector<llvm::Value *>> *free_paths,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> *atomic_paths = nullptr);
 
     template <class T>
     std::vector<llvm::Value *>
@@ -52,6 +54,31 @@ struct CatoPass : public llvm::PassInfoMixin<CatoPass>
         llvm::Module &M, RuntimeHandler &runtime,
         std::vector<llvm::StoreInst *> &base_ptr_stores);
 
+    void replace_sequential_init_loops(
+        llvm::Module &M, RuntimeHandler &runtime,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &load_paths,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &store_paths);
+
+    void insert_sequential_snapshots(
+        llvm::Module &M, RuntimeHandler &runtime,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &load_paths,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &store_paths);
+
+    void replace_contiguous_loop_accesses(
+        llvm::Module &M, RuntimeHandler &runtime, llvm::Function *function,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &load_paths,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &store_paths);
+
+    void find_owner_aligned_accesses(
+        llvm::Module &M, Microtask &microtask,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &load_paths,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &store_paths);
+
+    void insert_halo_exchanges(
+        llvm::Module &M, RuntimeHandler &runtime, Microtask &microtask,
+        std::vector<std::pair<int, std::vector<llvm::Value *>>> &load_paths,
+        std::set<llvm::Value *> &modified_variables);
+
     void replace_microtask_shared_memory_accesses(
         llvm::Module &M, RuntimeHandler &runtime,
         std::vector<std::unique_ptr<Microtask>> &microtasks);
@@ -78,5 +105,8 @@ struct CatoPass : public llvm::PassInfoMixin<CatoPass>
 
     void replace_memory_deallocations(llvm::Module &M, RuntimeHandler &runtime);
 
+    void remove_redundant_barriers(llvm::Module &M, RuntimeHandler &runtime,
+                                   std::vector<std::unique_ptr<Microtask>> &microtasks);
+
     void insert_test_func(llvm::Module &M, RuntimeHandler &runtime);
 };
@@ -0,0 +1,38 @@
+#ifndef CATO_RTLIB_INDEX_SPAN_H
+#define CATO_RTLIB_INDEX_SPAN_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Non owning view on the access indices of a shared memory access.
+ *
+ * The indices are passed by the rtlib entry points through the MemoryAbstractionHandler
+ * down to the MemoryAbstraction classes. A view is cheap to copy and does not allocate,
+ * the referenced indices only have to outlive the call.
+ **/
+class IndexSpan
+{
+  private:
+    const long *_data;
+
+    std::size_t _size;
+
+  public:
+    IndexSpan(const long *data, std::size_t size) : _data(data), _size(size) {}
+
+    IndexSpan(const std::vector<long> &indices)
+        : _data(indices.data()), _size(indices.size())
+    {
+    }
+
+    std::size_t size() const { return _size; }
+
+    const long &operator[](std::size_t i) const { return _data[i]; }
+
+    const long *begin() const { return _data; }
+
+    const long *end() const { return _data + _size; }
+};
+
+#endif
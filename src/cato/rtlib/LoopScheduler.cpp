@@ -0,0 +1,321 @@
+#include "LoopScheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include "../debug.h"
+
+// Schedule types of the OpenMP runtime library, see kmp_sched_type in kmp.h
+static const int kmp_sch_guided_chunked = 36;
+static const int kmp_sch_guided_iterative_chunked = 42;
+static const int kmp_sch_guided_analytical_chunked = 43;
+static const int kmp_sch_modifier_mask = (1 << 29) | (1 << 30);
+
+// Number of counters in the ring, the OpenMP runtime library uses the same number of
+// dispatch buffers
+static const int num_slots = 7;
+
+// Steal attempts increment the upper half of a deque counter, so the counter holds the
+// number of all attempts in the lower half and the number of steal attempts in the upper
+static const long steal_increment = 1L << 32;
+static const long attempt_mask = steal_increment - 1;
+
+// Number of chunks the deque of a guided loop is split into
+static const long guided_deque_chunks = 8;
+
+/**
+ * Returns true if CATO_WORK_STEALING is set to a value other than 0
+ **/
+static bool work_stealing_enabled()
+{
+    static bool enabled = []() {
+        const char *value = std::getenv("CATO_WORK_STEALING");
+        return value != nullptr && std::atoi(value) != 0;
+    }();
+    return enabled;
+}
+
+LoopScheduler::LoopScheduler()
+{
+    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);
+    _work_stealing = work_stealing_enabled() && _mpi_size > 1;
+
+    // Nearest processes first, their blocks are next to the own block
+    _victims.push_back(_work_stealing ? _mpi_rank : 0);
+    for (int distance = 1; _work_stealing && distance < _mpi_size; distance++)
+    {
+        for (int rank : {_mpi_rank + distance, _mpi_rank - distance})
+        {
+            if (rank >= 0 && rank < _mpi_size && (int)_victims.size() < _mpi_size)
+            {
+                _victims.push_back(rank);
+            }
+        }
+    }
+    for (int rank = 0; _work_stealing && (int)_victims.size() < _mpi_size; rank++)
+    {
+        if (std::find(_victims.begin(), _victims.end(), rank) == _victims.end())
+        {
+            _victims.push_back(rank);
+        }
+    }
+
+    // Every update of a counter is completed on its own, so the ordering of the atomic
+    // operations does not matter
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "accumulate_ordering", "none");
+    MPI_Info_set(info, "same_disp_unit", "true");
+    bool has_counters = _work_stealing || _mpi_rank == 0;
+    MPI_Win_allocate(has_counters ? 2 * num_slots * sizeof(long) : 0, sizeof(long), info,
+                     MPI_COMM_WORLD, &_slots, &_mpi_window);
+    MPI_Info_free(&info);
+
+    for (int slot = 0; has_counters && slot < num_slots; slot++)
+    {
+        _slots[2 * slot] = 0;
+        _slots[2 * slot + 1] = slot;
+    }
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, _mpi_window);
+
+    _loop_number = -1;
+    _num_iterations = 0;
+    _num_chunks = 0;
+    _chunk = 1;
+    _guided = false;
+    _sequence_chunk = 0;
+    _sequence_first = 0;
+    _victim_index = _victims.size();
+    _slot_ready = false;
+    _lower_bound = 0;
+    _stride = 1;
+    _last = false;
+    _stolen_chunks = 0;
+    _steal_time = 0;
+    _idle_time = 0;
+}
+
+LoopScheduler::~LoopScheduler()
+{
+    MPI_Win_unlock_all(_mpi_window);
+    MPI_Win_free(&_mpi_window);
+}
+
+long LoopScheduler::get_guided_chunk_size(long remaining)
+{
+    long size = std::max(_chunk, (remaining + 2 * _mpi_size - 1) / (2 * _mpi_size));
+    return std::min(size, remaining);
+}
+
+long LoopScheduler::get_block_start(int rank)
+{
+    long size = _num_iterations / _mpi_size;
+    long rest = _num_iterations % _mpi_size;
+    return rank * size + std::min((long)rank, rest);
+}
+
+void LoopScheduler::init(int schedule, long num_iterations, long chunk, long lower_bound,
+                         long stride)
+{
+    schedule &= ~kmp_sch_modifier_mask;
+    _guided = schedule == kmp_sch_guided_chunked ||
+              schedule == kmp_sch_guided_iterative_chunked ||
+              schedule == kmp_sch_guided_analytical_chunked;
+    _chunk = std::max(chunk, 1L);
+    _num_iterations = std::max(num_iterations, 0L);
+
+    if (_work_stealing)
+    {
+        // The deques hold chunks of equal size, guided loops split each block into a few
+        // large chunks and leave the balancing to the steal attempts
+        if (_guided)
+        {
+            long block = (_num_iterations + _mpi_size - 1) / _mpi_size;
+            _chunk = std::max(_chunk, (block + guided_deque_chunks - 1) / guided_deque_chunks);
+        }
+        _num_chunks = 0;
+    }
+    else if (_guided)
+    {
+        _num_chunks = 0;
+        for (long first = 0; first < _num_iterations;
+             first += get_guided_chunk_size(_num_iterations - first))
+        {
+            _num_chunks++;
+        }
+    }
+    else
+    {
+        _num_chunks = (_num_iterations + _chunk - 1) / _chunk;
+    }
+
+    _loop_number++;
+    _sequence_chunk = 0;
+    _sequence_first = 0;
+    _victim_index = 0;
+    _slot_ready = false;
+    _lower_bound = lower_bound;
+    _stride = stride;
+    _last = false;
+
+    Debug(std::cout << "Dispatching " << _num_iterations << " iterations in chunks of "
+                    << _chunk << (_guided ? " (guided)" : "")
+                    << (_work_stealing ? " with work stealing\n" : "\n"););
+}
+
+void LoopScheduler::wait_for_slot(int target)
+{
+    if (_slot_ready)
+    {
+        return;
+    }
+
+    double start = MPI_Wtime();
+    long disp = 2 * (_loop_number % num_slots) + 1;
+    long unused = 0;
+    long next_loop;
+    do
+    {
+        MPI_Fetch_and_op(&unused, &next_loop, MPI_LONG, target, disp, MPI_NO_OP,
+                         _mpi_window);
+        MPI_Win_flush(target, _mpi_window);
+    } while (next_loop < _loop_number);
+    _idle_time += MPI_Wtime() - start;
+    _slot_ready = true;
+}
+
+long LoopScheduler::increment_counter(int target, long increment, long total_increments)
+{
+    wait_for_slot(target);
+
+    long disp = 2 * (_loop_number % num_slots);
+    long value;
+    MPI_Fetch_and_op(&increment, &value, MPI_LONG, target, disp, MPI_SUM, _mpi_window);
+    MPI_Win_flush(target, _mpi_window);
+
+    // All processes are done with the counter, so it can be used by a later loop
+    if ((value & attempt_mask) == total_increments - 1)
+    {
+        long zero = 0;
+        long next_loop = _loop_number + num_slots;
+        MPI_Accumulate(&zero, 1, MPI_LONG, target, disp, 1, MPI_LONG, MPI_REPLACE,
+                       _mpi_window);
+        MPI_Win_flush(target, _mpi_window);
+        MPI_Accumulate(&next_loop, 1, MPI_LONG, target, disp + 1, 1, MPI_LONG, MPI_REPLACE,
+                       _mpi_window);
+        MPI_Win_flush(target, _mpi_window);
+    }
+    return value;
+}
+
+bool LoopScheduler::take_from_deque(int target, long *first, long *count)
+{
+    long block_start = get_block_start(target);
+    long block_end = get_block_start(target + 1);
+    long num_chunks = (block_end - block_start + _chunk - 1) / _chunk;
+
+    // The owner takes chunks from the front and the other processes from the back. An
+    // attempt succeeds if fewer attempts than chunks have been made before it, its chunk
+    // follows from the number of steal attempts before it.
+    bool steal = target != _mpi_rank;
+    double start = MPI_Wtime();
+    long value = increment_counter(target, steal ? 1 + steal_increment : 1,
+                                   num_chunks + _mpi_size);
+    long attempts = value & attempt_mask;
+    long steals = value / steal_increment;
+    if (attempts >= num_chunks)
+    {
+        if (steal)
+        {
+            _idle_time += MPI_Wtime() - start;
+        }
+        return false;
+    }
+
+    long chunk_number = steal ? num_chunks - 1 - steals : attempts - steals;
+    *first = block_start + chunk_number * _chunk;
+    *count = std::min(_chunk, block_end - *first);
+    if (steal)
+    {
+        _stolen_chunks++;
+        _steal_time += MPI_Wtime() - start;
+    }
+    return true;
+}
+
+bool LoopScheduler::next(long *first, long *count)
+{
+    while (_victim_index < (int)_victims.size())
+    {
+        int target = _victims[_victim_index];
+        if (_work_stealing)
+        {
+            if (take_from_deque(target, first, count))
+            {
+                _last = *first + *count == _num_iterations;
+                return true;
+            }
+        }
+        else
+        {
+            long chunk_number = increment_counter(target, 1, _num_chunks + _mpi_size);
+            if (chunk_number < _num_chunks)
+            {
+                if (_guided)
+                {
+                    while (_sequence_chunk < chunk_number)
+                    {
+                        _sequence_first +=
+                            get_guided_chunk_size(_num_iterations - _sequence_first);
+                        _sequence_chunk++;
+                    }
+                    *first = _sequence_first;
+                    *count = get_guided_chunk_size(_num_iterations - _sequence_first);
+                }
+                else
+                {
+                    *first = chunk_number * _chunk;
+                    *count = std::min(_chunk, _num_iterations - *first);
+                }
+                _last = *first + *count == _num_iterations;
+                return true;
+            }
+        }
+
+        // The counter is exhausted, continue with the next victim
+        _victim_index++;
+        _slot_ready = false;
+    }
+    return false;
+}
+
+long LoopScheduler::get_lower_bound() { return _lower_bound; }
+
+long LoopScheduler::get_stride() { return _stride; }
+
+bool LoopScheduler::is_last() { return _last; }
+
+void LoopScheduler::report_statistics()
+{
+    if (!_work_stealing)
+    {
+        return;
+    }
+
+    double local_times[2] = {_steal_time, _idle_time};
+    double times[2], max_times[2];
+    long stolen_chunks;
+    MPI_Reduce(local_times, times, 2, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Reduce(local_times, max_times, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&_stolen_chunks, &stolen_chunks, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (_mpi_rank == 0)
+    {
+        std::cerr << "CATO work stealing: " << stolen_chunks << " chunks stolen, steal time "
+                  << times[0] << " s (max " << max_times[0] << " s per process), idle time "
+                  << times[1] << " s (max " << max_times[1] << " s per process)\n";
+    }
+}
@@ -0,0 +1,138 @@
+#ifndef CATO_RTLIB_LOOP_SCHEDULER_H
+#define CATO_RTLIB_LOOP_SCHEDULER_H
+
+#include <mpi.h>
+
+#include <vector>
+
+/**
+ * Distributes the iterations of parallel for loops with a dynamic or guided schedule over
+ * all MPI processes at runtime.
+ *
+ * The iterations of a loop are split into a fixed sequence of chunks, which every process
+ * computes on its own. The processes take the chunks by incrementing a chunk counter with
+ * MPI_Fetch_and_op. Every process keeps taking chunks until it gets a number past the last
+ * chunk, so each loop increments a counter exactly its number of chunks plus the number of
+ * processes times. The process that does the last increment resets the counter.
+ *
+ * By default there is one global counter on rank 0. With CATO_WORK_STEALING=1 every
+ * process starts with its block of the static schedule as a deque of chunks instead. It
+ * takes the chunks from the front of its own deque and, once that is empty, steals chunks
+ * from the back of the deques of the other processes, nearest rank first, so the blocks
+ * mostly stay with the process that stores their data.
+ *
+ * As in the OpenMP runtime library, consecutive loops use a ring of counters, so a process
+ * can start the next loops while the others are still finishing the current one. A counter
+ * is only used again once all processes are done with it.
+ **/
+class LoopScheduler
+{
+  private:
+    MPI_Win _mpi_window;
+
+    // The counters of each process: every slot of the ring holds the counter and the
+    // number of the next loop that may use it
+    long *_slots;
+
+    int _mpi_rank, _mpi_size;
+
+    bool _work_stealing;
+
+    // Number of loops started so far, the current loop uses the slot
+    // _loop_number % num_slots
+    long _loop_number;
+
+    long _num_iterations, _num_chunks, _chunk;
+
+    bool _guided;
+
+    // Number and first iteration of the next chunk in the sequence of a guided loop. The
+    // chunks taken by one process are increasing, so the sequence only has to be walked
+    // forward.
+    long _sequence_chunk, _sequence_first;
+
+    // Processes whose counter is taken chunks from, in the order of the steal attempts.
+    // Without work stealing this is only rank 0.
+    std::vector<int> _victims;
+
+    // Index in _victims of the counter this process currently takes chunks from
+    int _victim_index;
+
+    // True once the slot of the current loop has been released on the current victim
+    bool _slot_ready;
+
+    // Lower bound and stride of the current loop
+    long _lower_bound, _stride;
+
+    // True if the last chunk taken by this process contains the last iteration
+    bool _last;
+
+    // Number of stolen chunks, time spent on steal attempts that got a chunk and time spent
+    // on attempts that got nothing or waiting for a counter to be released, in seconds
+    long _stolen_chunks;
+    double _steal_time, _idle_time;
+
+    /**
+     * Returns the size of a guided chunk if remaining iterations are left
+     **/
+    long get_guided_chunk_size(long remaining);
+
+    /**
+     * Returns the first iteration of the block of the static schedule of the process
+     **/
+    long get_block_start(int rank);
+
+    /**
+     * Waits until the slot of the current loop on the target process has been released
+     **/
+    void wait_for_slot(int target);
+
+    /**
+     * Increments the counter of the current loop on the target process and returns its
+     * previous value. total_increments is the number of increments of the counter in the
+     * loop, the last one resets the counter and releases the slot.
+     **/
+    long increment_counter(int target, long increment, long total_increments);
+
+    /**
+     * Tries to take a chunk from the deque of the target process. Returns false if the
+     * deque is empty.
+     **/
+    bool take_from_deque(int target, long *first, long *count);
+
+  public:
+    /**
+     * Creates the window for the counters. Has to be called by all processes.
+     **/
+    LoopScheduler();
+
+    ~LoopScheduler();
+
+    /**
+     * Starts a new loop with num_iterations iterations. schedule is the OpenMP schedule
+     * type of the loop, guided schedules use chunks that shrink with the remaining
+     * iterations but are never smaller than chunk.
+     **/
+    void init(int schedule, long num_iterations, long chunk, long lower_bound, long stride);
+
+    /**
+     * Takes the next chunk of the current loop. Returns false if all chunks have been
+     * taken, otherwise first is the number of the first iteration of the chunk and count
+     * the number of iterations in it. Every process has to call it until it returns false.
+     **/
+    bool next(long *first, long *count);
+
+    long get_lower_bound();
+
+    long get_stride();
+
+    bool is_last();
+
+    /**
+     * Prints the number of stolen chunks and the steal and idle times if work stealing is
+     * enabled. Has to be called by all processes.
+     **/
+    void report_statistics();
+};
+
+#endif
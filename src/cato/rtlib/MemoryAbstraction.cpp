@@ -1,6 +1,7 @@
 #include "MemoryAbstraction.h"
 
 #include "../debug.h"
+#include <algorithm>
 #include <iostream>
 #include <stdlib.h>
 
@@ -10,28 +11,130 @@ MemoryAbstraction::MemoryAbstraction(long size, MPI_Datatype type, int dimension
     _size_bytes = size;
     _type = type;
     _dimensions = dimensions;
+    _table_row = -1;
+    _table_num_rows = 0;
 }
 
 MemoryAbstraction::~MemoryAbstraction() {}
 
-void MemoryAbstraction::store(void *base_ptr, void *value_ptr, std::vector<long> indices) {}
+void MemoryAbstraction::store(void *base_ptr, void *value_ptr, IndexSpan indices) {}
 
-void MemoryAbstraction::load(void *base_ptr, void *dest_ptr, std::vector<long> indices) {}
+void MemoryAbstraction::load(void *base_ptr, void *dest_ptr, IndexSpan indices) {}
 
-void MemoryAbstraction::sequential_store(void *base_ptr, void *value_ptr,
-                                         std::vector<long> indices)
+void MemoryAbstraction::sequential_store(void *base_ptr, void *value_ptr, IndexSpan indices)
 {
 }
 
-void MemoryAbstraction::sequential_load(void *base_ptr, void *dest_ptr,
-                                        std::vector<long> indices)
+void MemoryAbstraction::sequential_load(void *base_ptr, void *dest_ptr, IndexSpan indices)
 {
 }
 
+void MemoryAbstraction::store_range(void *base_ptr, void *value_ptr, long start, long count)
+{
+}
+
+void MemoryAbstraction::load_range(void *base_ptr, void *dest_ptr, long start, long count) {}
+
+void MemoryAbstraction::accumulate(void *base_ptr, void *value_ptr, void *result_ptr,
+                                   IndexSpan indices, MPI_Op op, MPI_Datatype type)
+{
+}
+
+void MemoryAbstraction::compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr,
+                                         void *result_ptr, IndexSpan indices,
+                                         MPI_Datatype type)
+{
+}
+
+void MemoryAbstraction::epoch_begin() {}
+
+void MemoryAbstraction::epoch_end() {}
+
+void MemoryAbstraction::flush() {}
+
+void MemoryAbstraction::invalidate_cache() {}
+
+void MemoryAbstraction::exchange_halo(long start, long end) {}
+
+long MemoryAbstraction::get_row_elements() { return 1; }
+
+int MemoryAbstraction::get_owner(long index) { return -1; }
+
+void *MemoryAbstraction::get_local_address(long index) { return nullptr; }
+
+void MemoryAbstraction::synchronize_local_stores() {}
+
+void MemoryAbstraction::create_snapshot(int reader) {}
+
+bool MemoryAbstraction::has_snapshot() { return false; }
+
+bool MemoryAbstraction::is_snapshot_written() { return false; }
+
+bool MemoryAbstraction::is_snapshot_complete() { return false; }
+
+void MemoryAbstraction::drop_snapshot() {}
+
 void MemoryAbstraction::pointer_store(void *source_ptr, long dest_index) {}
 
+void MemoryAbstraction::add_row_reference(long offset, long row, long num_rows)
+{
+    if (offset != 0)
+    {
+        // The rows of the object itself are referenced, so it is not a single row
+        _table_row = -1;
+        _table_num_rows = -1;
+    }
+    else if (_table_num_rows >= 0)
+    {
+        _table_row = row;
+        _table_num_rows = num_rows;
+    }
+}
+
+bool MemoryAbstraction::get_table_row(long *row, long *num_rows)
+{
+    *row = _table_row;
+    *num_rows = _table_num_rows;
+    return _table_row >= 0;
+}
+
+void MemoryAbstraction::materialize() {}
+
+void MemoryAbstraction::set_sub_abstraction(long index, MemoryAbstraction *sub_abstraction,
+                                            long offset)
+{
+    if (index >= (long)_sub_abstractions.size())
+    {
+        _sub_abstractions.resize(index + 1, {nullptr, 0});
+    }
+    _sub_abstractions[index] = {sub_abstraction, offset};
+}
+
+MemoryAbstraction *MemoryAbstraction::get_sub_abstraction(long index, long *offset)
+{
+    if (index < 0 || index >= (long)_sub_abstractions.size())
+    {
+        return nullptr;
+    }
+    *offset = _sub_abstractions[index].second;
+    return _sub_abstractions[index].first;
+}
+
+void MemoryAbstraction::remove_sub_abstraction(MemoryAbstraction *sub_abstraction)
+{
+    for (auto &entry : _sub_abstractions)
+    {
+        if (entry.first == sub_abstraction)
+        {
+            entry = {nullptr, 0};
+        }
+    }
+}
+
 void *MemoryAbstraction::get_base_ptr() { return _base_ptr; }
 
 long MemoryAbstraction::get_size_bytes() { return _size_bytes; }
 
 MPI_Datatype MemoryAbstraction::get_type() { return _type; }
+
+int MemoryAbstraction::get_dimensions() { return _dimensions; }
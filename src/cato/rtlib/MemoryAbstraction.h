@@ -2,7 +2,9 @@
 #define CATO_RTLIB_MEMORY_ABSTRACTION_H
 
 #include "../debug.h"
+#include "IndexSpan.h"
 #include <mpi.h>
+#include <utility>
 #include <vector>
 
 /**
@@ -22,6 +24,16 @@ class MemoryAbstraction
 
     int _dimensions;
 
+    // Shared memory objects whose (interior) pointers are stored in this object, by their
+    // index, together with the element offset of the stored pointer in that object.
+    // Only used for objects with a pointer depth >= 2.
+    std::vector<std::pair<MemoryAbstraction *, long>> _sub_abstractions;
+
+    // Row of this object in the rows of the outermost pointer table that references it
+    // at its first element, and the total number of rows of that table. The row is -1 if
+    // it is unknown or the object is also referenced at other elements.
+    long _table_row, _table_num_rows;
+
   public:
     /**
      * Constructor needs the size of the allocated memory in bytes
@@ -42,14 +54,14 @@ class MemoryAbstraction
      * This gets called from prallelized sections of the original
      * program.
      **/
-    virtual void store(void *base_ptr, void *value_ptr, std::vector<long> indices);
+    virtual void store(void *base_ptr, void *value_ptr, IndexSpan indices);
 
     /**
      * A load from the shared memory object.
      * This gets called from prallelized sections of the original
      * program.
      **/
-    virtual void load(void *base_ptr, void *dest_ptr, std::vector<long> indices);
+    virtual void load(void *base_ptr, void *dest_ptr, IndexSpan indices);
 
     /**
      * A store to the shared memory object.
@@ -58,7 +70,7 @@ class MemoryAbstraction
      * that it can be called by all MPI processes simultaniously and that
      * this is a synchronous operation between all processes.
      **/
-    virtual void sequential_store(void *base_ptr, void *value_ptr, std::vector<long> indices);
+    virtual void sequential_store(void *base_ptr, void *value_ptr, IndexSpan indices);
 
     /**
      * A load from the shared memory object.
@@ -67,18 +79,174 @@ class MemoryAbstraction
      * that it can be called by all MPI processes simultaniously and that
      * this is a synchronous operation between all processes.
      **/
-    virtual void sequential_load(void *base_ptr, void *dest_ptr, std::vector<long> indices);
+    virtual void sequential_load(void *base_ptr, void *dest_ptr, IndexSpan indices);
+
+    /**
+     * A store of count consecutive elements, starting at the element offset start.
+     * This gets called from parallelized sections of the original program for
+     * contiguous loop accesses, which the pass has combined into one transfer.
+     **/
+    virtual void store_range(void *base_ptr, void *value_ptr, long start, long count);
+
+    /**
+     * A load of count consecutive elements, starting at the element offset start.
+     * This gets called from parallelized sections of the original program for
+     * contiguous loop accesses, which the pass has combined into one transfer.
+     **/
+    virtual void load_range(void *base_ptr, void *dest_ptr, long start, long count);
+
+    /**
+     * An atomic update of the element at the given indices, which combines it with the
+     * value at value_ptr using the reduction operation op. The values are interpreted as
+     * the given type, which has the size of the element type. If result_ptr is not nullptr
+     * the value of the element before the update is copied to it.
+     * This gets called for OpenMP atomic constructs in parallelized sections.
+     **/
+    virtual void accumulate(void *base_ptr, void *value_ptr, void *result_ptr,
+                            IndexSpan indices, MPI_Op op, MPI_Datatype type);
+
+    /**
+     * Atomically replaces the element at the given indices with the value at value_ptr if
+     * it equals the value at compare_ptr. The value of the element before the operation is
+     * copied to result_ptr. type is an integer type with the size of the element type.
+     **/
+    virtual void compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr,
+                                  void *result_ptr, IndexSpan indices, MPI_Datatype type);
+
+    /**
+     * Opens a passive target epoch for the whole parallel section. Until epoch_end is
+     * called, stores and loads do not need to synchronize with their target on their own.
+     **/
+    virtual void epoch_begin();
+
+    /**
+     * Completes all outstanding operations and closes the passive target epoch
+     **/
+    virtual void epoch_end();
+
+    /**
+     * Completes all outstanding operations of the current epoch, so that they are visible
+     * to all other processes after the next synchronization (barrier, critical section).
+     **/
+    virtual void flush();
+
+    /**
+     * Drops all locally cached copies of remote elements, so that the following loads see
+     * the stores other processes have completed before the last synchronization.
+     **/
+    virtual void invalidate_cache();
+
+    /**
+     * Copies the elements in [start, end) that are stored by other processes into ghost
+     * cells, with one bulk transfer per owner. Until the end of the current epoch, loads
+     * of those elements are served from the ghost cells.
+     * This gets called at the start of parallel for loops that read neighbouring elements.
+     **/
+    virtual void exchange_halo(long start, long end);
+
+    /**
+     * Returns the number of consecutive elements that are always stored by one process
+     **/
+    virtual long get_row_elements();
+
+    /**
+     * Returns the process that stores the element at index, or -1 if the elements are not
+     * distributed over the processes
+     **/
+    virtual int get_owner(long index);
+
+    /**
+     * Returns the address of the element at index in the local memory of this process, or
+     * nullptr if another process stores it. Values written directly to that address are
+     * only visible to the other processes after synchronize_local_stores.
+     **/
+    virtual void *get_local_address(long index);
+
+    /**
+     * Makes the values written through get_local_address visible to all processes.
+     * Has to be called by all processes.
+     **/
+    virtual void synchronize_local_stores();
+
+    /**
+     * Copies the whole object into a snapshot on the process reader, or on all processes if
+     * reader is -1. Until the object is written again, sequential loads are served from the
+     * snapshot without synchronizing the processes. Has to be called by all processes.
+     **/
+    virtual void create_snapshot(int reader);
+
+    /**
+     * Returns true if the object has a snapshot. This is the same on all processes.
+     **/
+    virtual bool has_snapshot();
+
+    /**
+     * Returns true if this process has written to the object since its snapshot was created
+     **/
+    virtual bool is_snapshot_written();
+
+    /**
+     * Returns true if all processes hold the values of the snapshot. The other processes
+     * read the elements from their owners while the snapshot exists.
+     **/
+    virtual bool is_snapshot_complete();
+
+    /**
+     * Frees the snapshot, the following sequential loads synchronize all processes again.
+     * Has to be called by all processes.
+     **/
+    virtual void drop_snapshot();
 
     /**
      * A pointer store to an MemoryAbstraction with pointer depth >= 2.
      **/
     virtual void pointer_store(void *source_ptr, long dest_index);
 
+    /**
+     * Tells the shared memory object that a pointer to its element at offset is stored as
+     * the given row of a pointer table with num_rows rows. The row references describe
+     * the extents of 2D and 3D arrays and are used to distribute them by rows.
+     * References at offset 0 also place the object in the rows of the pointer tables.
+     **/
+    virtual void add_row_reference(long offset, long row, long num_rows);
+
+    /**
+     * Returns the row of this object in the outermost pointer table and the number of rows
+     * of that table, see add_row_reference. Returns false if it is unknown.
+     **/
+    bool get_table_row(long *row, long *num_rows);
+
+    /**
+     * Allocates the memory of the shared memory object, if that has been deferred until
+     * its distribution is known. Has to be called by all processes.
+     **/
+    virtual void materialize();
+
+    /**
+     * Remembers that a pointer to the element at offset of sub_abstraction is stored at
+     * the given index.
+     **/
+    void set_sub_abstraction(long index, MemoryAbstraction *sub_abstraction, long offset);
+
+    /**
+     * Returns the shared memory object that the pointer stored at the given index points
+     * into or nullptr if the stored pointer does not belong to a shared memory object.
+     * The element offset of the pointer inside of that object is written to offset.
+     **/
+    MemoryAbstraction *get_sub_abstraction(long index, long *offset);
+
+    /**
+     * Forgets all references to sub_abstraction, which is about to be freed.
+     **/
+    void remove_sub_abstraction(MemoryAbstraction *sub_abstraction);
+
     virtual void *get_base_ptr();
 
     virtual long get_size_bytes();
 
     virtual MPI_Datatype get_type();
+
+    int get_dimensions();
 };
 
 #endif
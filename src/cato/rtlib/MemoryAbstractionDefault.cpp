@@ -1,19 +1,67 @@
 #include "MemoryAbstractionDefault.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <numeric>
 #include <stdio.h>
+#include <sys/mman.h>
 
 #include "../debug.h"
 #include "CatoRuntimeLogger.h"
 
+/**
+ * Returns false if CATO_WINDOW_ALLOCATE is set to 0, then partitions that are not shared
+ * within a node are allocated with malloc and exposed with MPI_Win_create instead of
+ * MPI_Win_allocate, to compare both
+ **/
+static bool window_allocation_enabled()
+{
+    static bool enabled = []() {
+        const char *value = std::getenv("CATO_WINDOW_ALLOCATE");
+        return value == nullptr || std::atoi(value) != 0;
+    }();
+    return enabled;
+}
+
 MemoryAbstractionDefault::MemoryAbstractionDefault(long size, MPI_Datatype type,
                                                    int dimensions)
     : MemoryAbstraction(size, type, dimensions)
 {
+    _epoch_open = false;
+    _materialized = false;
+    _local_ptr = nullptr;
+    _node_window = MPI_WIN_NULL;
+    _row_elements = 0;
+    _owner = -1;
+    _has_snapshot = false;
+    _snapshot_holder = -1;
+    _snapshot_written = false;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);
+
     if (dimensions == 1)
     {
-        create_1d_array(size, type, dimensions);
+        // Only the address range of the whole object is reserved here. It makes the base
+        // pointer and pointers into the rows unique, the memory is allocated in materialize.
+        _base_ptr = mmap(nullptr, std::max(size, 1L), PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (_base_ptr == MAP_FAILED)
+        {
+            std::cerr << "Error: Could not reserve memory for a shared memory object\n";
+            exit(1);
+        }
+
+        if (auto *logger = CatoRuntimeLogger::get_logger())
+        {
+            std::string message = std::string("Reserved 1D MemoryAbstractionDefault:\n") +
+                                  "   base ptr: " + std::to_string((long)_base_ptr) + "\n" +
+                                  "   byte size: " + std::to_string(size);
+            *logger << message;
+        }
     }
     else if (dimensions == 2)
     {
@@ -62,16 +110,31 @@ MemoryAbstractionDefault::~MemoryAbstractionDefault()
 
     if (_dimensions == 1)
     {
-        MPI_Barrier(MPI_COMM_WORLD);
-        Debug(std::cout << "Freeing MemoryAbstractionDefault at address: " << _base_ptr
-                        << "\n");
-        MPI_Win_free(&_mpi_window);
-
-        if (_base_ptr != nullptr)
+        if (_materialized)
         {
-            free(_base_ptr);
-            _base_ptr = nullptr;
+            if (_epoch_open)
+            {
+                epoch_end();
+            }
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            Debug(std::cout << "Freeing MemoryAbstractionDefault at address: " << _base_ptr
+                            << "\n");
+            // The partition is freed together with the window that allocated it
+            MPI_Win_free(&_mpi_window);
+            if (_node_window != MPI_WIN_NULL)
+            {
+                MPI_Win_free(&_node_window);
+            }
+            else if (!window_allocation_enabled())
+            {
+                free(_local_ptr);
+            }
+            _local_ptr = nullptr;
         }
+
+        munmap(_base_ptr, std::max(_size_bytes, 1L));
+        _base_ptr = nullptr;
     }
     else if (_dimensions == 2)
     {
@@ -96,11 +159,11 @@ MemoryAbstractionDefault::~MemoryAbstractionDefault()
     }
 }
 
-void MemoryAbstractionDefault::store(void *base_ptr, void *value_ptr,
-                                     std::vector<long> indices)
+void MemoryAbstractionDefault::store(void *base_ptr, void *value_ptr, IndexSpan indices)
 {
     if (_dimensions == 1)
     {
+        _snapshot_written = true;
         if (indices.size() == 1)
         {
             auto rank_and_disp = get_target_rank_and_disp_for_offset(indices[0]);
@@ -116,18 +179,48 @@ void MemoryAbstractionDefault::store(void *base_ptr, void *value_ptr,
                 *logger << message;
             }
 
-            MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank_and_disp.first, 0, _mpi_window);
+            if (_read_cache != nullptr)
+            {
+                _read_cache->update(indices[0], 1, value_ptr);
+            }
+            update_ghost_cells(indices[0], 1, value_ptr);
+
+            if (is_node_local(rank_and_disp.first))
+            {
+                local_store(rank_and_disp.first, value_ptr, rank_and_disp.second, 1);
+            }
+            else if (_epoch_open && _store_buffer != nullptr)
+            {
+                if (_store_buffer->add(rank_and_disp.first, rank_and_disp.second, value_ptr))
+                {
+                    flush_store_buffer(rank_and_disp.first);
+                }
+            }
+            else if (_epoch_open)
+            {
+                // Accumulate operations from the same origin are ordered, so no remote
+                // completion is needed here. The value buffer is reused by the caller
+                // which makes local completion necessary.
+                MPI_Accumulate(value_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second,
+                               1, _type, MPI_REPLACE, _mpi_window);
+                MPI_Win_flush_local(rank_and_disp.first, _mpi_window);
+                _pending_stores[rank_and_disp.first] = true;
+            }
+            else
+            {
+                MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank_and_disp.first, 0, _mpi_window);
 
-            // if(_mpi_rank != rank_and_disp.first)
-            // {
-            //     std::cout << "PUT TO DIFFERENT RANKS MEMEORY\n";
-            // }
+                // if(_mpi_rank != rank_and_disp.first)
+                // {
+                //     std::cout << "PUT TO DIFFERENT RANKS MEMEORY\n";
+                // }
 
-            MPI_Put(value_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second, 1, _type,
-                    _mpi_window);
-            // TODO check if flush does something
-            // MPI_Win_flush(rank_and_disp.first, _mpi_window);
-            MPI_Win_unlock(rank_and_disp.first, _mpi_window);
+                MPI_Put(value_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second, 1,
+                        _type, _mpi_window);
+                // TODO check if flush does something
+                // MPI_Win_flush(rank_and_disp.first, _mpi_window);
+                MPI_Win_unlock(rank_and_disp.first, _mpi_window);
+            }
         }
         else
         {
@@ -136,7 +229,7 @@ void MemoryAbstractionDefault::store(void *base_ptr, void *value_ptr,
     }
 }
 
-void MemoryAbstractionDefault::load(void *base_ptr, void *dest_ptr, std::vector<long> indices)
+void MemoryAbstractionDefault::load(void *base_ptr, void *dest_ptr, IndexSpan indices)
 {
     if (_dimensions == 1)
     {
@@ -155,10 +248,33 @@ void MemoryAbstractionDefault::load(void *base_ptr, void *dest_ptr, std::vector<
                 *logger << message;
             }
 
-            MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank_and_disp.first, 0, _mpi_window);
-            MPI_Get(dest_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second, 1, _type,
-                    _mpi_window);
-            MPI_Win_unlock(rank_and_disp.first, _mpi_window);
+            char *ghost = nullptr;
+            if (is_node_local(rank_and_disp.first))
+            {
+                local_load(rank_and_disp.first, dest_ptr, rank_and_disp.second, 1);
+            }
+            else if ((ghost = find_ghost_cells(indices[0], 1)) != nullptr)
+            {
+                std::memcpy(dest_ptr, ghost, _type_size);
+            }
+            else if (_epoch_open && _read_cache != nullptr)
+            {
+                cached_load(dest_ptr, indices[0]);
+            }
+            else if (_epoch_open)
+            {
+                flush_store_buffer(rank_and_disp.first);
+                MPI_Get_accumulate(nullptr, 0, _type, dest_ptr, 1, _type, rank_and_disp.first,
+                                   rank_and_disp.second, 1, _type, MPI_NO_OP, _mpi_window);
+                MPI_Win_flush_local(rank_and_disp.first, _mpi_window);
+            }
+            else
+            {
+                MPI_Win_lock(MPI_LOCK_EXCLUSIVE, rank_and_disp.first, 0, _mpi_window);
+                MPI_Get(dest_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second, 1,
+                        _type, _mpi_window);
+                MPI_Win_unlock(rank_and_disp.first, _mpi_window);
+            }
         }
         else
         {
@@ -168,7 +284,7 @@ void MemoryAbstractionDefault::load(void *base_ptr, void *dest_ptr, std::vector<
 }
 
 void MemoryAbstractionDefault::sequential_store(void *base_ptr, void *value_ptr,
-                                                std::vector<long> indices)
+                                                IndexSpan indices)
 {
     if (_dimensions == 1)
     {
@@ -187,6 +303,7 @@ void MemoryAbstractionDefault::sequential_store(void *base_ptr, void *value_ptr,
                 *logger << message;
             }
 
+            drop_snapshot();
             MPI_Win_fence(0, _mpi_window);
             if (_mpi_rank == rank_and_disp.first)
             {
@@ -204,7 +321,7 @@ void MemoryAbstractionDefault::sequential_store(void *base_ptr, void *value_ptr,
 }
 
 void MemoryAbstractionDefault::sequential_load(void *base_ptr, void *dest_ptr,
-                                               std::vector<long> indices)
+                                               IndexSpan indices)
 {
     if (_dimensions == 1)
     {
@@ -223,6 +340,22 @@ void MemoryAbstractionDefault::sequential_load(void *base_ptr, void *dest_ptr,
                 *logger << message;
             }
 
+            // Nobody writes to the object while it has a snapshot, so the loads need no
+            // synchronization
+            if (_has_snapshot && (_snapshot_holder < 0 || _snapshot_holder == _mpi_rank))
+            {
+                std::memcpy(dest_ptr, _snapshot.data() + indices[0] * _type_size, _type_size);
+                return;
+            }
+            else if (_has_snapshot)
+            {
+                MPI_Win_lock(MPI_LOCK_SHARED, rank_and_disp.first, 0, _mpi_window);
+                MPI_Get(dest_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second, 1,
+                        _type, _mpi_window);
+                MPI_Win_unlock(rank_and_disp.first, _mpi_window);
+                return;
+            }
+
             MPI_Win_fence(0, _mpi_window);
             MPI_Get(dest_ptr, 1, _type, rank_and_disp.first, rank_and_disp.second, 1, _type,
                     _mpi_window);
@@ -237,20 +370,652 @@ void MemoryAbstractionDefault::sequential_load(void *base_ptr, void *dest_ptr,
     }
 }
 
-std::pair<int, long> MemoryAbstractionDefault::get_target_rank_and_disp_for_offset(long offset)
+void MemoryAbstractionDefault::store_range(void *base_ptr, void *value_ptr, long start,
+                                           long count)
+{
+    if (_dimensions == 1)
+    {
+        _snapshot_written = true;
+        int type_size;
+        MPI_Type_size(_type, &type_size);
+
+        // Parts of the range that lie outside of the array are skipped
+        long from = std::max(start, 0L);
+        long to = std::min(start + count, _global_num_elements);
+        char *source = (char *)value_ptr + (from - start) * type_size;
+
+        if (auto *logger = CatoRuntimeLogger::get_logger())
+        {
+            std::string message =
+                std::string("Range store in 1D MemoryAbstractionDefault:\n") +
+                "   base ptr: " + std::to_string((long)_base_ptr) + "\n" +
+                "   global element count: " + std::to_string(_global_num_elements) + "\n" +
+                "   range start: " + std::to_string(from) + "\n" +
+                "   range count: " + std::to_string(to - from);
+            *logger << message;
+        }
+
+        if (_read_cache != nullptr && from < to)
+        {
+            _read_cache->update(from, to - from, source);
+        }
+        if (from < to)
+        {
+            update_ghost_cells(from, to - from, source);
+        }
+
+        // Split the range at the partition borders so that each owner gets one MPI_Put
+        while (from < to)
+        {
+            auto rank_and_disp = get_target_rank_and_disp_for_offset(from);
+            int target = rank_and_disp.first;
+            long chunk = std::min(to, _array_ranges[target].second + 1) - from;
+            chunk = std::min(chunk, (long)INT_MAX);
+
+            if (is_node_local(target))
+            {
+                local_store(target, source, rank_and_disp.second, chunk);
+            }
+            else if (_epoch_open)
+            {
+                // Puts are not ordered with earlier single element stores
+                flush_store_buffer(target);
+                if (_pending_stores[target])
+                {
+                    MPI_Win_flush(target, _mpi_window);
+                    _pending_stores[target] = false;
+                }
+                MPI_Put(source, chunk, _type, target, rank_and_disp.second, chunk, _type,
+                        _mpi_window);
+                MPI_Win_flush(target, _mpi_window);
+            }
+            else
+            {
+                MPI_Win_lock(MPI_LOCK_EXCLUSIVE, target, 0, _mpi_window);
+                MPI_Put(source, chunk, _type, target, rank_and_disp.second, chunk, _type,
+                        _mpi_window);
+                MPI_Win_unlock(target, _mpi_window);
+            }
+
+            source += chunk * type_size;
+            from += chunk;
+        }
+    }
+    else
+    {
+        std::cerr
+            << "MemoryAbstractionDefault does not support range stores for > 1D arrays\n";
+    }
+}
+
+void MemoryAbstractionDefault::load_range(void *base_ptr, void *dest_ptr, long start,
+                                          long count)
 {
     if (_dimensions == 1)
     {
-        std::pair<int, long> ret;
-        for (int i = 0; i < _mpi_size; i++)
+        int type_size;
+        MPI_Type_size(_type, &type_size);
+
+        // Parts of the range that lie outside of the array are skipped
+        long from = std::max(start, 0L);
+        long to = std::min(start + count, _global_num_elements);
+        char *dest = (char *)dest_ptr + (from - start) * type_size;
+
+        if (auto *logger = CatoRuntimeLogger::get_logger())
+        {
+            std::string message =
+                std::string("Range load in 1D MemoryAbstractionDefault:\n") +
+                "   base ptr: " + std::to_string((long)_base_ptr) + "\n" +
+                "   global element count: " + std::to_string(_global_num_elements) + "\n" +
+                "   range start: " + std::to_string(from) + "\n" +
+                "   range count: " + std::to_string(to - from);
+            *logger << message;
+        }
+
+        // Split the range at the partition borders so that each owner gets one MPI_Get
+        while (from < to)
+        {
+            auto rank_and_disp = get_target_rank_and_disp_for_offset(from);
+            int target = rank_and_disp.first;
+            long chunk = std::min(to, _array_ranges[target].second + 1) - from;
+            chunk = std::min(chunk, (long)INT_MAX);
+
+            char *ghost = nullptr;
+            if (is_node_local(target))
+            {
+                local_load(target, dest, rank_and_disp.second, chunk);
+            }
+            else if ((ghost = find_ghost_cells(from, chunk)) != nullptr)
+            {
+                std::memcpy(dest, ghost, chunk * type_size);
+            }
+            else if (_epoch_open)
+            {
+                // Gets are not ordered with earlier single element stores
+                flush_store_buffer(target);
+                if (_pending_stores[target])
+                {
+                    MPI_Win_flush(target, _mpi_window);
+                    _pending_stores[target] = false;
+                }
+                MPI_Get(dest, chunk, _type, target, rank_and_disp.second, chunk, _type,
+                        _mpi_window);
+                MPI_Win_flush_local(target, _mpi_window);
+            }
+            else
+            {
+                MPI_Win_lock(MPI_LOCK_EXCLUSIVE, target, 0, _mpi_window);
+                MPI_Get(dest, chunk, _type, target, rank_and_disp.second, chunk, _type,
+                        _mpi_window);
+                MPI_Win_unlock(target, _mpi_window);
+            }
+
+            dest += chunk * type_size;
+            from += chunk;
+        }
+    }
+    else
+    {
+        std::cerr << "MemoryAbstractionDefault does not support range loads for > 1D arrays\n";
+    }
+}
+
+void MemoryAbstractionDefault::accumulate(void *base_ptr, void *value_ptr, void *result_ptr,
+                                          IndexSpan indices, MPI_Op op, MPI_Datatype type)
+{
+    if (_dimensions != 1 || indices.size() != 1)
+    {
+        std::cerr << "MemoryAbstractionDefault does not support atomics on > 1D arrays\n";
+        return;
+    }
+
+    _snapshot_written = true;
+    auto rank_and_disp = get_target_rank_and_disp_for_offset(indices[0]);
+    int target = rank_and_disp.first;
+
+    // The new value is only known to the owner
+    if (_read_cache != nullptr)
+    {
+        _read_cache->remove(indices[0]);
+    }
+
+    if (_epoch_open)
+    {
+        flush_store_buffer(target);
+    }
+    else
+    {
+        MPI_Win_lock(MPI_LOCK_SHARED, target, 0, _mpi_window);
+    }
+
+    if (result_ptr != nullptr)
+    {
+        MPI_Fetch_and_op(value_ptr, result_ptr, type, target, rank_and_disp.second, op,
+                         _mpi_window);
+    }
+    else
+    {
+        MPI_Accumulate(value_ptr, 1, type, target, rank_and_disp.second, 1, type, op,
+                       _mpi_window);
+    }
+
+    if (!_epoch_open)
+    {
+        MPI_Win_unlock(target, _mpi_window);
+    }
+    else if (is_node_local(target))
+    {
+        // Loads of node local elements read the memory directly, so the update has to be
+        // completed at the target before them
+        MPI_Win_flush(target, _mpi_window);
+    }
+    else
+    {
+        MPI_Win_flush_local(target, _mpi_window);
+        _pending_stores[target] = true;
+    }
+}
+
+void MemoryAbstractionDefault::compare_and_swap(void *base_ptr, void *value_ptr,
+                                                void *compare_ptr, void *result_ptr,
+                                                IndexSpan indices, MPI_Datatype type)
+{
+    if (_dimensions != 1 || indices.size() != 1)
+    {
+        std::cerr << "MemoryAbstractionDefault does not support atomics on > 1D arrays\n";
+        return;
+    }
+
+    _snapshot_written = true;
+    auto rank_and_disp = get_target_rank_and_disp_for_offset(indices[0]);
+    int target = rank_and_disp.first;
+
+    if (_read_cache != nullptr)
+    {
+        _read_cache->remove(indices[0]);
+    }
+
+    if (_epoch_open)
+    {
+        flush_store_buffer(target);
+    }
+    else
+    {
+        MPI_Win_lock(MPI_LOCK_SHARED, target, 0, _mpi_window);
+    }
+
+    MPI_Compare_and_swap(value_ptr, compare_ptr, result_ptr, type, target,
+                         rank_and_disp.second, _mpi_window);
+
+    if (!_epoch_open)
+    {
+        MPI_Win_unlock(target, _mpi_window);
+    }
+    else if (is_node_local(target))
+    {
+        MPI_Win_flush(target, _mpi_window);
+    }
+    else
+    {
+        MPI_Win_flush_local(target, _mpi_window);
+        _pending_stores[target] = true;
+    }
+}
+
+bool MemoryAbstractionDefault::is_node_local(int target)
+{
+    return _node_partitions[target] != nullptr;
+}
+
+void MemoryAbstractionDefault::local_store(int target, void *value_ptr, long disp, long count)
+{
+    char *dest = _node_partitions[target] + disp * _type_size;
+
+    if (_epoch_open)
+    {
+        std::memcpy(dest, value_ptr, count * _type_size);
+        // Make the new values visible to the RMA operations and direct loads of other
+        // processes
+        sync_windows();
+    }
+    else
+    {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, target, 0, _mpi_window);
+        std::memcpy(dest, value_ptr, count * _type_size);
+        MPI_Win_unlock(target, _mpi_window);
+    }
+}
+
+void MemoryAbstractionDefault::local_load(int target, void *dest_ptr, long disp, long count)
+{
+    char *source = _node_partitions[target] + disp * _type_size;
+
+    if (_epoch_open)
+    {
+        // Make completed RMA operations and direct stores of other processes visible to the
+        // local access
+        sync_windows();
+        std::memcpy(dest_ptr, source, count * _type_size);
+    }
+    else
+    {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, target, 0, _mpi_window);
+        std::memcpy(dest_ptr, source, count * _type_size);
+        MPI_Win_unlock(target, _mpi_window);
+    }
+}
+
+void MemoryAbstractionDefault::sync_windows()
+{
+    MPI_Win_sync(_mpi_window);
+    if (_node_window != MPI_WIN_NULL)
+    {
+        MPI_Win_sync(_node_window);
+    }
+}
+
+void MemoryAbstractionDefault::cached_load(void *dest_ptr, long index)
+{
+    char *element = _read_cache->lookup(index);
+    if (element == nullptr)
+    {
+        long line_start = _read_cache->get_line_start(index);
+        long line_count =
+            std::min(_read_cache->get_line_elements(), _global_num_elements - line_start);
+        char *line = _read_cache->insert_line(index, line_count);
+        load_range(nullptr, line, line_start, line_count);
+        element = line + (index - line_start) * _type_size;
+    }
+    std::memcpy(dest_ptr, element, _type_size);
+}
+
+void MemoryAbstractionDefault::flush_store_buffer(int target)
+{
+    if (_store_buffer == nullptr || _store_buffer->is_empty(target))
+    {
+        return;
+    }
+
+    std::vector<char> values;
+    std::vector<long> displacements;
+    std::vector<int> block_lengths;
+    _store_buffer->take_runs(target, values, displacements, block_lengths);
+
+    long span = displacements.back() - displacements.front();
+    if (block_lengths.size() > 1 && span <= INT_MAX)
+    {
+        // Write all runs with one indexed datatype relative to the first run
+        std::vector<int> relative_displacements(displacements.size());
+        for (size_t i = 0; i < displacements.size(); i++)
+        {
+            relative_displacements[i] = displacements[i] - displacements.front();
+        }
+
+        MPI_Datatype target_type;
+        MPI_Type_indexed(block_lengths.size(), block_lengths.data(),
+                         relative_displacements.data(), _type, &target_type);
+        MPI_Type_commit(&target_type);
+        MPI_Accumulate(values.data(), values.size() / _type_size, _type, target,
+                       displacements.front(), 1, target_type, MPI_REPLACE, _mpi_window);
+        MPI_Type_free(&target_type);
+    }
+    else
+    {
+        char *source = values.data();
+        for (size_t i = 0; i < displacements.size(); i++)
+        {
+            MPI_Accumulate(source, block_lengths[i], _type, target, displacements[i],
+                           block_lengths[i], _type, MPI_REPLACE, _mpi_window);
+            source += (long)block_lengths[i] * _type_size;
+        }
+    }
+
+    // The stores have to be complete at the target before any later operation on it
+    MPI_Win_flush(target, _mpi_window);
+    _pending_stores[target] = false;
+}
+
+void MemoryAbstractionDefault::flush_store_buffers()
+{
+    if (_store_buffer != nullptr)
+    {
+        for (int target = 0; target < _mpi_size; target++)
+        {
+            flush_store_buffer(target);
+        }
+    }
+}
+
+void MemoryAbstractionDefault::epoch_begin()
+{
+    if (_dimensions == 1 && _materialized && !_epoch_open)
+    {
+        MPI_Win_lock_all(MPI_MODE_NOCHECK, _mpi_window);
+        if (_node_window != MPI_WIN_NULL)
+        {
+            MPI_Win_lock_all(MPI_MODE_NOCHECK, _node_window);
+        }
+        _epoch_open = true;
+        invalidate_cache();
+    }
+}
+
+void MemoryAbstractionDefault::epoch_end()
+{
+    if (_dimensions == 1 && _epoch_open)
+    {
+        flush_store_buffers();
+        MPI_Win_flush_all(_mpi_window);
+        MPI_Win_unlock_all(_mpi_window);
+        if (_node_window != MPI_WIN_NULL)
+        {
+            MPI_Win_unlock_all(_node_window);
+        }
+        std::fill(_pending_stores.begin(), _pending_stores.end(), false);
+        _epoch_open = false;
+        invalidate_cache();
+    }
+}
+
+void MemoryAbstractionDefault::flush()
+{
+    if (_dimensions == 1 && _epoch_open)
+    {
+        flush_store_buffers();
+        MPI_Win_flush_all(_mpi_window);
+        sync_windows();
+        std::fill(_pending_stores.begin(), _pending_stores.end(), false);
+        invalidate_cache();
+    }
+}
+
+void MemoryAbstractionDefault::invalidate_cache()
+{
+    if (_read_cache != nullptr)
+    {
+        _read_cache->invalidate();
+    }
+    _ghost_regions.clear();
+}
+
+void MemoryAbstractionDefault::exchange_halo(long start, long end)
+{
+    if (_dimensions != 1 || !_epoch_open)
+    {
+        return;
+    }
+
+    _ghost_regions.clear();
+    long from = std::max(start, 0L);
+    long to = std::min(end, _global_num_elements);
+
+    if (auto *logger = CatoRuntimeLogger::get_logger())
+    {
+        std::string message = std::string("Halo exchange in 1D MemoryAbstractionDefault:\n") +
+                              "   base ptr: " + std::to_string((long)_base_ptr) + "\n" +
+                              "   range start: " + std::to_string(from) + "\n" +
+                              "   range count: " + std::to_string(to - from);
+        *logger << message;
+    }
+
+    // All remote parts are requested before the transfers are completed together
+    while (from < to)
+    {
+        auto rank_and_disp = get_target_rank_and_disp_for_offset(from);
+        int target = rank_and_disp.first;
+        long chunk = std::min(to, _array_ranges[target].second + 1) - from;
+        chunk = std::min(chunk, (long)INT_MAX);
+
+        if (!is_node_local(target))
         {
-            if (offset >= _array_ranges[i].first && offset <= _array_ranges[i].second)
+            flush_store_buffer(target);
+            if (_pending_stores[target])
             {
-                long target_disp = offset - _array_ranges[i].first;
-                ret = {i, target_disp};
+                MPI_Win_flush(target, _mpi_window);
+                _pending_stores[target] = false;
             }
+
+            _ghost_regions.push_back({from, std::vector<char>(chunk * _type_size)});
+            MPI_Get(_ghost_regions.back().values.data(), chunk, _type, target,
+                    rank_and_disp.second, chunk, _type, _mpi_window);
+        }
+        from += chunk;
+    }
+
+    if (!_ghost_regions.empty())
+    {
+        MPI_Win_flush_local_all(_mpi_window);
+    }
+}
+
+char *MemoryAbstractionDefault::find_ghost_cells(long index, long count)
+{
+    for (auto &region : _ghost_regions)
+    {
+        long region_count = region.values.size() / _type_size;
+        if (index >= region.start && index + count <= region.start + region_count)
+        {
+            return region.values.data() + (index - region.start) * _type_size;
+        }
+    }
+    return nullptr;
+}
+
+void MemoryAbstractionDefault::update_ghost_cells(long start, long count, const void *values)
+{
+    for (auto &region : _ghost_regions)
+    {
+        long region_count = region.values.size() / _type_size;
+        long from = std::max(start, region.start);
+        long to = std::min(start + count, region.start + region_count);
+        if (from < to)
+        {
+            std::memcpy(region.values.data() + (from - region.start) * _type_size,
+                        (const char *)values + (from - start) * _type_size,
+                        (to - from) * _type_size);
+        }
+    }
+}
+
+long MemoryAbstractionDefault::get_row_elements()
+{
+    return _owner >= 0 ? _global_num_elements : _row_elements;
+}
+
+int MemoryAbstractionDefault::get_owner(long index)
+{
+    if (_dimensions != 1 || !_materialized)
+    {
+        return -1;
+    }
+    return get_target_rank_and_disp_for_offset(index).first;
+}
+
+void *MemoryAbstractionDefault::get_local_address(long index)
+{
+    if (_dimensions != 1 || !_materialized)
+    {
+        return nullptr;
+    }
+
+    auto rank_and_disp = get_target_rank_and_disp_for_offset(index);
+    if (rank_and_disp.first != _mpi_rank)
+    {
+        return nullptr;
+    }
+    return (char *)_local_ptr + rank_and_disp.second * _type_size;
+}
+
+void MemoryAbstractionDefault::synchronize_local_stores()
+{
+    if (_dimensions == 1 && _materialized && !_epoch_open)
+    {
+        // In the separate memory model the fence also updates the public copy of the
+        // partition, which the RMA operations of the other processes access
+        MPI_Win_fence(0, _mpi_window);
+    }
+}
+
+/**
+ * Returns the maximum size in bytes of a snapshot from CATO_SNAPSHOT_LIMIT, 64 MiB by default
+ **/
+static long snapshot_limit()
+{
+    static long limit = []() {
+        const char *value = std::getenv("CATO_SNAPSHOT_LIMIT");
+        if (value == nullptr)
+        {
+            return 64L << 20;
+        }
+        return std::max(std::atol(value), 0L);
+    }();
+    return limit;
+}
+
+void MemoryAbstractionDefault::create_snapshot(int reader)
+{
+    long size = _global_num_elements * _type_size;
+    if (_dimensions != 1 || !_materialized || _epoch_open || _global_num_elements > INT_MAX ||
+        size > snapshot_limit() || reader < -1 || reader >= _mpi_size ||
+        (_has_snapshot && (_snapshot_holder < 0 || _snapshot_holder == reader)))
+    {
+        return;
+    }
+
+    std::vector<int> counts(_mpi_size), displacements(_mpi_size);
+    for (int rank = 0; rank < _mpi_size; rank++)
+    {
+        counts[rank] = _array_ranges[rank].second - _array_ranges[rank].first + 1;
+        displacements[rank] = _array_ranges[rank].first;
+    }
+
+    std::vector<char> partition(_local_num_elements * _type_size);
+    MPI_Win_lock(MPI_LOCK_SHARED, _mpi_rank, 0, _mpi_window);
+    std::memcpy(partition.data(), _local_ptr, partition.size());
+    MPI_Win_unlock(_mpi_rank, _mpi_window);
+
+    _snapshot.assign(reader < 0 || reader == _mpi_rank ? size : 0, 0);
+    if (reader < 0)
+    {
+        MPI_Allgatherv(partition.data(), _local_num_elements, _type, _snapshot.data(),
+                       counts.data(), displacements.data(), _type, MPI_COMM_WORLD);
+    }
+    else
+    {
+        MPI_Gatherv(partition.data(), _local_num_elements, _type, _snapshot.data(),
+                    counts.data(), displacements.data(), _type, reader, MPI_COMM_WORLD);
+    }
+
+    _has_snapshot = true;
+    _snapshot_holder = reader;
+    _snapshot_written = false;
+}
+
+bool MemoryAbstractionDefault::has_snapshot() { return _has_snapshot; }
+
+bool MemoryAbstractionDefault::is_snapshot_written() { return _snapshot_written; }
+
+bool MemoryAbstractionDefault::is_snapshot_complete() { return _snapshot_holder < 0; }
+
+void MemoryAbstractionDefault::drop_snapshot()
+{
+    _has_snapshot = false;
+    _snapshot_written = false;
+    std::vector<char>().swap(_snapshot);
+}
+
+std::pair<int, long> MemoryAbstractionDefault::get_target_rank_and_disp_for_offset(long offset)
+{
+    if (_dimensions == 1)
+    {
+        if (_owner >= 0)
+        {
+            return {_owner, offset};
+        }
+
+        // The first _block_rest processes store _block_size + 1 rows each
+        long row = offset / _row_elements;
+        long large_blocks_end = _block_rest * (_block_size + 1);
+        int rank;
+        long local_row;
+        if (row < large_blocks_end)
+        {
+            rank = row / (_block_size + 1);
+            local_row = row % (_block_size + 1);
         }
-        return ret;
+        else if (_block_size == 0)
+        {
+            // More processes than rows, only the first _block_rest processes store one
+            rank = _block_rest;
+            local_row = row - large_blocks_end;
+        }
+        else
+        {
+            long remaining = row - large_blocks_end;
+            rank = _block_rest + remaining / _block_size;
+            local_row = remaining % _block_size;
+        }
+        return {rank, local_row * _row_elements + offset % _row_elements};
     }
     else
     {
@@ -258,55 +1023,200 @@ std::pair<int, long> MemoryAbstractionDefault::get_target_rank_and_disp_for_offs
     }
 }
 
+int MemoryAbstractionDefault::get_row_owner(long row, long num_rows)
+{
+    long block_size = num_rows / _mpi_size;
+    long large_blocks_end = (num_rows % _mpi_size) * (block_size + 1);
+    if (block_size == 0)
+    {
+        // More processes than rows, the first num_rows processes store one row each
+        return std::min(row, num_rows - 1);
+    }
+    if (row < large_blocks_end)
+    {
+        return row / (block_size + 1);
+    }
+    return num_rows % _mpi_size + (row - large_blocks_end) / block_size;
+}
+
+/**
+ * Returns the communicator of the processes on the same node, or MPI_COMM_NULL if their
+ * partitions are not shared (CATO_NODE_SHARING=0). The communicator is created by the first
+ * call, which has to be made by all processes.
+ **/
+static MPI_Comm get_node_comm()
+{
+    static MPI_Comm node_comm = []() {
+        MPI_Comm comm = MPI_COMM_NULL;
+        const char *value = std::getenv("CATO_NODE_SHARING");
+        if (value == nullptr || std::atoi(value) != 0)
+        {
+            MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &comm);
+        }
+        return comm;
+    }();
+    return node_comm;
+}
+
+void MemoryAbstractionDefault::create_windows(long local_bytes)
+{
+    MPI_Comm node_comm = get_node_comm();
+    int node_size = 1;
+    if (node_comm != MPI_COMM_NULL)
+    {
+        MPI_Comm_size(node_comm, &node_size);
+    }
+
+    // Stores and loads from the same origin rely on the ordering of accumulate operations
+    // (see epoch_begin), only the ordering of reads after reads and writes after reads can
+    // be relaxed. The latter is safe because every load waits for its result.
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "accumulate_ordering", "raw,waw");
+    MPI_Info_set(info, "same_disp_unit", "true");
+    bool same_size = std::all_of(_array_ranges.begin(), _array_ranges.end(), [&](auto &range) {
+        return range.second - range.first == _array_ranges[0].second - _array_ranges[0].first;
+    });
+    MPI_Info_set(info, "same_size", same_size ? "true" : "false");
+
+    if (node_size > 1)
+    {
+        MPI_Win_allocate_shared(local_bytes, _type_size, info, node_comm, &_local_ptr,
+                                &_node_window);
+
+        // Processes on other nodes access the partition through one-sided MPI
+        MPI_Win_create(_local_ptr, local_bytes, _type_size, info, MPI_COMM_WORLD,
+                       &_mpi_window);
+    }
+    else if (window_allocation_enabled())
+    {
+        // Memory allocated by MPI can be registered for RDMA by the MPI library
+        MPI_Win_allocate(local_bytes, _type_size, info, MPI_COMM_WORLD, &_local_ptr,
+                         &_mpi_window);
+    }
+    else
+    {
+        _local_ptr = malloc(local_bytes);
+        MPI_Win_create(_local_ptr, local_bytes, _type_size, info, MPI_COMM_WORLD,
+                       &_mpi_window);
+    }
+    MPI_Info_free(&info);
+
+    int *memory_model;
+    int flag;
+    MPI_Win_get_attr(_mpi_window, MPI_WIN_MODEL, &memory_model, &flag);
+    _unified_memory_model = flag && *memory_model == MPI_WIN_UNIFIED;
+
+    _node_partitions.assign(_mpi_size, nullptr);
+    if (!_unified_memory_model)
+    {
+        return;
+    }
+    _node_partitions[_mpi_rank] = (char *)_local_ptr;
+
+    if (_node_window != MPI_WIN_NULL)
+    {
+        std::vector<int> world_ranks(_mpi_size), node_ranks(_mpi_size);
+        std::iota(world_ranks.begin(), world_ranks.end(), 0);
+
+        MPI_Group world_group, node_group;
+        MPI_Comm_group(MPI_COMM_WORLD, &world_group);
+        MPI_Comm_group(node_comm, &node_group);
+        MPI_Group_translate_ranks(world_group, _mpi_size, world_ranks.data(), node_group,
+                                  node_ranks.data());
+        MPI_Group_free(&world_group);
+        MPI_Group_free(&node_group);
+
+        for (int rank = 0; rank < _mpi_size; rank++)
+        {
+            if (node_ranks[rank] != MPI_UNDEFINED)
+            {
+                MPI_Aint partition_size;
+                int disp_unit;
+                void *partition;
+                MPI_Win_shared_query(_node_window, node_ranks[rank], &partition_size,
+                                     &disp_unit, &partition);
+                if (partition_size > 0)
+                {
+                    _node_partitions[rank] = (char *)partition;
+                }
+            }
+        }
+    }
+}
+
 void MemoryAbstractionDefault::create_1d_array(long size, MPI_Datatype type, int dimensions)
 {
     int type_size;
 
-    MPI_Comm_rank(MPI_COMM_WORLD, &_mpi_rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &_mpi_size);
-
     MPI_Type_size(type, &type_size);
+    _type_size = type_size;
     _global_num_elements = size / type_size;
 
-    int div = _global_num_elements / _mpi_size;
-    int rest = _global_num_elements % _mpi_size;
-
-    if (_mpi_size > _global_num_elements)
+    // Rows are known from pointers into the object that are stored in a pointer table. An
+    // object that is itself a row of a pointer table is stored by the owner of that row.
+    long table_row, table_num_rows;
+    _owner = -1;
+    if (_row_elements > 0)
     {
-        // TODO Handle this case
-        std::cerr << "Error: There are more MPI processes than array elements\n";
+        _row_elements = std::gcd(_row_elements, _global_num_elements);
     }
+    else if (get_table_row(&table_row, &table_num_rows) && table_num_rows > 1)
+    {
+        _owner = get_row_owner(table_row, table_num_rows);
+    }
+    _row_elements = std::max(_row_elements, 1L);
+
+    long num_rows = _global_num_elements / _row_elements;
+    long div = num_rows / _mpi_size;
+    long rest = num_rows % _mpi_size;
+    _block_size = div;
+    _block_rest = rest;
 
-    _array_ranges.reserve(_mpi_size);
+    _array_ranges.resize(_mpi_size);
+    _pending_stores.assign(_mpi_size, false);
     for (int rank = 0; rank < _mpi_size; rank++)
     {
         long local_num_elements, local_from, local_to;
 
-        if (rank < rest)
+        if (_owner >= 0)
         {
-            local_num_elements = div + 1;
+            local_num_elements = rank == _owner ? _global_num_elements : 0;
+            local_from = 0;
+        }
+        else if (rank < rest)
+        {
+            local_num_elements = (div + 1) * _row_elements;
             local_from = rank * local_num_elements;
-            local_to = local_from + local_num_elements - 1;
         }
         else
         {
-            local_num_elements = div;
-            local_from = rank * local_num_elements + rest;
-            local_to = local_from + local_num_elements - 1;
+            local_num_elements = div * _row_elements;
+            local_from = (rank * div + rest) * _row_elements;
         }
+        local_to = local_from + local_num_elements - 1;
         _array_ranges[rank] = {local_from, local_to};
 
         if (rank == _mpi_rank)
         {
             _local_num_elements = local_num_elements;
-            _base_ptr = malloc(local_num_elements * type_size);
-            Debug(std::cout << "MemoryAbstractionDefault: rank " << _mpi_rank << " allocated "
-                            << local_num_elements * type_size << " bytes\n");
         }
     }
 
-    MPI_Win_create(_base_ptr, _local_num_elements * type_size, type_size, MPI_INFO_NULL,
-                   MPI_COMM_WORLD, &_mpi_window);
+    create_windows(_local_num_elements * type_size);
+    _materialized = true;
+    Debug(std::cout << "MemoryAbstractionDefault: rank " << _mpi_rank << " allocated "
+                    << _local_num_elements * type_size << " bytes\n");
+
+    if (ReadCache::is_enabled())
+    {
+        _read_cache = std::make_unique<ReadCache>(type_size);
+    }
+
+    if (StoreBuffer::is_enabled())
+    {
+        _store_buffer = std::make_unique<StoreBuffer>(_mpi_size, type_size);
+    }
 
     if (auto *logger = CatoRuntimeLogger::get_logger())
     {
@@ -315,6 +1225,8 @@ void MemoryAbstractionDefault::create_1d_array(long size, MPI_Datatype type, int
             "   base ptr: " + std::to_string((long)_base_ptr) + "\n" +
             "   local element count: " + std::to_string(_local_num_elements) + "\n" +
             "   global element count: " + std::to_string(_global_num_elements) + "\n" +
+            "   row element count: " + std::to_string(_row_elements) + "\n" +
+            "   owner: " + std::to_string(_owner) + "\n" +
             "   type size: " + std::to_string(type_size) + "\n";
         *logger << message;
     }
@@ -332,3 +1244,21 @@ void MemoryAbstractionDefault::pointer_store(void *source_ptr, long dest_index)
     Debug(std::cout << "Saved Pointer into Array abstraction : "
                     << ((long **)_base_ptr)[dest_index] << "\n";);
 }
+
+void MemoryAbstractionDefault::add_row_reference(long offset, long row, long num_rows)
+{
+    MemoryAbstraction::add_row_reference(offset, row, num_rows);
+
+    if (_dimensions == 1 && !_materialized)
+    {
+        _row_elements = std::gcd(_row_elements, offset);
+    }
+}
+
+void MemoryAbstractionDefault::materialize()
+{
+    if (_dimensions == 1 && !_materialized)
+    {
+        create_1d_array(_size_bytes, _type, _dimensions);
+    }
+}
@@ -3,16 +3,27 @@
 
 #include <mpi.h>
 
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include "MemoryAbstraction.h"
+#include "ReadCache.h"
+#include "StoreBuffer.h"
 
 /**
  * Default Communication Pattern for shared memory objects.
  * The elements of the shared memory are distributed evenly over all
  * mpi processes.
  * Communication is done through one-sided MPI.
+ * The partitions of the processes on the same node are allocated in a shared memory window,
+ * so they are accessed directly and one-sided MPI is only used between nodes.
+ *
+ * 1D objects that hold the data of a 2D or 3D array are distributed by blocks of whole
+ * rows. The extents of the array are learned from the row pointers the program stores
+ * into its pointer tables, so the allocation of the memory is deferred until the first
+ * access or parallel region (see materialize). Until then the base pointer only reserves
+ * an address range without any memory behind it.
  **/
 class MemoryAbstractionDefault : public MemoryAbstraction
 {
@@ -22,26 +33,154 @@ class MemoryAbstractionDefault : public MemoryAbstraction
 
     int _mpi_rank, _mpi_size;
 
+    // Size of one element in bytes
+    int _type_size;
+
+    // Window over the partitions of all processes on the same node, allocated with
+    // MPI_Win_allocate_shared. MPI_WIN_NULL if the partitions are not shared.
+    MPI_Win _node_window;
+
+    // True if the MPI window uses the unified memory model. Only then the partitions on
+    // the same node can be accessed directly instead of through RMA operations.
+    bool _unified_memory_model;
+
+    // The directly accessible partition of each process, nullptr for the processes whose
+    // partition can only be accessed through RMA operations
+    std::vector<char *> _node_partitions;
+
     // global number of elements in the shared memory object and
     // the number of elements stored in the memory of this MPI process.
     long _global_num_elements, _local_num_elements;
 
+    // Local partition of a 1D object, which is exposed in _mpi_window
+    void *_local_ptr;
+
+    // True once the memory of a 1D object has been allocated
+    bool _materialized;
+
+    // Number of elements in one row. Rows are never split between processes. Before the
+    // object is materialized this is the gcd of all row offsets seen so far (0 if none).
+    long _row_elements;
+
+    // The process that stores the whole object if it is a single row of a pointer table,
+    // -1 if the rows of the object are distributed over all processes
+    int _owner;
+
     // Ranges of indices for the elements each MPI process has stored locally
     std::vector<std::pair<long, long>> _array_ranges;
 
+    // Parameters of the block distribution: every process stores _block_size rows and
+    // the first _block_rest processes store one additional row
+    long _block_size, _block_rest;
+
+    // True while a passive target epoch for all processes is open on _mpi_window
+    bool _epoch_open;
+
+    // Processes with single element stores that have not been flushed in the current epoch
+    std::vector<bool> _pending_stores;
+
+    // Cache for remote elements, nullptr if the read cache is disabled
+    std::unique_ptr<ReadCache> _read_cache;
+
+    // Write combining buffers for remote stores, nullptr if they are disabled
+    std::unique_ptr<StoreBuffer> _store_buffer;
+
+    // Copy of a remote part of the object, see exchange_halo
+    struct GhostRegion
+    {
+        long start;
+        std::vector<char> values;
+    };
+
+    std::vector<GhostRegion> _ghost_regions;
+
+    // Copy of the whole object for sequential loads, see create_snapshot. The values are
+    // only stored on the process _snapshot_holder, or on all processes if it is -1.
+    bool _has_snapshot;
+    int _snapshot_holder;
+    std::vector<char> _snapshot;
+
+    // True if this process has written to the object since the snapshot was created
+    bool _snapshot_written;
+
+    /**
+     * Returns the address of the element at index in the ghost cells if the count elements
+     * starting at index are all in one ghost region, nullptr otherwise
+     **/
+    char *find_ghost_cells(long index, long count);
+
+    /**
+     * Writes stored values into the ghost cells that hold copies of the stored elements
+     **/
+    void update_ghost_cells(long start, long count, const void *values);
+
     /**
      * Takes an offset and computes the rank of the MPI process that
      * stores the value at that offset. Also returns the local offset
      * of the searched element for the MPI process that stores it.
+     * The result is computed in constant time from the block distribution.
      **/
     std::pair<int, long> get_target_rank_and_disp_for_offset(long offset);
 
+    /**
+     * Returns true if the partition of the target process can be accessed directly
+     **/
+    bool is_node_local(int target);
+
+    /**
+     * Copies count elements from value_ptr into the partition of the target process on
+     * the same node at the element offset disp, without going through the MPI window.
+     **/
+    void local_store(int target, void *value_ptr, long disp, long count);
+
+    /**
+     * Copies count elements at the element offset disp of the partition of the target
+     * process on the same node to dest_ptr, without going through the MPI window.
+     **/
+    void local_load(int target, void *dest_ptr, long disp, long count);
+
+    /**
+     * Synchronizes the public and private copies of the local partition in the MPI_COMM_WORLD
+     * window and, if there is one, in the window shared by the processes on the same node
+     **/
+    void sync_windows();
+
+    /**
+     * Allocates the local partition of local_bytes bytes with MPI and creates the windows.
+     * The partitions of the processes on the same node are shared if possible.
+     **/
+    void create_windows(long local_bytes);
+
+    /**
+     * Loads the remote element at the global index through the read cache. On a miss the
+     * whole cache line is fetched. Must only be called inside of an epoch.
+     **/
+    void cached_load(void *dest_ptr, long index);
+
+    /**
+     * Writes the buffered stores to the target process with one MPI_Accumulate and waits
+     * for their remote completion. Must only be called inside of an epoch.
+     **/
+    void flush_store_buffer(int target);
+
+    /**
+     * Flushes the store buffers of all target processes
+     **/
+    void flush_store_buffers();
+
     /**
      * Allocate the actual memory on each MPI process and set up the MPI Window
      * and all needed variables for future communication.
+     * The distribution is chosen from the row references seen so far.
      **/
     void create_1d_array(long size, MPI_Datatype type, int dimensions);
 
+    /**
+     * Returns the process that stores the given row of num_rows rows in a block
+     * distribution of the rows over all processes
+     **/
+    int get_row_owner(long row, long num_rows);
+
   public:
     /**
      * Create a MemeoryAbstraction of size (in bytes) with the given type
@@ -58,27 +197,131 @@ class MemoryAbstractionDefault : public MemoryAbstraction
      * Stores the value at the address value_ptr into the memory Abstraction at
      * the given indices.
      **/
-    void store(void *base_ptr, void *value_ptr, std::vector<long> indices) override;
+    void store(void *base_ptr, void *value_ptr, IndexSpan indices) override;
 
     /**
      * Loads the value at the given indices and copies it to the given dest_ptr address.
      **/
-    void load(void *base_ptr, void *dest_ptr, std::vector<long> indices) override;
+    void load(void *base_ptr, void *dest_ptr, IndexSpan indices) override;
 
     /**
      * Same as store but each process only continues after the store has been completed.
      **/
-    void sequential_store(void *base_ptr, void *value_ptr, std::vector<long> indices) override;
+    void sequential_store(void *base_ptr, void *value_ptr, IndexSpan indices) override;
 
     /**
      * Same as load but each process only continues after the load has been completed.
+     * If the object has a snapshot the value is taken from there, or read with a passive
+     * target access by the processes that do not hold the snapshot.
+     **/
+    void sequential_load(void *base_ptr, void *dest_ptr, IndexSpan indices) override;
+
+    /**
+     * Stores count elements from value_ptr into the range starting at start.
+     * The range is split at the partition borders and one MPI_Put is issued per owner.
+     **/
+    void store_range(void *base_ptr, void *value_ptr, long start, long count) override;
+
+    /**
+     * Loads count elements of the range starting at start into dest_ptr.
+     * The range is split at the partition borders and one MPI_Get is issued per owner.
+     **/
+    void load_range(void *base_ptr, void *dest_ptr, long start, long count) override;
+
+    /**
+     * Updates the element with MPI_Accumulate, or MPI_Fetch_and_op if the old value is
+     * needed. Buffered stores to the owner are flushed first, so they can not overwrite
+     * the update later. The line of the element is dropped from the read cache.
+     **/
+    void accumulate(void *base_ptr, void *value_ptr, void *result_ptr, IndexSpan indices,
+                    MPI_Op op, MPI_Datatype type) override;
+
+    /**
+     * Compare and swap on the element with MPI_Compare_and_swap
+     **/
+    void compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr, void *result_ptr,
+                          IndexSpan indices, MPI_Datatype type) override;
+
+    /**
+     * Opens a MPI_Win_lock_all epoch on the MPI window.
+     * Single element stores inside the epoch are collected in the store buffers (or use
+     * MPI_Accumulate if they are disabled) and loads use MPI_Get_accumulate, which keeps
+     * them ordered without locking or flushing the target for each element.
+     **/
+    void epoch_begin() override;
+
+    /**
+     * Flushes all buffered and outstanding operations and calls MPI_Win_unlock_all
+     **/
+    void epoch_end() override;
+
+    /**
+     * Flushes the store buffers and calls MPI_Win_flush_all if an epoch is open
+     **/
+    void flush() override;
+
+    /**
+     * Drops all cached remote elements and ghost cells
+     **/
+    void invalidate_cache() override;
+
+    /**
+     * Fetches the remote part of [start, end) into ghost regions with one MPI_Get per
+     * owner and a single flush. Must only be called inside of an epoch.
      **/
-    void sequential_load(void *base_ptr, void *dest_ptr, std::vector<long> indices) override;
+    void exchange_halo(long start, long end) override;
+
+    /**
+     * Returns the row length, or the number of elements if one process stores all of them
+     **/
+    long get_row_elements() override;
+
+    /**
+     * Returns the owner of the element at index of a materialized 1D object
+     **/
+    int get_owner(long index) override;
+
+    /**
+     * Returns the address of the element in the local partition of a materialized 1D object
+     **/
+    void *get_local_address(long index) override;
+
+    /**
+     * Closes the local stores with MPI_Win_fence, like a sequential_store
+     **/
+    void synchronize_local_stores() override;
+
+    /**
+     * Gathers the partitions of all processes with one MPI_Allgatherv, or with one
+     * MPI_Gatherv if only one process reads the snapshot. Objects larger than
+     * CATO_SNAPSHOT_LIMIT bytes get no snapshot, and neither do readers that are no rank.
+     **/
+    void create_snapshot(int reader) override;
+
+    bool has_snapshot() override;
+
+    bool is_snapshot_written() override;
+
+    bool is_snapshot_complete() override;
+
+    void drop_snapshot() override;
 
     /**
      * Stores the source_ptr into the memory abstraction at the given index.
      **/
     void pointer_store(void *source_ptr, long dest_index) override;
+
+    /**
+     * Collects the row structure of a 1D object before it is materialized
+     **/
+    void add_row_reference(long offset, long row, long num_rows) override;
+
+    /**
+     * Allocates the local partition and the MPI window of a 1D object. The rows are
+     * distributed in blocks, an object that is a single row of a pointer table is stored
+     * completely by the owner of that row.
+     **/
+    void materialize() override;
 };
 
 #endif
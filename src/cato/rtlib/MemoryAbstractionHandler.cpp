@@ -3,6 +3,8 @@
 #include <stdlib.h>
 #include <utility>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "MemoryAbstractionDefault.h"
@@ -14,6 +16,8 @@ MemoryAbstractionHandler::MemoryAbstractionHandler(int rank, int size)
 {
     _mpi_rank = rank;
     _mpi_size = size;
+    _epoch_open = false;
+    _materialization_pending = false;
 }
 
 void *MemoryAbstractionHandler::create_memory(long size, MPI_Datatype type, int dimensions)
@@ -27,6 +31,19 @@ void *MemoryAbstractionHandler::create_memory(long size, MPI_Datatype type, int
             std::make_unique<MemoryAbstractionDefault>(size, type, dimensions);
         memory = memory_abstraction->get_base_ptr();
 
+        if (_epoch_open)
+        {
+            memory_abstraction->materialize();
+            memory_abstraction->epoch_begin();
+        }
+        else
+        {
+            _materialization_pending = true;
+        }
+
+        _handles[(long)memory] = _handle_table.size();
+        _handle_table.push_back(memory_abstraction.get());
+
         // Transfer ownership of the unique_ptr to the _memory_abstractions datastructure
         _memory_abstractions.insert(
             std::make_pair((long)memory, std::move(memory_abstraction)));
@@ -48,6 +65,20 @@ void MemoryAbstractionHandler::free_memory(void *base_ptr)
 
     if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
     {
+        MemoryAbstraction *memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+        _handle_table[_handles[(long)base_ptr]] = nullptr;
+        _handles.erase((long)base_ptr);
+        for (auto *other : _handle_table)
+        {
+            if (other != nullptr)
+            {
+                other->remove_sub_abstraction(memory_abstraction);
+            }
+        }
+        _local_store_targets.erase(std::remove(_local_store_targets.begin(),
+                                               _local_store_targets.end(), memory_abstraction),
+                                   _local_store_targets.end());
+
         _memory_abstractions.erase((long)base_ptr);
     }
     else
@@ -61,294 +92,359 @@ void MemoryAbstractionHandler::free_memory(void *base_ptr)
     }
 }
 
-void MemoryAbstractionHandler::store(void *base_ptr, void *value_ptr,
-                                     std::vector<long> indices)
+long MemoryAbstractionHandler::get_handle(void *base_ptr)
 {
-    MemoryAbstraction *memory_abstraction = nullptr;
+    auto handle = _handles.find((long)base_ptr);
+    if (handle != _handles.end())
+    {
+        return handle->second;
+    }
+    return -1;
+}
 
-    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+MemoryAbstraction *MemoryAbstractionHandler::find_memory_abstraction(void *ptr, long *offset)
+{
+    auto entry = _memory_abstractions.upper_bound((long)ptr);
+    if (entry == _memory_abstractions.begin())
+    {
+        return nullptr;
+    }
+    entry--;
+
+    MemoryAbstraction *memory_abstraction = entry->second.get();
+    long byte_offset = (long)ptr - entry->first;
+    if (byte_offset != 0 && byte_offset >= memory_abstraction->get_size_bytes())
     {
-        memory_abstraction = _memory_abstractions[(long)(base_ptr)].get();
+        return nullptr;
     }
 
-    if (indices.size() == 1)
+    int element_size = sizeof(long *);
+    if (memory_abstraction->get_dimensions() == 1)
     {
-        if (memory_abstraction != nullptr)
+        MPI_Type_size(memory_abstraction->get_type(), &element_size);
+    }
+    *offset = byte_offset / element_size;
+    return memory_abstraction;
+}
+
+MemoryAbstraction *MemoryAbstractionHandler::get_sub_abstraction(
+    MemoryAbstraction *memory_abstraction, long index, long *offset)
+{
+    MemoryAbstraction *sub_abstraction =
+        memory_abstraction->get_sub_abstraction(index, offset);
+    if (sub_abstraction == nullptr)
+    {
+        // The pointer might have been stored without a call to pointer_store
+        void *pointer = ((void **)memory_abstraction->get_base_ptr())[index];
+        sub_abstraction = find_memory_abstraction(pointer, offset);
+        if (sub_abstraction != nullptr)
         {
-            memory_abstraction->store(base_ptr, value_ptr, indices);
+            memory_abstraction->set_sub_abstraction(index, sub_abstraction, *offset);
         }
-        else
+    }
+    return sub_abstraction;
+}
+
+MemoryAbstraction *MemoryAbstractionHandler::resolve_access(
+    MemoryAbstraction *memory_abstraction, IndexSpan indices, long *index)
+{
+    // Each pointer table entry points to a row of the next level, which can either be a
+    // separate shared memory object or start at some offset inside of a contiguous one
+    long offset = 0;
+    for (size_t level = 0; level + 1 < indices.size(); level++)
+    {
+        memory_abstraction =
+            get_sub_abstraction(memory_abstraction, offset + indices[level], &offset);
+        if (memory_abstraction == nullptr)
         {
-            std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
-            std::cerr << "Shutting down\n";
-            exit(1);
+            return nullptr;
         }
     }
-    else if (indices.size() == 2)
+
+    *index = offset + indices[indices.size() - 1];
+    return memory_abstraction;
+}
+
+void MemoryAbstractionHandler::materialize_memory()
+{
+    if (_materialization_pending)
     {
-        if (memory_abstraction != nullptr)
+        // The shared memory objects are materialized in the order of their creation, which
+        // is the same on all processes
+        for (auto *memory_abstraction : _handle_table)
         {
-            int index1 = indices[0];
-            long *d2_base_ptr = (long *)memory_abstraction->get_base_ptr();
-
-            MemoryAbstraction *sub_array = nullptr;
-            if (_memory_abstractions.find((long)d2_base_ptr[index1]) !=
-                _memory_abstractions.end())
+            if (memory_abstraction != nullptr)
             {
-                sub_array = _memory_abstractions[(long)d2_base_ptr[index1]].get();
+                memory_abstraction->materialize();
             }
+        }
+        _materialization_pending = false;
+    }
+}
 
-            if (sub_array == nullptr && index1 != 0)
-            {
-                // TODO clean up
-                MemoryAbstraction *first_entry_array = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                    _memory_abstractions.end())
-                {
-                    first_entry_array = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                }
+void MemoryAbstractionHandler::store_with_handle(long handle, void *value_ptr,
+                                                 IndexSpan indices)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (handle >= 0 && handle < (long)_handle_table.size())
+    {
+        memory_abstraction = _handle_table[handle];
+    }
 
-                long outer_array_size_bytes = memory_abstraction->get_size_bytes();
-                long inner_array_size_bytes = first_entry_array->get_size_bytes();
-                int type_size;
-                MPI_Type_size(first_entry_array->get_type(), &type_size);
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
 
-                long num_elements_row = (inner_array_size_bytes / type_size) /
-                                        (outer_array_size_bytes / sizeof(long *));
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
+    {
+        target->store(target->get_base_ptr(), value_ptr, IndexSpan(&index, 1));
+    }
+    else
+    {
+        std::cerr << "Error: could not do a store to this memory abstraction\n";
+    }
+}
 
-                long new_index = (index1 * num_elements_row) + indices[1];
+void MemoryAbstractionHandler::load_with_handle(long handle, void *dest_ptr, IndexSpan indices)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (handle >= 0 && handle < (long)_handle_table.size())
+    {
+        memory_abstraction = _handle_table[handle];
+    }
 
-                first_entry_array->store(nullptr, value_ptr, {new_index});
-            }
-            else if (sub_array != nullptr)
-            {
-                sub_array->store(nullptr, value_ptr, {indices[1]});
-            }
-            else
-            {
-                std::cerr << "Error: could not do a store to this memory abstraction\n";
-            }
-        }
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
     }
-    else if (indices.size() == 3)
+
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
     {
-        if (memory_abstraction != nullptr)
-        {
-            int index0 = indices[0];
-            long *d3_base_ptr = (long *)memory_abstraction->get_base_ptr();
+        target->load(target->get_base_ptr(), dest_ptr, IndexSpan(&index, 1));
+    }
+    else
+    {
+        std::cerr << "Error: could not do a load from this memory abstraction\n";
+    }
+}
 
-            MemoryAbstraction *d2_abstraction = nullptr;
-            if (_memory_abstractions.find((long)d3_base_ptr[index0]) !=
-                _memory_abstractions.end())
-            {
-                d2_abstraction = _memory_abstractions[(long)d3_base_ptr[index0]].get();
-            }
+void MemoryAbstractionHandler::accumulate_with_handle(long handle, void *value_ptr,
+                                                      void *result_ptr, IndexSpan indices,
+                                                      MPI_Op op, bool unsigned_op)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (handle >= 0 && handle < (long)_handle_table.size())
+    {
+        memory_abstraction = _handle_table[handle];
+    }
 
-            if (d2_abstraction == nullptr && index0 != 0)
-            {
-                // TODO
-            }
-            else if (d2_abstraction != nullptr)
-            {
-                long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                MemoryAbstraction *d1_abstraction = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[indices[1]]) !=
-                    _memory_abstractions.end())
-                {
-                    d1_abstraction = _memory_abstractions[(long)d2_base_ptr[indices[1]]].get();
-                }
-
-                if (d1_abstraction != nullptr)
-                {
-                    d1_abstraction->store(d1_abstraction->get_base_ptr(), value_ptr,
-                                          {indices[2]});
-                    return;
-                }
-
-                if (d1_abstraction == nullptr || indices[1] == 0)
-                {
-                    if (_memory_abstractions.find((long)d3_base_ptr[0]) !=
-                        _memory_abstractions.end())
-                    {
-                        d2_abstraction = _memory_abstractions[(long)d3_base_ptr[0]].get();
-                        long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                        if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                            _memory_abstractions.end())
-                        {
-                            d1_abstraction = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                        }
-                    }
-
-                    long d3_array_size_bytes = memory_abstraction->get_size_bytes();
-                    long d2_array_size_bytes = d2_abstraction->get_size_bytes();
-                    long d1_array_size_bytes = d1_abstraction->get_size_bytes();
-                    int type_size;
-                    MPI_Type_size(d1_abstraction->get_type(), &type_size);
-
-                    long d1_slice_size = (d1_array_size_bytes / type_size) /
-                                         ((d3_array_size_bytes / sizeof(long *)) *
-                                          (d2_array_size_bytes / sizeof(long *)));
-
-                    long new_index =
-                        indices[0] * (d2_array_size_bytes / sizeof(long *)) * d1_slice_size +
-                        indices[1] * d1_slice_size + indices[2];
-
-                    d1_abstraction->store(d1_abstraction->get_base_ptr(), value_ptr,
-                                          {new_index});
-                }
-                else
-                {
-                    d2_abstraction->store(d2_base_ptr, value_ptr, {indices[1], indices[2]});
-                }
-            }
-        }
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
+    {
+        MPI_Datatype type = get_operation_type(target->get_type(), unsigned_op);
+        target->accumulate(target->get_base_ptr(), value_ptr, result_ptr, IndexSpan(&index, 1),
+                           op, type);
+    }
+    else
+    {
+        std::cerr << "Error: could not do an atomic update of this memory abstraction\n";
     }
 }
 
-void MemoryAbstractionHandler::load(void *base_ptr, void *dest_ptr, std::vector<long> indices)
+void MemoryAbstractionHandler::compare_and_swap_with_handle(long handle, void *value_ptr,
+                                                            void *compare_ptr,
+                                                            void *result_ptr,
+                                                            IndexSpan indices)
 {
     MemoryAbstraction *memory_abstraction = nullptr;
-    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    if (handle >= 0 && handle < (long)_handle_table.size())
     {
-        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+        memory_abstraction = _handle_table[handle];
     }
 
-    if (indices.size() == 1)
+    if (memory_abstraction == nullptr)
     {
-        if (memory_abstraction != nullptr)
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
+    {
+        MPI_Datatype type = get_compare_and_swap_type(target->get_type());
+        target->compare_and_swap(target->get_base_ptr(), value_ptr, compare_ptr, result_ptr,
+                                 IndexSpan(&index, 1), type);
+    }
+    else
+    {
+        std::cerr << "Error: could not do a compare and swap on this memory abstraction\n";
+    }
+}
+
+MPI_Datatype MemoryAbstractionHandler::get_operation_type(MPI_Datatype type, bool unsigned_op)
+{
+    if (unsigned_op)
+    {
+        if (type == MPI_CHAR)
         {
-            memory_abstraction->load(base_ptr, dest_ptr, indices);
+            return MPI_UNSIGNED_CHAR;
         }
-        else
+        else if (type == MPI_INT)
         {
-            std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
-            std::cerr << "Shutting down\n";
-            exit(1);
+            return MPI_UNSIGNED;
         }
+        else if (type == MPI_LONG_LONG)
+        {
+            return MPI_UNSIGNED_LONG_LONG;
+        }
+    }
+    return type;
+}
+
+MPI_Datatype MemoryAbstractionHandler::get_compare_and_swap_type(MPI_Datatype type)
+{
+    int type_size;
+    MPI_Type_size(type, &type_size);
+
+    switch (type_size)
+    {
+    case 1:
+        return MPI_INT8_T;
+    case 2:
+        return MPI_INT16_T;
+    case 4:
+        return MPI_INT32_T;
+    default:
+        return MPI_INT64_T;
     }
-    else if (indices.size() == 2)
+}
+
+long MemoryAbstractionHandler::get_first_owned_index(MemoryAbstraction *memory_abstraction,
+                                                     long num_elements, int rank)
+{
+    // The elements are distributed in blocks, so the owners never decrease with the
+    // index and the owned range can be found with a binary search
+    long low = 0, high = num_elements;
+    while (low < high)
     {
-        if (memory_abstraction != nullptr)
+        long middle = low + (high - low) / 2;
+        if (memory_abstraction->get_owner(middle) < rank)
+        {
+            low = middle + 1;
+        }
+        else
         {
-            int index1 = indices[0];
-            long *d2_base_ptr = (long *)memory_abstraction->get_base_ptr();
+            high = middle;
+        }
+    }
+    return low;
+}
 
-            MemoryAbstraction *sub_array = nullptr;
-            if (_memory_abstractions.find((long)d2_base_ptr[index1]) !=
-                _memory_abstractions.end())
-            {
-                sub_array = _memory_abstractions[(long)d2_base_ptr[index1]].get();
-            }
+void MemoryAbstractionHandler::store(void *base_ptr, void *value_ptr, IndexSpan indices)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
 
-            if (sub_array == nullptr && index1 != 0)
-            {
-                // TODO clean up
-                MemoryAbstraction *first_entry_array = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                    _memory_abstractions.end())
-                {
-                    first_entry_array = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                }
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
 
-                long outer_array_size_bytes = memory_abstraction->get_size_bytes();
-                long inner_array_size_bytes = first_entry_array->get_size_bytes();
-                int type_size;
-                MPI_Type_size(first_entry_array->get_type(), &type_size);
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
+    {
+        target->store(target->get_base_ptr(), value_ptr, IndexSpan(&index, 1));
+    }
+    else
+    {
+        std::cerr << "Error: could not do a store to this memory abstraction\n";
+    }
+}
 
-                long num_elements_row = (inner_array_size_bytes / type_size) /
-                                        (outer_array_size_bytes / sizeof(long *));
+void MemoryAbstractionHandler::load(void *base_ptr, void *dest_ptr, IndexSpan indices)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
 
-                long new_index = (index1 * num_elements_row) + indices[1];
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
 
-                first_entry_array->load(nullptr, dest_ptr, {new_index});
-            }
-            else if (sub_array != nullptr)
-            {
-                sub_array->load(nullptr, dest_ptr, {indices[1]});
-            }
-            else
-            {
-                std::cerr << "Error: could not do a load from this memory abstraction\n";
-            }
-        }
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
+    {
+        target->load(target->get_base_ptr(), dest_ptr, IndexSpan(&index, 1));
     }
-    else if (indices.size() == 3)
+    else
     {
-        if (memory_abstraction != nullptr)
-        {
-            int index0 = indices[0];
-            long *d3_base_ptr = (long *)memory_abstraction->get_base_ptr();
+        std::cerr << "Error: could not do a load from this memory abstraction\n";
+    }
+}
 
-            MemoryAbstraction *d2_abstraction = nullptr;
-            if (_memory_abstractions.find((long)d3_base_ptr[index0]) !=
-                _memory_abstractions.end())
-            {
-                d2_abstraction = _memory_abstractions[(long)d3_base_ptr[index0]].get();
-            }
+void MemoryAbstractionHandler::sequential_store(void *base_ptr, void *value_ptr,
+                                                IndexSpan indices)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
 
-            if (d2_abstraction == nullptr && index0 != 0)
-            {
-                // TODO
-            }
-            else if (d2_abstraction != nullptr)
-            {
-                long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                MemoryAbstraction *d1_abstraction = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[indices[1]]) !=
-                    _memory_abstractions.end())
-                {
-                    d1_abstraction = _memory_abstractions[(long)d2_base_ptr[indices[1]]].get();
-                }
-
-                if (d1_abstraction != nullptr)
-                {
-                    d1_abstraction->load(d1_abstraction->get_base_ptr(), dest_ptr,
-                                         {indices[2]});
-                    return;
-                }
-
-                if (d1_abstraction == nullptr || indices[1] == 0)
-                {
-                    if (_memory_abstractions.find((long)d3_base_ptr[0]) !=
-                        _memory_abstractions.end())
-                    {
-                        d2_abstraction = _memory_abstractions[(long)d3_base_ptr[0]].get();
-                        long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                        if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                            _memory_abstractions.end())
-                        {
-                            d1_abstraction = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                        }
-                    }
-
-                    long d3_array_size_bytes = memory_abstraction->get_size_bytes();
-                    long d2_array_size_bytes = d2_abstraction->get_size_bytes();
-                    long d1_array_size_bytes = d1_abstraction->get_size_bytes();
-                    int type_size;
-                    MPI_Type_size(d1_abstraction->get_type(), &type_size);
-
-                    long d1_slice_size = (d1_array_size_bytes / type_size) /
-                                         ((d3_array_size_bytes / sizeof(long *)) *
-                                          (d2_array_size_bytes / sizeof(long *)));
-
-                    long new_index =
-                        indices[0] * (d2_array_size_bytes / sizeof(long *)) * d1_slice_size +
-                        indices[1] * d1_slice_size + indices[2];
-
-                    d1_abstraction->load(d1_abstraction->get_base_ptr(), dest_ptr,
-                                         {new_index});
-                }
-                else
-                {
-                    d2_abstraction->load(d2_base_ptr, dest_ptr, {indices[1], indices[2]});
-                }
-            }
-        }
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+
+    materialize_memory();
+
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
+    {
+        target->sequential_store(target->get_base_ptr(), value_ptr, IndexSpan(&index, 1));
+    }
+    else
+    {
+        std::cerr << "Error: could not do a store to this memory abstraction\n";
     }
 }
 
-void MemoryAbstractionHandler::sequential_store(void *base_ptr, void *value_ptr,
-                                                std::vector<long> indices)
+void MemoryAbstractionHandler::sequential_load(void *base_ptr, void *dest_ptr,
+                                               IndexSpan indices)
 {
     MemoryAbstraction *memory_abstraction = nullptr;
     if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
@@ -356,306 +452,538 @@ void MemoryAbstractionHandler::sequential_store(void *base_ptr, void *value_ptr,
         memory_abstraction = _memory_abstractions[(long)base_ptr].get();
     }
 
-    if (indices.size() == 1)
+    if (memory_abstraction == nullptr)
     {
-        if (memory_abstraction != nullptr)
-        {
-            memory_abstraction->sequential_store(base_ptr, value_ptr, indices);
-        }
-        else
-        {
-            std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
-            std::cerr << "Shutting down\n";
-            exit(1);
-        }
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
     }
-    else if (indices.size() == 2)
+
+    materialize_memory();
+
+    long index;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &index);
+    if (target != nullptr)
     {
-        if (memory_abstraction != nullptr)
-        {
-            int index1 = indices[0];
-            long *d2_base_ptr = (long *)memory_abstraction->get_base_ptr();
+        target->sequential_load(target->get_base_ptr(), dest_ptr, IndexSpan(&index, 1));
+    }
+    else
+    {
+        std::cerr << "Error: could not do a load from this memory abstraction\n";
+    }
+}
 
-            MemoryAbstraction *sub_array = nullptr;
-            if (_memory_abstractions.find((long)d2_base_ptr[index1]) !=
-                _memory_abstractions.end())
-            {
-                sub_array = _memory_abstractions[(long)d2_base_ptr[index1]].get();
-            }
+void MemoryAbstractionHandler::store_range(void *base_ptr, void *value_ptr, long start,
+                                           long count)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
 
-            if (sub_array == nullptr && index1 != 0)
-            {
-                // TODO clean up
-                MemoryAbstraction *first_entry_array = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                    _memory_abstractions.end())
-                {
-                    first_entry_array = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                }
+    if (memory_abstraction != nullptr)
+    {
+        memory_abstraction->store_range(base_ptr, value_ptr, start, count);
+    }
+    else
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+}
+
+void MemoryAbstractionHandler::load_range(void *base_ptr, void *dest_ptr, long start,
+                                          long count)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
+
+    if (memory_abstraction != nullptr)
+    {
+        memory_abstraction->load_range(base_ptr, dest_ptr, start, count);
+    }
+    else
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+}
+
+void MemoryAbstractionHandler::store_row_range(void *base_ptr, void *value_ptr, long row,
+                                               long start, long count)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
+
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+
+    long indices[2] = {row, start};
+    long index;
+    MemoryAbstraction *target =
+        resolve_access(memory_abstraction, IndexSpan(indices, 2), &index);
+    if (target != nullptr)
+    {
+        target->store_range(target->get_base_ptr(), value_ptr, index, count);
+    }
+    else
+    {
+        std::cerr << "Error: could not do a store to this memory abstraction\n";
+    }
+}
+
+void MemoryAbstractionHandler::load_row_range(void *base_ptr, void *dest_ptr, long row,
+                                              long start, long count)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
 
-                long outer_array_size_bytes = memory_abstraction->get_size_bytes();
-                long inner_array_size_bytes = first_entry_array->get_size_bytes();
-                int type_size;
-                MPI_Type_size(first_entry_array->get_type(), &type_size);
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
 
-                long num_elements_row = (inner_array_size_bytes / type_size) /
-                                        (outer_array_size_bytes / sizeof(long *));
+    long indices[2] = {row, start};
+    long index;
+    MemoryAbstraction *target =
+        resolve_access(memory_abstraction, IndexSpan(indices, 2), &index);
+    if (target != nullptr)
+    {
+        target->load_range(target->get_base_ptr(), dest_ptr, index, count);
+    }
+    else
+    {
+        std::cerr << "Error: could not do a load from this memory abstraction\n";
+    }
+}
 
-                long new_index = (index1 * num_elements_row) + indices[1];
+void MemoryAbstractionHandler::exchange_halo(void *base_ptr, long first, long last)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
 
-                first_entry_array->sequential_store(nullptr, value_ptr, {new_index});
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+
+    if (memory_abstraction->get_dimensions() == 1)
+    {
+        memory_abstraction->exchange_halo(first, last + 1);
+    }
+    else if (memory_abstraction->get_dimensions() == 2)
+    {
+        // The rows can be separate shared memory objects or lie in one contiguous object,
+        // so the element range is collected for each object that holds one of the rows
+        long num_rows = memory_abstraction->get_size_bytes() / sizeof(long *);
+        std::map<MemoryAbstraction *, std::pair<long, long>> ranges;
+        for (long row = std::max(first, 0L); row <= std::min(last, num_rows - 1); row++)
+        {
+            long offset;
+            MemoryAbstraction *sub_array =
+                get_sub_abstraction(memory_abstraction, row, &offset);
+            if (sub_array == nullptr)
+            {
+                continue;
             }
-            else if (sub_array != nullptr)
+
+            long end = offset + sub_array->get_row_elements();
+            auto range = ranges.find(sub_array);
+            if (range == ranges.end())
             {
-                sub_array->sequential_store(nullptr, value_ptr, {indices[1]});
+                ranges[sub_array] = {offset, end};
             }
             else
             {
-                std::cerr << "Error: could not do a store to this memory abstraction\n";
+                range->second.first = std::min(range->second.first, offset);
+                range->second.second = std::max(range->second.second, end);
             }
         }
+
+        for (auto &range : ranges)
+        {
+            range.first->exchange_halo(range.second.first, range.second.second);
+        }
+    }
+}
+
+bool MemoryAbstractionHandler::get_local_rows(void *base_ptr, long *first, long *last,
+                                              long *num_rows)
+{
+    auto entry = _memory_abstractions.find((long)base_ptr);
+    if (entry == _memory_abstractions.end())
+    {
+        return false;
     }
-    else if (indices.size() == 3)
+    MemoryAbstraction *memory_abstraction = entry->second.get();
+
+    if (memory_abstraction->get_dimensions() == 1)
     {
-        if (memory_abstraction != nullptr)
+        int type_size;
+        MPI_Type_size(memory_abstraction->get_type(), &type_size);
+        *num_rows = memory_abstraction->get_size_bytes() / type_size;
+        if (*num_rows == 0 || memory_abstraction->get_owner(0) < 0)
         {
-            int index0 = indices[0];
-            long *d3_base_ptr = (long *)memory_abstraction->get_base_ptr();
+            return false;
+        }
 
-            MemoryAbstraction *d2_abstraction = nullptr;
-            if (_memory_abstractions.find((long)d3_base_ptr[index0]) !=
-                _memory_abstractions.end())
-            {
-                d2_abstraction = _memory_abstractions[(long)d3_base_ptr[index0]].get();
-            }
+        *first = get_first_owned_index(memory_abstraction, *num_rows, _mpi_rank);
+        *last = get_first_owned_index(memory_abstraction, *num_rows, _mpi_rank + 1) - 1;
+        return true;
+    }
 
-            if (d2_abstraction == nullptr && index0 != 0)
-            {
-                // TODO
-            }
-            else if (d2_abstraction != nullptr)
+    // Each row belongs to the owner of its first element. The rows can be separate shared
+    // memory objects, so all of them are checked for a block distribution.
+    *num_rows = memory_abstraction->get_size_bytes() / sizeof(long *);
+    *first = 0;
+    *last = -1;
+    std::vector<long> indices(memory_abstraction->get_dimensions(), 0);
+    int previous_owner = 0;
+    for (long row = 0; row < *num_rows; row++)
+    {
+        long index;
+        indices[0] = row;
+        MemoryAbstraction *sub_array = resolve_access(memory_abstraction, indices, &index);
+        int owner = sub_array != nullptr ? sub_array->get_owner(index) : -1;
+        if (owner < previous_owner)
+        {
+            return false;
+        }
+        previous_owner = owner;
+
+        if (owner == _mpi_rank)
+        {
+            if (*last < *first)
             {
-                long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                MemoryAbstraction *d1_abstraction = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[indices[1]]) !=
-                    _memory_abstractions.end())
-                {
-                    d1_abstraction = _memory_abstractions[(long)d2_base_ptr[indices[1]]].get();
-                }
-
-                if (d1_abstraction != nullptr)
-                {
-                    d1_abstraction->sequential_store(d1_abstraction->get_base_ptr(), value_ptr,
-                                                     {indices[2]});
-                    return;
-                }
-
-                if (d1_abstraction == nullptr || indices[1] == 0)
-                {
-                    if (_memory_abstractions.find((long)d3_base_ptr[0]) !=
-                        _memory_abstractions.end())
-                    {
-                        d2_abstraction = _memory_abstractions[(long)d3_base_ptr[0]].get();
-                        long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                        if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                            _memory_abstractions.end())
-                        {
-                            d1_abstraction = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                        }
-                    }
-
-                    long d3_array_size_bytes = memory_abstraction->get_size_bytes();
-                    long d2_array_size_bytes = d2_abstraction->get_size_bytes();
-                    long d1_array_size_bytes = d1_abstraction->get_size_bytes();
-                    int type_size;
-                    MPI_Type_size(d1_abstraction->get_type(), &type_size);
-
-                    long d1_slice_size = (d1_array_size_bytes / type_size) /
-                                         ((d3_array_size_bytes / sizeof(long *)) *
-                                          (d2_array_size_bytes / sizeof(long *)));
-
-                    long new_index =
-                        indices[0] * (d2_array_size_bytes / sizeof(long *)) * d1_slice_size +
-                        indices[1] * d1_slice_size + indices[2];
-
-                    d1_abstraction->sequential_store(d1_abstraction->get_base_ptr(), value_ptr,
-                                                     {new_index});
-                }
-                else
-                {
-                    d2_abstraction->sequential_store(d2_base_ptr, value_ptr,
-                                                     {indices[1], indices[2]});
-                }
+                *first = row;
             }
+            *last = row;
         }
     }
+    return true;
 }
 
-void MemoryAbstractionHandler::sequential_load(void *base_ptr, void *dest_ptr,
-                                               std::vector<long> indices)
+void *MemoryAbstractionHandler::get_local_range(void *base_ptr, IndexSpan indices, long count,
+                                                long *first, long *local_count)
 {
+    *first = 0;
+    *local_count = 0;
+
     MemoryAbstraction *memory_abstraction = nullptr;
     if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
     {
         memory_abstraction = _memory_abstractions[(long)base_ptr].get();
     }
 
-    if (indices.size() == 1)
+    if (memory_abstraction == nullptr)
     {
-        if (memory_abstraction != nullptr)
-        {
-            memory_abstraction->sequential_load(base_ptr, dest_ptr, indices);
-        }
-        else
-        {
-            std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
-            std::cerr << "Shutting down\n";
-            exit(1);
-        }
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
     }
-    else if (indices.size() == 2)
+
+    materialize_memory();
+
+    long start;
+    MemoryAbstraction *target = resolve_access(memory_abstraction, indices, &start);
+    if (target == nullptr || target->get_dimensions() != 1)
     {
-        if (memory_abstraction != nullptr)
-        {
-            int index1 = indices[0];
-            long *d2_base_ptr = (long *)memory_abstraction->get_base_ptr();
+        std::cerr << "Error: could not do a store to this memory abstraction\n";
+        return nullptr;
+    }
+    if (target->has_snapshot() && !target->is_snapshot_complete())
+    {
+        // Other processes could still read the elements that are written directly
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    target->drop_snapshot();
+    if (std::find(_local_store_targets.begin(), _local_store_targets.end(), target) ==
+        _local_store_targets.end())
+    {
+        _local_store_targets.push_back(target);
+    }
 
-            MemoryAbstraction *sub_array = nullptr;
-            if (_memory_abstractions.find((long)d2_base_ptr[index1]) !=
-                _memory_abstractions.end())
-            {
-                sub_array = _memory_abstractions[(long)d2_base_ptr[index1]].get();
-            }
+    int type_size;
+    MPI_Type_size(target->get_type(), &type_size);
+    long num_elements = target->get_size_bytes() / type_size;
+    if (num_elements == 0)
+    {
+        return nullptr;
+    }
+    if (target->get_owner(0) < 0)
+    {
+        std::cerr << "Error: the elements of this memory abstraction are not distributed\n";
+        return nullptr;
+    }
 
-            if (sub_array == nullptr && index1 != 0)
-            {
-                // TODO clean up
-                MemoryAbstraction *first_entry_array = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                    _memory_abstractions.end())
-                {
-                    first_entry_array = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                }
-                long outer_array_size_bytes = memory_abstraction->get_size_bytes();
-                long inner_array_size_bytes = first_entry_array->get_size_bytes();
-                int type_size;
-                MPI_Type_size(first_entry_array->get_type(), &type_size);
-
-                long num_elements_row = (inner_array_size_bytes / type_size) /
-                                        (outer_array_size_bytes / sizeof(long *));
-
-                long new_index = (index1 * num_elements_row) + indices[1];
-
-                first_entry_array->sequential_load(nullptr, dest_ptr, {new_index});
-            }
-            else if (sub_array != nullptr)
+    long from = std::max(start, get_first_owned_index(target, num_elements, _mpi_rank));
+    long to = std::min(start + count,
+                       get_first_owned_index(target, num_elements, _mpi_rank + 1));
+    if (from >= to)
+    {
+        return nullptr;
+    }
+
+    *first = from - start;
+    *local_count = to - from;
+    return target->get_local_address(from);
+}
+
+void MemoryAbstractionHandler::synchronize_local_stores()
+{
+    for (auto *memory_abstraction : _local_store_targets)
+    {
+        memory_abstraction->synchronize_local_stores();
+    }
+    _local_store_targets.clear();
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void MemoryAbstractionHandler::create_snapshot(void *base_ptr, int reader)
+{
+    MemoryAbstraction *memory_abstraction = nullptr;
+    if (_memory_abstractions.find((long)base_ptr) != _memory_abstractions.end())
+    {
+        memory_abstraction = _memory_abstractions[(long)base_ptr].get();
+    }
+
+    if (memory_abstraction == nullptr)
+    {
+        std::cerr << "Error: Cato Runtime is trying to access an invalid memory section\n";
+        std::cerr << "Shutting down\n";
+        exit(1);
+    }
+
+    materialize_memory();
+
+    // The rows of 2D and 3D objects can be separate shared memory objects or lie in one
+    // contiguous object, so the pointer tables are walked down to the 1D objects. The
+    // order of the objects is the same on all processes.
+    std::vector<MemoryAbstraction *> targets;
+    std::vector<MemoryAbstraction *> tables = {memory_abstraction};
+    while (!tables.empty())
+    {
+        MemoryAbstraction *table = tables.back();
+        tables.pop_back();
+        if (table->get_dimensions() == 1)
+        {
+            if (std::find(targets.begin(), targets.end(), table) == targets.end())
             {
-                sub_array->sequential_load(nullptr, dest_ptr, {indices[1]});
+                targets.push_back(table);
             }
-            else
+            continue;
+        }
+
+        long num_entries = table->get_size_bytes() / sizeof(long *);
+        for (long entry = num_entries - 1; entry >= 0; entry--)
+        {
+            long offset;
+            MemoryAbstraction *sub_abstraction = get_sub_abstraction(table, entry, &offset);
+            if (sub_abstraction != nullptr)
             {
-                std::cerr << "Error: could not do a load from this memory abstraction\n";
+                tables.push_back(sub_abstraction);
             }
         }
     }
-    else if (indices.size() == 3)
+
+    for (auto *target : targets)
+    {
+        target->create_snapshot(reader);
+    }
+}
+
+bool MemoryAbstractionHandler::reduce_scatter(void *target_ptr, void *local_ptr,
+                                              long num_elements, MPI_Datatype type,
+                                              MPI_Op op,
+                                              void (*combine)(void *, void *, long))
+{
+    long offset;
+    MemoryAbstraction *memory_abstraction = find_memory_abstraction(target_ptr, &offset);
+    if (memory_abstraction == nullptr || memory_abstraction->get_dimensions() != 1)
+    {
+        return false;
+    }
+
+    int type_size, element_size;
+    MPI_Type_size(type, &type_size);
+    MPI_Type_size(memory_abstraction->get_type(), &element_size);
+    long size = memory_abstraction->get_size_bytes() / element_size;
+    if (type_size != element_size || offset + num_elements > size ||
+        memory_abstraction->get_owner(0) < 0)
+    {
+        return false;
+    }
+    memory_abstraction->drop_snapshot();
+
+    // The part of the section each process owns, as a block of the send buffer. All
+    // blocks have the size of the largest part, the rest of the smaller ones is unused.
+    std::vector<long> first(_mpi_size + 1);
+    long block = 0;
+    for (int rank = 0; rank <= _mpi_size; rank++)
     {
-        if (memory_abstraction != nullptr)
+        long index = get_first_owned_index(memory_abstraction, size, rank);
+        first[rank] = std::min(std::max(index, offset), offset + num_elements);
+        if (rank > 0)
         {
-            int index0 = indices[0];
-            long *d3_base_ptr = (long *)memory_abstraction->get_base_ptr();
+            block = std::max(block, first[rank] - first[rank - 1]);
+        }
+    }
 
-            MemoryAbstraction *d2_abstraction = nullptr;
-            if (_memory_abstractions.find((long)d3_base_ptr[index0]) !=
-                _memory_abstractions.end())
-            {
-                d2_abstraction = _memory_abstractions[(long)d3_base_ptr[index0]].get();
-            }
+    std::vector<char> send_buffer(_mpi_size * block * type_size, 0);
+    for (int rank = 0; rank < _mpi_size; rank++)
+    {
+        std::memcpy(send_buffer.data() + rank * block * type_size,
+                    (char *)local_ptr + (first[rank] - offset) * type_size,
+                    (first[rank + 1] - first[rank]) * type_size);
+    }
+    std::vector<char> reduced(block * type_size);
+    MPI_Reduce_scatter_block(send_buffer.data(), reduced.data(), block, type, op,
+                             MPI_COMM_WORLD);
 
-            if (d2_abstraction == nullptr && index0 != 0)
-            {
-                // TODO
-            }
-            else if (d2_abstraction != nullptr)
-            {
-                long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                MemoryAbstraction *d1_abstraction = nullptr;
-                if (_memory_abstractions.find((long)d2_base_ptr[indices[1]]) !=
-                    _memory_abstractions.end())
-                {
-                    d1_abstraction = _memory_abstractions[(long)d2_base_ptr[indices[1]]].get();
-                }
-
-                if (d1_abstraction != nullptr)
-                {
-                    d1_abstraction->sequential_load(d1_abstraction->get_base_ptr(), dest_ptr,
-                                                    {indices[2]});
-                    return;
-                }
-
-                if (d1_abstraction == nullptr || indices[1] == 0)
-                {
-                    if (_memory_abstractions.find((long)d3_base_ptr[0]) !=
-                        _memory_abstractions.end())
-                    {
-                        d2_abstraction = _memory_abstractions[(long)d3_base_ptr[0]].get();
-                        long *d2_base_ptr = (long *)d2_abstraction->get_base_ptr();
-                        if (_memory_abstractions.find((long)d2_base_ptr[0]) !=
-                            _memory_abstractions.end())
-                        {
-                            d1_abstraction = _memory_abstractions[(long)d2_base_ptr[0]].get();
-                        }
-                    }
-
-                    long d3_array_size_bytes = memory_abstraction->get_size_bytes();
-                    long d2_array_size_bytes = d2_abstraction->get_size_bytes();
-                    long d1_array_size_bytes = d1_abstraction->get_size_bytes();
-                    int type_size;
-                    MPI_Type_size(d1_abstraction->get_type(), &type_size);
-
-                    long d1_slice_size = (d1_array_size_bytes / type_size) /
-                                         ((d3_array_size_bytes / sizeof(long *)) *
-                                          (d2_array_size_bytes / sizeof(long *)));
-
-                    long new_index =
-                        indices[0] * (d2_array_size_bytes / sizeof(long *)) * d1_slice_size +
-                        indices[1] * d1_slice_size + indices[2];
-
-                    d1_abstraction->sequential_load(d1_abstraction->get_base_ptr(), dest_ptr,
-                                                    {new_index});
-                }
-                else
-                {
-                    d2_abstraction->sequential_load(d2_base_ptr, dest_ptr,
-                                                    {indices[1], indices[2]});
-                }
-            }
+    long count = first[_mpi_rank + 1] - first[_mpi_rank];
+    if (count > 0)
+    {
+        void *base_ptr = memory_abstraction->get_base_ptr();
+        std::vector<char> elements(count * type_size);
+        memory_abstraction->load_range(base_ptr, elements.data(), first[_mpi_rank], count);
+        combine(elements.data(), reduced.data(), count);
+        memory_abstraction->store_range(base_ptr, elements.data(), first[_mpi_rank], count);
+    }
+    return true;
+}
+
+void MemoryAbstractionHandler::epoch_begin()
+{
+    materialize_memory();
+
+    // Processes without the values of a snapshot read the elements from their owners
+    // without any synchronization, so they have to be done before the microtask can write
+    // to the object
+    if (std::any_of(_handle_table.begin(), _handle_table.end(), [](auto *memory_abstraction) {
+            return memory_abstraction != nullptr && memory_abstraction->has_snapshot() &&
+                   !memory_abstraction->is_snapshot_complete();
+        }))
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+    for (auto &memory_abstraction : _memory_abstractions)
+    {
+        memory_abstraction.second->epoch_begin();
+    }
+    _epoch_open = true;
+}
+
+void MemoryAbstractionHandler::epoch_end()
+{
+    for (auto &memory_abstraction : _memory_abstractions)
+    {
+        memory_abstraction.second->epoch_end();
+    }
+    drop_written_snapshots();
+    _epoch_open = false;
+    _materialization_pending = false;
+}
+
+void MemoryAbstractionHandler::drop_written_snapshots()
+{
+    std::vector<MemoryAbstraction *> snapshots;
+    for (auto *memory_abstraction : _handle_table)
+    {
+        if (memory_abstraction != nullptr && memory_abstraction->has_snapshot())
+        {
+            snapshots.push_back(memory_abstraction);
+        }
+    }
+    if (snapshots.empty())
+    {
+        return;
+    }
+
+    // A process only knows about its own writes
+    std::vector<int> written(snapshots.size());
+    for (size_t i = 0; i < snapshots.size(); i++)
+    {
+        written[i] = snapshots[i]->is_snapshot_written();
+    }
+    MPI_Allreduce(MPI_IN_PLACE, written.data(), written.size(), MPI_INT, MPI_LOR,
+                  MPI_COMM_WORLD);
+
+    for (size_t i = 0; i < snapshots.size(); i++)
+    {
+        if (written[i])
+        {
+            snapshots[i]->drop_snapshot();
         }
     }
 }
 
-void MemoryAbstractionHandler::pointer_store(void *dest_ptr, void *source_ptr, long dest_index)
+void MemoryAbstractionHandler::flush()
 {
-    if (dest_index > 0)
+    for (auto &memory_abstraction : _memory_abstractions)
     {
-        dest_ptr = (void *)((char *)dest_ptr - dest_index * sizeof(long *));
+        memory_abstraction.second->flush();
     }
+}
 
-    MemoryAbstraction *memory_abstraction = nullptr;
-    MemoryAbstraction *memory_abstraction2 = nullptr;
-    if (_memory_abstractions.find((long)dest_ptr) != _memory_abstractions.end() &&
-        _memory_abstractions.find((long)source_ptr) != _memory_abstractions.end())
+void MemoryAbstractionHandler::invalidate_caches()
+{
+    for (auto &memory_abstraction : _memory_abstractions)
     {
-        memory_abstraction = _memory_abstractions[(long)dest_ptr].get();
-        memory_abstraction2 = _memory_abstractions[(long)source_ptr].get();
+        memory_abstraction.second->invalidate_cache();
     }
+}
+
+void MemoryAbstractionHandler::pointer_store(void *dest_ptr, void *source_ptr, long dest_index)
+{
+    // dest_ptr is the address of the table entry, which gives the entry independent of the
+    // pointer the program used for the store
+    long entry, offset;
+    MemoryAbstraction *memory_abstraction = find_memory_abstraction(dest_ptr, &entry);
+    MemoryAbstraction *memory_abstraction2 = find_memory_abstraction(source_ptr, &offset);
 
     if (memory_abstraction != nullptr && memory_abstraction2 != nullptr)
     {
-        memory_abstraction->pointer_store(source_ptr, dest_index);
+        memory_abstraction->pointer_store(source_ptr, entry);
+        memory_abstraction->set_sub_abstraction(entry, memory_abstraction2, offset);
+
+        // The rows of nested pointer tables are counted in the outermost table
+        long row = entry;
+        long num_rows = memory_abstraction->get_size_bytes() / sizeof(long *);
+        long table_row, table_num_rows;
+        if (memory_abstraction->get_table_row(&table_row, &table_num_rows))
+        {
+            row += table_row * num_rows;
+            num_rows *= table_num_rows;
+        }
+        memory_abstraction2->add_row_reference(offset, row, num_rows);
     }
     else if (memory_abstraction != nullptr && memory_abstraction2 == nullptr)
     {
+        memory_abstraction->pointer_store(source_ptr, entry);
+        memory_abstraction->set_sub_abstraction(entry, nullptr, 0);
         Debug(std::cout << "Pointer store to memory abstraction does not store the base "
                            "pointer of other memory abstraction\n");
     }
@@ -677,9 +1005,9 @@ void MemoryAbstractionHandler::allocate_shared_value(void *base_ptr, MPI_Datatyp
             std::make_unique<MemoryAbstractionSingleValueDefault>(base_ptr, type);
         memory = memory_abstraction->get_base_ptr();
 
-        // Transfer ownership of the unique_ptr to the map datastructure
-        _single_value_abstractions.insert(
-            std::make_pair((long)memory, std::move(memory_abstraction)));
+        // Transfer ownership of the unique_ptr to the map datastructure. An abstraction
+        // from an earlier parallel section is replaced, because its value is outdated.
+        _single_value_abstractions[(long)memory] = std::move(memory_abstraction);
     }
     else
     {
@@ -717,6 +1045,41 @@ void MemoryAbstractionHandler::shared_value_load(void *base_ptr, void *dest_ptr)
     }
 }
 
+void MemoryAbstractionHandler::shared_value_accumulate(void *base_ptr, void *value_ptr,
+                                                       void *result_ptr, MPI_Op op,
+                                                       bool unsigned_op)
+{
+    MemoryAbstractionSingleValue *memory_abstraction = nullptr;
+    if (_single_value_abstractions.find((long)base_ptr) != _single_value_abstractions.end())
+    {
+        memory_abstraction = _single_value_abstractions[(long)base_ptr].get();
+    }
+
+    if (memory_abstraction != nullptr)
+    {
+        MPI_Datatype type = get_operation_type(memory_abstraction->get_type(), unsigned_op);
+        memory_abstraction->accumulate(base_ptr, value_ptr, result_ptr, op, type);
+    }
+}
+
+void MemoryAbstractionHandler::shared_value_compare_and_swap(void *base_ptr, void *value_ptr,
+                                                             void *compare_ptr,
+                                                             void *result_ptr)
+{
+    MemoryAbstractionSingleValue *memory_abstraction = nullptr;
+    if (_single_value_abstractions.find((long)base_ptr) != _single_value_abstractions.end())
+    {
+        memory_abstraction = _single_value_abstractions[(long)base_ptr].get();
+    }
+
+    if (memory_abstraction != nullptr)
+    {
+        MPI_Datatype type = get_compare_and_swap_type(memory_abstraction->get_type());
+        memory_abstraction->compare_and_swap(base_ptr, value_ptr, compare_ptr, result_ptr,
+                                             type);
+    }
+}
+
 void MemoryAbstractionHandler::shared_value_synchronize(void *base_ptr)
 {
     MemoryAbstractionSingleValue *memory_abstraction = nullptr;
@@ -23,11 +23,85 @@ class MemoryAbstractionHandler
      **/
     std::map<long, std::unique_ptr<MemoryAbstraction>> _memory_abstractions;
 
+    /**
+     * Dense table of all shared memory objects, indexed by their handle.
+     * The entries of freed objects are set to nullptr, handles are not reused.
+     **/
+    std::vector<MemoryAbstraction *> _handle_table;
+
+    // The handles of all existing shared memory objects by their allocation address
+    std::map<long, long> _handles;
+
     std::map<long, std::unique_ptr<MemoryAbstractionSingleValue>> _single_value_abstractions;
 
     int _mpi_rank;
     int _mpi_size;
 
+    // True while the program executes a microtask, see epoch_begin
+    bool _epoch_open;
+
+    // True if shared memory objects have been created since the last materialize_memory
+    bool _materialization_pending;
+
+    // The shared memory objects written through get_local_range since the last
+    // synchronize_local_stores, in the order of the calls, which is the same on all
+    // processes
+    std::vector<MemoryAbstraction *> _local_store_targets;
+
+    /**
+     * Returns the shared memory object that contains the address ptr or nullptr if there
+     * is none. The element offset of ptr inside of the object is written to offset.
+     **/
+    MemoryAbstraction *find_memory_abstraction(void *ptr, long *offset);
+
+    /**
+     * Returns the shared memory object that the pointer stored at the given index of
+     * memory_abstraction points into or nullptr if there is none. The element offset of
+     * the pointer inside of that object is written to offset.
+     **/
+    MemoryAbstraction *get_sub_abstraction(MemoryAbstraction *memory_abstraction, long index,
+                                           long *offset);
+
+    /**
+     * Resolves an access with the given indices on a shared memory object with a pointer
+     * depth >= 1 to the 1D shared memory object that holds the element.
+     * The index of the element inside of that object is written to index.
+     * Returns nullptr if the access can not be resolved.
+     **/
+    MemoryAbstraction *resolve_access(MemoryAbstraction *memory_abstraction,
+                                      IndexSpan indices, long *index);
+
+    /**
+     * Materializes all shared memory objects whose allocation has been deferred (see
+     * MemoryAbstraction::materialize). Has to be called by all processes.
+     **/
+    void materialize_memory();
+
+    /**
+     * Drops the snapshots of all shared memory objects that have been written to by any
+     * process since the snapshot was created. Has to be called by all processes.
+     **/
+    void drop_written_snapshots();
+
+    /**
+     * Returns the type an atomic operation on values of the given type uses. Unsigned
+     * operations need the unsigned variant of an integer type.
+     **/
+    static MPI_Datatype get_operation_type(MPI_Datatype type, bool unsigned_op);
+
+    /**
+     * Returns the integer type with the size of the given type. MPI_Compare_and_swap only
+     * supports integer types, the values are compared bitwise.
+     **/
+    static MPI_Datatype get_compare_and_swap_type(MPI_Datatype type);
+
+    /**
+     * Returns the first of the num_elements elements of a materialized 1D shared memory
+     * object that is owned by rank or a higher rank, or num_elements if there is none
+     **/
+    static long get_first_owned_index(MemoryAbstraction *memory_abstraction,
+                                      long num_elements, int rank);
+
   public:
     MemoryAbstractionHandler(int rank, int size);
 
@@ -47,25 +121,159 @@ class MemoryAbstractionHandler
     /**
      * See MemoryAbstraction::store
      **/
-    void store(void *base_ptr, void *value_ptr, std::vector<long> indices);
+    void store(void *base_ptr, void *value_ptr, IndexSpan indices);
 
     /**
      * See MemoryAbstraction::load
      **/
-    void load(void *base_ptr, void *dest_ptr, std::vector<long> indices);
+    void load(void *base_ptr, void *dest_ptr, IndexSpan indices);
+
+    /**
+     * Returns the handle of the shared memory object at base_ptr or -1 if there is none.
+     * Accesses through a handle avoid the lookup of the base pointer.
+     **/
+    long get_handle(void *base_ptr);
+
+    /**
+     * See MemoryAbstraction::store, the shared memory object is given by its handle
+     **/
+    void store_with_handle(long handle, void *value_ptr, IndexSpan indices);
+
+    /**
+     * See MemoryAbstraction::load, the shared memory object is given by its handle
+     **/
+    void load_with_handle(long handle, void *dest_ptr, IndexSpan indices);
+
+    /**
+     * See MemoryAbstraction::accumulate, the shared memory object is given by its handle.
+     * If unsigned_op is true the elements are compared as unsigned integers.
+     **/
+    void accumulate_with_handle(long handle, void *value_ptr, void *result_ptr,
+                                IndexSpan indices, MPI_Op op, bool unsigned_op);
+
+    /**
+     * See MemoryAbstraction::compare_and_swap, the shared memory object is given by its
+     * handle
+     **/
+    void compare_and_swap_with_handle(long handle, void *value_ptr, void *compare_ptr,
+                                      void *result_ptr, IndexSpan indices);
 
     /**
      * See MemoryAbstraction::sequential_store
      **/
-    void sequential_store(void *base_ptr, void *value_ptr, std::vector<long> indices);
+    void sequential_store(void *base_ptr, void *value_ptr, IndexSpan indices);
 
     /**
      * See MemoryAbstraction::sequential_load
      **/
-    void sequential_load(void *base_ptr, void *dest_ptr, std::vector<long> indices);
+    void sequential_load(void *base_ptr, void *dest_ptr, IndexSpan indices);
+
+    /**
+     * See MemoryAbstraction::store_range
+     **/
+    void store_range(void *base_ptr, void *value_ptr, long start, long count);
+
+    /**
+     * See MemoryAbstraction::load_range
+     **/
+    void load_range(void *base_ptr, void *dest_ptr, long start, long count);
+
+    /**
+     * Stores count elements into the row of a 2D shared memory object, starting at the
+     * element start of the row. The row is written with range transfers to its owners.
+     **/
+    void store_row_range(void *base_ptr, void *value_ptr, long row, long start, long count);
+
+    /**
+     * Loads count elements of the row of a 2D shared memory object, starting at the
+     * element start of the row
+     **/
+    void load_row_range(void *base_ptr, void *dest_ptr, long row, long start, long count);
+
+    /**
+     * Fetches the ghost cells for the elements first to last of a 1D shared memory object
+     * or the rows first to last of a 2D shared memory object, see
+     * MemoryAbstraction::exchange_halo
+     **/
+    void exchange_halo(void *base_ptr, long first, long last);
+
+    /**
+     * Computes which elements of a 1D shared memory object or which rows of a 2D or 3D
+     * shared memory object are stored by this process. The owned elements (rows) are
+     * first to last out of num_rows, or an empty range with last < first.
+     * Returns false if the object is not distributed in contiguous blocks, in the order of
+     * the process ranks.
+     **/
+    bool get_local_rows(void *base_ptr, long *first, long *last, long *num_rows);
+
+    /**
+     * Prepares the stores of a sequential loop to the count consecutive elements of a 1D
+     * shared memory object that start at the element given by indices, which may also
+     * select a row of a 2D or 3D shared memory object.
+     * Returns the address of the first element of the range that is stored by this
+     * process, its position in the range is written to first and the number of elements
+     * of the range stored by this process to local_count. Returns nullptr if there are none.
+     * Has to be called by all processes.
+     **/
+    void *get_local_range(void *base_ptr, IndexSpan indices, long count, long *first,
+                          long *local_count);
+
+    /**
+     * Makes the values written through get_local_range visible to all processes, see
+     * MemoryAbstraction::synchronize_local_stores. Has to be called by all processes.
+     **/
+    void synchronize_local_stores();
 
     /**
-     * See MemoryAbstraction::pointer_store
+     * Creates snapshots of the 1D shared memory objects that hold the elements of the
+     * object at base_ptr for the sequential loads of the process reader, or of all
+     * processes if reader is -1 (see MemoryAbstraction::create_snapshot). The snapshots
+     * are dropped by the first sequential store to the object or at the end of the first
+     * epoch in which a process writes to it. Has to be called by all processes.
+     **/
+    void create_snapshot(void *base_ptr, int reader);
+
+    /**
+     * Reduces the num_elements elements at local_ptr of all processes into the section of
+     * a 1D shared memory object that starts at target_ptr, with one
+     * MPI_Reduce_scatter_block. Each process only receives the reduced elements of the part
+     * of the section it owns and combines them with its elements of the object by calling
+     * combine(elements, reduced_elements, count). type is one element and op reduces
+     * elements of that type.
+     * Returns false if target_ptr does not point into a 1D shared memory object that holds
+     * the whole section. Has to be called by all processes.
+     **/
+    bool reduce_scatter(void *target_ptr, void *local_ptr, long num_elements,
+                        MPI_Datatype type, MPI_Op op,
+                        void (*combine)(void *, void *, long));
+
+    /**
+     * Materializes all shared memory objects and opens a passive target epoch on them (see
+     * MemoryAbstraction::epoch_begin). Shared memory objects created during the epoch
+     * join it directly.
+     **/
+    void epoch_begin();
+
+    /**
+     * See MemoryAbstraction::epoch_end
+     **/
+    void epoch_end();
+
+    /**
+     * See MemoryAbstraction::flush
+     **/
+    void flush();
+
+    /**
+     * See MemoryAbstraction::invalidate_cache
+     **/
+    void invalidate_caches();
+
+    /**
+     * See MemoryAbstraction::pointer_store. dest_ptr is the address of the table entry
+     * the pointer is stored to, dest_index is not needed to find the entry.
+     * The stored pointer is passed to the pointed to shared memory object as a row
+     * reference (see MemoryAbstraction::add_row_reference).
      **/
     void pointer_store(void *dest_ptr, void *source_ptr, long dest_index);
 
@@ -85,6 +293,19 @@ class MemoryAbstractionHandler
      **/
     void shared_value_load(void *base_ptr, void *dest_ptr);
 
+    /**
+     * See MemoryAbstractionSingleValue::accumulate. If unsigned_op is true the values are
+     * compared as unsigned integers.
+     **/
+    void shared_value_accumulate(void *base_ptr, void *value_ptr, void *result_ptr, MPI_Op op,
+                                 bool unsigned_op);
+
+    /**
+     * See MemoryAbstractionSingleValue::compare_and_swap
+     **/
+    void shared_value_compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr,
+                                       void *result_ptr);
+
     /**
      * See MemoryAbstractionSingleValue::synchronize
      **/
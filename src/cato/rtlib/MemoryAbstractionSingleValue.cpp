@@ -14,6 +14,17 @@ void MemoryAbstractionSingleValue::store(void *base_ptr, void *value_ptr) {}
 
 void MemoryAbstractionSingleValue::load(void *base_ptr, void *dest_ptr) {}
 
+void MemoryAbstractionSingleValue::accumulate(void *base_ptr, void *value_ptr,
+                                              void *result_ptr, MPI_Op op, MPI_Datatype type)
+{
+}
+
+void MemoryAbstractionSingleValue::compare_and_swap(void *base_ptr, void *value_ptr,
+                                                    void *compare_ptr, void *result_ptr,
+                                                    MPI_Datatype type)
+{
+}
+
 void MemoryAbstractionSingleValue::synchronize(void *base_ptr) {}
 
 void *MemoryAbstractionSingleValue::get_base_ptr() { return _base_ptr; }
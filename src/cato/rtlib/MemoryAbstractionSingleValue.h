@@ -37,6 +37,26 @@ class MemoryAbstractionSingleValue
      **/
     virtual void load(void *base_ptr, void *dest_ptr);
 
+    /**
+     * This function has to be impplemented by all classes that inherit from this class.
+     * Combines the value at the address value_ptr with the current value of the
+     *MemoryAbstraction using the reduction operation op as one atomic update. The values are
+     *interpreted as the given type, which has the size of the type of the MemoryAbstraction.
+     * If result_ptr is not nullptr the value before the update is copied to it.
+     **/
+    virtual void accumulate(void *base_ptr, void *value_ptr, void *result_ptr, MPI_Op op,
+                            MPI_Datatype type);
+
+    /**
+     * This function has to be impplemented by all classes that inherit from this class.
+     * Atomically replaces the current value of the MemoryAbstraction with the value at
+     *value_ptr if it equals the value at compare_ptr. The value before the operation is
+     *copied to result_ptr. type is an integer type with the size of the type of the
+     *MemoryAbstraction.
+     **/
+    virtual void compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr,
+                                  void *result_ptr, MPI_Datatype type);
+
     /**
      * Synchronizes all local versions of the shared variable for each MPI process.
      * This should be used at the end of a Microtask to make sure that all processes have the
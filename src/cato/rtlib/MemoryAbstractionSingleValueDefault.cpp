@@ -1,5 +1,6 @@
 #include "MemoryAbstractionSingleValueDefault.h"
 
+#include <cstring>
 #include <iostream>
 
 #include "../debug.h"
@@ -16,8 +17,23 @@ MemoryAbstractionSingleValueDefault::MemoryAbstractionSingleValueDefault(void *b
 
     Debug(std::cout << "Trying to create a MPI_Window for a single value variable\n";);
 
-    MPI_Win_create(_base_ptr, type_size, type_size, MPI_INFO_NULL, MPI_COMM_WORLD,
-                   &_mpi_window);
+    // Each epoch holds a single operation, so accumulates need no ordering
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "accumulate_ordering", "none");
+    MPI_Info_set(info, "same_disp_unit", "true");
+    MPI_Win_allocate(_mpi_rank == 0 ? type_size : 0, type_size, info, MPI_COMM_WORLD,
+                     &_value_ptr, &_mpi_window);
+    MPI_Info_free(&info);
+
+    if (_mpi_rank == 0)
+    {
+        MPI_Win_lock(MPI_LOCK_EXCLUSIVE, 0, 0, _mpi_window);
+        std::memcpy(_value_ptr, _base_ptr, type_size);
+        MPI_Win_unlock(0, _mpi_window);
+    }
+    // No process may access the value before it is initialized
+    MPI_Barrier(MPI_COMM_WORLD);
 }
 
 MemoryAbstractionSingleValueDefault::~MemoryAbstractionSingleValueDefault()
@@ -39,11 +55,33 @@ void MemoryAbstractionSingleValueDefault::load(void *base_ptr, void *dest_ptr)
     MPI_Win_unlock(0, _mpi_window);
 }
 
-void MemoryAbstractionSingleValueDefault::synchronize(void *base_ptr)
+void MemoryAbstractionSingleValueDefault::accumulate(void *base_ptr, void *value_ptr,
+                                                     void *result_ptr, MPI_Op op,
+                                                     MPI_Datatype type)
 {
-    MPI_Barrier(MPI_COMM_WORLD);
-    if (_mpi_rank != 0)
+    MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, _mpi_window);
+    if (result_ptr != nullptr)
+    {
+        MPI_Fetch_and_op(value_ptr, result_ptr, type, 0, 0, op, _mpi_window);
+    }
+    else
     {
-        load(base_ptr, base_ptr);
+        MPI_Accumulate(value_ptr, 1, type, 0, 0, 1, type, op, _mpi_window);
     }
+    MPI_Win_unlock(0, _mpi_window);
+}
+
+void MemoryAbstractionSingleValueDefault::compare_and_swap(void *base_ptr, void *value_ptr,
+                                                           void *compare_ptr, void *result_ptr,
+                                                           MPI_Datatype type)
+{
+    MPI_Win_lock(MPI_LOCK_SHARED, 0, 0, _mpi_window);
+    MPI_Compare_and_swap(value_ptr, compare_ptr, result_ptr, type, 0, 0, _mpi_window);
+    MPI_Win_unlock(0, _mpi_window);
+}
+
+void MemoryAbstractionSingleValueDefault::synchronize(void *base_ptr)
+{
+    MPI_Barrier(MPI_COMM_WORLD);
+    load(base_ptr, base_ptr);
 }
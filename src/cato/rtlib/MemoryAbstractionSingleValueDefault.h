@@ -10,17 +10,23 @@
  *communication to always store/load the current value to/from the rank 0 process. At the end
  *of a Microtask the synchronize function neeeds to be called to give all processes the same
  *version of the shared variable before exiting the parallel section.
+ * The value is kept in memory allocated by MPI_Win_allocate on rank 0, which starts with the
+ * value of the variable of rank 0 when the MemoryAbstraction is created.
  **/
 class MemoryAbstractionSingleValueDefault : public MemoryAbstractionSingleValue
 {
   private:
     MPI_Win _mpi_window;
 
+    // The memory of the window, only allocated on rank 0
+    void *_value_ptr;
+
     int _mpi_rank, _mpi_size;
 
   public:
     /**
      * Create the MPI Window for the shared variable at the address base_ptr.
+     * Has to be called by all processes.
      **/
     MemoryAbstractionSingleValueDefault(void *base_ptr, MPI_Datatype type);
 
@@ -41,6 +47,22 @@ class MemoryAbstractionSingleValueDefault : public MemoryAbstractionSingleValue
      **/
     void load(void *base_ptr, void *dest_ptr) override;
 
+    /**
+     * Update the rank 0 processe's version of the shared variable with MPI_Accumulate, or
+     *MPI_Fetch_and_op if the old value is needed.
+     * Atomic operations only hold a shared lock, so updates of different processes do not
+     *wait for each other, while store and load still exclude them with their exclusive lock.
+     **/
+    void accumulate(void *base_ptr, void *value_ptr, void *result_ptr, MPI_Op op,
+                    MPI_Datatype type) override;
+
+    /**
+     * Compare and swap on the rank 0 processe's version of the shared variable with
+     *MPI_Compare_and_swap.
+     **/
+    void compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr, void *result_ptr,
+                          MPI_Datatype type) override;
+
     /**
      * Copy the current value of the shared variable from rank 0 to all other processes.
      **/
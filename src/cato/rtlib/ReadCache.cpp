@@ -0,0 +1,132 @@
+#include "ReadCache.h"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+long ReadCache::_hits = 0;
+long ReadCache::_misses = 0;
+long ReadCache::_fetched_bytes = 0;
+
+/**
+ * Reads a positive number from the given environment variable, returns 0 if it is not set
+ **/
+static long read_environment_number(const char *name)
+{
+    const char *value = std::getenv(name);
+    if (value == nullptr)
+    {
+        return 0;
+    }
+    return std::max(std::atol(value), 0L);
+}
+
+static long configured_line_bytes()
+{
+    static long line_bytes = read_environment_number("CATO_READ_CACHE");
+    return line_bytes;
+}
+
+static long configured_max_lines()
+{
+    static long max_lines = read_environment_number("CATO_READ_CACHE_LINES");
+    return max_lines > 0 ? max_lines : 1024;
+}
+
+ReadCache::ReadCache(int type_size)
+{
+    _type_size = type_size;
+    _line_elements = std::max(configured_line_bytes() / type_size, 1L);
+    _max_lines = configured_max_lines();
+}
+
+bool ReadCache::is_enabled() { return configured_line_bytes() > 0; }
+
+char *ReadCache::lookup(long index)
+{
+    auto line = _lines.find(index / _line_elements);
+    if (line == _lines.end())
+    {
+        _misses++;
+        return nullptr;
+    }
+
+    _hits++;
+    return line->second.data() + (index % _line_elements) * _type_size;
+}
+
+char *ReadCache::insert_line(long index, long count)
+{
+    if ((long)_lines.size() >= _max_lines)
+    {
+        _lines.clear();
+    }
+
+    std::vector<char> &line = _lines[index / _line_elements];
+    line.resize(count * _type_size);
+    _fetched_bytes += count * _type_size;
+    return line.data();
+}
+
+long ReadCache::get_line_start(long index)
+{
+    return (index / _line_elements) * _line_elements;
+}
+
+long ReadCache::get_line_elements() { return _line_elements; }
+
+void ReadCache::update(long start, long count, const void *values)
+{
+    if (_lines.empty())
+    {
+        return;
+    }
+
+    for (long line_number = start / _line_elements;
+         line_number <= (start + count - 1) / _line_elements; line_number++)
+    {
+        auto line = _lines.find(line_number);
+        if (line == _lines.end())
+        {
+            continue;
+        }
+
+        long line_start = line_number * _line_elements;
+        long line_count = line->second.size() / _type_size;
+        long from = std::max(start, line_start);
+        long to = std::min(start + count, line_start + line_count);
+        if (from < to)
+        {
+            std::memcpy(line->second.data() + (from - line_start) * _type_size,
+                        (const char *)values + (from - start) * _type_size,
+                        (to - from) * _type_size);
+        }
+    }
+}
+
+void ReadCache::remove(long index) { _lines.erase(index / _line_elements); }
+
+void ReadCache::invalidate() { _lines.clear(); }
+
+void ReadCache::report_statistics()
+{
+    if (!is_enabled())
+    {
+        return;
+    }
+
+    long local_counters[3] = {_hits, _misses, _fetched_bytes};
+    long counters[3];
+    MPI_Reduce(local_counters, counters, 3, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0)
+    {
+        std::cerr << "CATO read cache: " << counters[0] << " hits, " << counters[1]
+                  << " misses, " << counters[2] << " bytes fetched\n";
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef CATO_RTLIB_READ_CACHE_H
+#define CATO_RTLIB_READ_CACHE_H
+
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Software cache for remote elements of a 1D shared memory object.
+ *
+ * Remote elements are fetched in lines of a fixed number of consecutive elements, which
+ * then serve later loads of the same line locally. Following the OpenMP memory model a
+ * process only has to see the stores of other processes after a synchronization, so the
+ * cache is invalidated at barriers, at the borders of critical sections and at the
+ * begin and end of each microtask. Stores of the own process update cached lines.
+ *
+ * The cache is disabled by default. It gets enabled at runtime with the environment
+ * variable CATO_READ_CACHE, which gives the line size in bytes. CATO_READ_CACHE_LINES
+ * limits the number of lines per shared memory object (default 1024), the whole cache of
+ * the object is dropped if the limit is reached.
+ **/
+class ReadCache
+{
+  private:
+    int _type_size;
+
+    long _line_elements;
+
+    long _max_lines;
+
+    // Cached lines by their line number (global element index / _line_elements)
+    std::unordered_map<long, std::vector<char>> _lines;
+
+    // Statistics over all caches of this process
+    static long _hits;
+    static long _misses;
+    static long _fetched_bytes;
+
+  public:
+    /**
+     * Creates a cache for a shared memory object with elements of type_size bytes
+     **/
+    ReadCache(int type_size);
+
+    /**
+     * Returns true if the read cache is enabled with the environment variable
+     * CATO_READ_CACHE
+     **/
+    static bool is_enabled();
+
+    /**
+     * Returns a pointer to the cached copy of the element with the given global index
+     * or nullptr if the element is not cached. Counts a hit or a miss.
+     **/
+    char *lookup(long index);
+
+    /**
+     * Creates the line that contains the element with the given global index and returns
+     * its buffer. The buffer has space for count elements starting at get_line_start and
+     * has to be filled by the caller.
+     **/
+    char *insert_line(long index, long count);
+
+    /**
+     * Returns the global index of the first element of the line containing index
+     **/
+    long get_line_start(long index);
+
+    long get_line_elements();
+
+    /**
+     * Copies count values starting at the global index start into all cached lines that
+     * contain them. Has to be called for every store of the own process.
+     **/
+    void update(long start, long count, const void *values);
+
+    /**
+     * Drops the line that contains the element with the given global index. Has to be
+     * called for every atomic update of the own process, whose new value is not known.
+     **/
+    void remove(long index);
+
+    /**
+     * Drops all cached lines
+     **/
+    void invalidate();
+
+    /**
+     * Prints the hit and miss counters summed over all processes on rank 0.
+     * Has to be called by all processes before MPI_Finalize.
+     **/
+    static void report_statistics();
+};
+
+#endif
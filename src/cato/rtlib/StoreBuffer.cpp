@@ -0,0 +1,91 @@
+#include "StoreBuffer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+
+/**
+ * Returns the buffer capacity per target from CATO_STORE_BUFFER or the default capacity
+ **/
+static long configured_capacity()
+{
+    static long capacity = []() {
+        const char *value = std::getenv("CATO_STORE_BUFFER");
+        if (value == nullptr)
+        {
+            return 1024L;
+        }
+        return std::max(std::atol(value), 0L);
+    }();
+    return capacity;
+}
+
+StoreBuffer::StoreBuffer(int num_targets, int type_size)
+{
+    _type_size = type_size;
+    _capacity = configured_capacity();
+    _targets.resize(num_targets);
+}
+
+bool StoreBuffer::is_enabled() { return configured_capacity() > 0; }
+
+bool StoreBuffer::add(int target, long disp, const void *value)
+{
+    TargetBuffer &buffer = _targets[target];
+    buffer.displacements.push_back(disp);
+    buffer.values.insert(buffer.values.end(), (const char *)value,
+                         (const char *)value + _type_size);
+    return (long)buffer.displacements.size() >= _capacity;
+}
+
+bool StoreBuffer::is_empty(int target) { return _targets[target].displacements.empty(); }
+
+void StoreBuffer::take_runs(int target, std::vector<char> &values,
+                            std::vector<long> &displacements, std::vector<int> &block_lengths)
+{
+    TargetBuffer &buffer = _targets[target];
+    long num_stores = buffer.displacements.size();
+
+    // Sort the stores by their displacement. The sort is stable, so for repeated stores
+    // to the same element the last one in the order is the last one issued.
+    std::vector<long> order(num_stores);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buffer](long a, long b) {
+        return buffer.displacements[a] < buffer.displacements[b];
+    });
+
+    values.clear();
+    displacements.clear();
+    block_lengths.clear();
+    values.reserve(num_stores * _type_size);
+
+    for (long i = 0; i < num_stores; i++)
+    {
+        long disp = buffer.displacements[order[i]];
+        if (i + 1 < num_stores && buffer.displacements[order[i + 1]] == disp)
+        {
+            // Overwritten by a later store
+            continue;
+        }
+
+        const char *value = buffer.values.data() + order[i] * _type_size;
+        values.insert(values.end(), value, value + _type_size);
+
+        if (!displacements.empty() &&
+            displacements.back() + block_lengths.back() == disp &&
+            block_lengths.back() < INT_MAX)
+        {
+            block_lengths.back()++;
+        }
+        else
+        {
+            displacements.push_back(disp);
+            block_lengths.push_back(1);
+        }
+    }
+
+    buffer.displacements.clear();
+    buffer.values.clear();
+}
@@ -0,0 +1,62 @@
+#ifndef CATO_RTLIB_STORE_BUFFER_H
+#define CATO_RTLIB_STORE_BUFFER_H
+
+#include <vector>
+
+/**
+ * Write combining buffers for single element stores to remote partitions of a 1D shared
+ * memory object, one buffer per target process.
+ *
+ * Instead of one RMA operation per element the stores are collected and written with one
+ * operation per target when the buffer is flushed. Repeated stores to the same element
+ * only keep the last value and neighbouring elements are combined into runs.
+ *
+ * The buffers are enabled by default with a capacity of 1024 elements per target. The
+ * environment variable CATO_STORE_BUFFER sets another capacity, 0 disables the buffers.
+ **/
+class StoreBuffer
+{
+  private:
+    int _type_size;
+
+    long _capacity;
+
+    // The buffered stores of one target process in the order they were issued
+    struct TargetBuffer
+    {
+        std::vector<long> displacements;
+        std::vector<char> values;
+    };
+
+    std::vector<TargetBuffer> _targets;
+
+  public:
+    /**
+     * Creates empty buffers for num_targets processes and elements of type_size bytes
+     **/
+    StoreBuffer(int num_targets, int type_size);
+
+    /**
+     * Returns false if the buffers are disabled with CATO_STORE_BUFFER=0
+     **/
+    static bool is_enabled();
+
+    /**
+     * Buffers the store of the value to the element at disp of the target process.
+     * Returns true if the buffer of the target is full and has to be flushed.
+     **/
+    bool add(int target, long disp, const void *value);
+
+    bool is_empty(int target);
+
+    /**
+     * Combines the buffered stores of the target into runs of consecutive elements and
+     * empties the buffer. The values of all runs are written to values, the start of
+     * each run to displacements and its length to block_lengths. The runs are sorted by
+     * their displacement.
+     **/
+    void take_runs(int target, std::vector<char> &values, std::vector<long> &displacements,
+                   std::vector<int> &block_lengths);
+};
+
+#endif
@@ -1,61 +1,62 @@
-// source from https://gist.github.com/aprell/1486197
-
 #include <assert.h>
-#include <iostream>
 #include <mpi.h>
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
 
 #include "mpi_mutex.h"
 
-// do not suggest to inline any mutex functions
+// Displacements of the slots in the window of each process
+#define MPI_MUTEX_TAIL 0
+#define MPI_MUTEX_NEXT 1
+#define MPI_MUTEX_BLOCKED 2
 
-int MPI_Mutex_init(MPI_Mutex **mutex, int home)
-{
-    static int tag = MPI_MUTEX_MSG_TAG_BASE;
-    int numprocs, ID;
-    MPI_Mutex *mtx;
+// Marks an empty queue or a process without successor
+#define MPI_MUTEX_NONE -1
 
-    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
-    MPI_Comm_rank(MPI_COMM_WORLD, &ID);
+/**
+ * Atomically reads the slot at disp in the own window
+ **/
+static int read_own_slot(MPI_Mutex *mutex, int disp)
+{
+    int unused = 0;
+    int value;
+    MPI_Fetch_and_op(&unused, &value, MPI_INT, mutex->ID, disp, MPI_NO_OP, mutex->win);
+    MPI_Win_flush(mutex->ID, mutex->win);
+    return value;
+}
 
-    mtx = (MPI_Mutex *)malloc(sizeof(MPI_Mutex));
-    if (!mtx)
-    {
-        std::cerr << "Warning: malloc failed on worker " << ID << "\n";
-        return 1;
-    }
+/**
+ * Atomically writes value into the slot at disp in the window of the target process
+ **/
+static void write_slot(MPI_Mutex *mutex, int target, int disp, int value)
+{
+    MPI_Accumulate(&value, 1, MPI_INT, target, disp, 1, MPI_INT, MPI_REPLACE, mutex->win);
+    MPI_Win_flush(target, mutex->win);
+}
 
-    mtx->numprocs = numprocs;
-    mtx->ID = ID;
+int MPI_Mutex_init(MPI_Mutex **mutex, int home)
+{
+    MPI_Mutex *mtx = new MPI_Mutex;
+    MPI_Comm_size(MPI_COMM_WORLD, &mtx->numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &mtx->ID);
     mtx->home = home;
-    mtx->tag = tag++;
-    mtx->comm = MPI_COMM_WORLD;
 
-    if (ID == mtx->home)
-    {
-        // Allocate and expose waitlist
-        MPI_Alloc_mem(mtx->numprocs, MPI_INFO_NULL, &mtx->waitlist);
-        if (!mtx->waitlist)
-        {
-            std::cerr << "Warning: MPI_Alloc_mem failed on worker " << ID << "\n";
-            return 1;
-        }
-        memset(mtx->waitlist, 0, mtx->numprocs);
-        MPI_Win_create(mtx->waitlist, mtx->numprocs, 1, MPI_INFO_NULL, mtx->comm, &mtx->win);
-    }
-    else
-    {
-        // Don't expose anything
-        mtx->waitlist = NULL;
-        MPI_Win_create(mtx->waitlist, 0, 1, MPI_INFO_NULL, mtx->comm, &mtx->win);
-    }
+    // Every operation on the slots is completed before the next one is issued
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "accumulate_ordering", "none");
+    MPI_Info_set(info, "same_size", "true");
+    MPI_Info_set(info, "same_disp_unit", "true");
+    MPI_Win_allocate(3 * sizeof(int), sizeof(int), info, MPI_COMM_WORLD, &mtx->slots,
+                     &mtx->win);
+    MPI_Info_free(&info);
 
-    *mutex = mtx;
+    mtx->slots[MPI_MUTEX_TAIL] = MPI_MUTEX_NONE;
+    mtx->slots[MPI_MUTEX_NEXT] = MPI_MUTEX_NONE;
+    mtx->slots[MPI_MUTEX_BLOCKED] = 0;
 
     MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, mtx->win);
 
+    *mutex = mtx;
     return 0;
 }
 
@@ -63,24 +64,8 @@ int MPI_Mutex_destroy(MPI_Mutex *mutex)
 {
     assert(mutex != NULL);
 
-    int ID;
-
-    MPI_Barrier(MPI_COMM_WORLD);
-
-    MPI_Comm_rank(MPI_COMM_WORLD, &ID);
-
-    if (ID == mutex->home)
-    {
-        // Free waitlist
-        MPI_Win_free(&mutex->win);
-        MPI_Free_mem(mutex->waitlist);
-    }
-    else
-    {
-        MPI_Win_free(&mutex->win);
-        assert(mutex->waitlist == NULL);
-    }
-
+    MPI_Win_unlock_all(mutex->win);
+    MPI_Win_free(&mutex->win);
     return 0;
 }
 
@@ -88,36 +73,25 @@ int MPI_Mutex_lock(MPI_Mutex *mutex)
 {
     assert(mutex != NULL);
 
-    char waitlist[mutex->numprocs];
-    char lock = 1;
-    int i;
-
-    // Try to acquire lock in one access epoch
-    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, mutex->home, 0, mutex->win);
-    MPI_Put(&lock, 1, MPI_CHAR, mutex->home, mutex->ID /* &win[mutex->ID] */, 1, MPI_CHAR,
-            mutex->win);
-    MPI_Get(waitlist, mutex->numprocs, MPI_CHAR, mutex->home, 0, mutex->numprocs, MPI_CHAR,
-            mutex->win);
-    MPI_Win_unlock(mutex->home, mutex->win);
+    // No other process accesses the own slots while this process is not in the queue
+    mutex->slots[MPI_MUTEX_NEXT] = MPI_MUTEX_NONE;
+    mutex->slots[MPI_MUTEX_BLOCKED] = 1;
+    MPI_Win_sync(mutex->win);
 
-    assert(waitlist[mutex->ID] == 1);
+    // Append this process to the queue
+    int predecessor;
+    MPI_Fetch_and_op(&mutex->ID, &predecessor, MPI_INT, mutex->home, MPI_MUTEX_TAIL,
+                     MPI_REPLACE, mutex->win);
+    MPI_Win_flush(mutex->home, mutex->win);
 
-    // Count the 1's
-    for (i = 0; i < mutex->numprocs; i++)
+    if (predecessor != MPI_MUTEX_NONE)
     {
-        if (waitlist[i] == 1 && i != mutex->ID)
+        // Tell the predecessor who comes next and wait until it hands the mutex over
+        write_slot(mutex, predecessor, MPI_MUTEX_NEXT, mutex->ID);
+        while (read_own_slot(mutex, MPI_MUTEX_BLOCKED) != 0)
         {
-            // We have to wait for the lock
-            // Dummy receive, no payload
-            // std::cout << "Worker " << mutex->ID << " waits for lock\n";
-            MPI_Recv(&lock, 0, MPI_CHAR, MPI_ANY_SOURCE, mutex->tag, mutex->comm,
-                     MPI_STATUS_IGNORE);
-            break;
         }
     }
-
-    // std::cout << "Worker " << mutex->ID << " has the lock\n";
-
     return 0;
 }
 
@@ -125,65 +99,41 @@ int MPI_Mutex_trylock(MPI_Mutex *mutex)
 {
     assert(mutex != NULL);
 
-    char waitlist[mutex->numprocs];
-    char lock = 1;
-    int i;
-
-    // Try to acquire lock in one access epoch
-    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, mutex->home, 0, mutex->win);
-    MPI_Put(&lock, 1, MPI_CHAR, mutex->home, mutex->ID /* &win[mutex->ID] */, 1, MPI_CHAR,
-            mutex->win);
-    MPI_Get(waitlist, mutex->numprocs, MPI_CHAR, mutex->home, 0, mutex->numprocs, MPI_CHAR,
-            mutex->win);
-    MPI_Win_unlock(mutex->home, mutex->win);
+    mutex->slots[MPI_MUTEX_NEXT] = MPI_MUTEX_NONE;
+    mutex->slots[MPI_MUTEX_BLOCKED] = 0;
+    MPI_Win_sync(mutex->win);
 
-    assert(waitlist[mutex->ID] == 1);
+    // Only take the mutex if the queue is empty
+    int none = MPI_MUTEX_NONE;
+    int tail;
+    MPI_Compare_and_swap(&mutex->ID, &none, &tail, MPI_INT, mutex->home, MPI_MUTEX_TAIL,
+                         mutex->win);
+    MPI_Win_flush(mutex->home, mutex->win);
 
-    // Count the 1's
-    for (i = 0; i < mutex->numprocs; i++)
-    {
-        if (waitlist[i] == 1 && i != mutex->ID)
-        {
-            // Lock is already held, return immediately
-            return 1;
-        }
-    }
-
-    // std::cout << "Worker " << mutex->ID << " has the lock\n";
-
-    return 0;
+    // Return 1 if the mutex is already held
+    return tail == MPI_MUTEX_NONE ? 0 : 1;
 }
 
 int MPI_Mutex_unlock(MPI_Mutex *mutex)
 {
     assert(mutex != NULL);
 
-    char waitlist[mutex->numprocs];
-    char lock = 0;
-    int i, next;
-
-    MPI_Win_lock(MPI_LOCK_EXCLUSIVE, mutex->home, 0, mutex->win);
-    MPI_Put(&lock, 1, MPI_CHAR, mutex->home, mutex->ID /* &win[mutex->ID] */, 1, MPI_CHAR,
-            mutex->win);
-    MPI_Get(waitlist, mutex->numprocs, MPI_CHAR, mutex->home, 0, mutex->numprocs, MPI_CHAR,
-            mutex->win);
-    MPI_Win_unlock(mutex->home, mutex->win);
-
-    assert(waitlist[mutex->ID] == 0);
-
-    // If there are other processes waiting for the lock, transfer ownership
-    next = (mutex->ID + 1 + mutex->numprocs) % mutex->numprocs;
-    for (i = 0; i < mutex->numprocs; i++, next = (next + 1) % mutex->numprocs)
+    // Empty the queue if this process is still its tail
+    int none = MPI_MUTEX_NONE;
+    int tail;
+    MPI_Compare_and_swap(&none, &mutex->ID, &tail, MPI_INT, mutex->home, MPI_MUTEX_TAIL,
+                         mutex->win);
+    MPI_Win_flush(mutex->home, mutex->win);
+    if (tail == mutex->ID)
     {
-        if (waitlist[next] == 1)
-        {
-            // Dummy send, no payload
-            // std::cout << "Worker " << mutex->ID << " transfers lock ownership to worker " <<
-            // mutex->ID << "\n";
-            MPI_Send(&lock, 0, MPI_CHAR, next, mutex->tag, mutex->comm);
-            break;
-        }
+        return 0;
     }
 
+    // A successor has enqueued itself, wait until it has registered and hand the mutex over
+    int successor;
+    while ((successor = read_own_slot(mutex, MPI_MUTEX_NEXT)) == MPI_MUTEX_NONE)
+    {
+    }
+    write_slot(mutex, successor, MPI_MUTEX_BLOCKED, 0);
     return 0;
 }
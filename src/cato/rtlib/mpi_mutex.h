@@ -1,17 +1,24 @@
-// source from https://gist.github.com/aprell/1486197
 #ifndef MPI_MUTEX_H_
 #define MPI_MUTEX_H_
 
 #include <mpi.h>
 
-#define MPI_MUTEX_MSG_TAG_BASE 1023
-
+/**
+ * Distributed MCS queue lock. The processes that wait for the mutex form a queue, each of
+ * them only knows its successor. The home process stores the tail of the queue, a process
+ * enqueues itself with one atomic swap of the tail and then waits on a flag in its own
+ * window until its predecessor hands the mutex over. Acquiring and releasing the mutex
+ * therefore takes a constant number of RMA operations, independent of the number of
+ * processes.
+ **/
 struct MPI_Mutex
 {
-    int numprocs, ID, home, tag;
-    MPI_Comm comm;
+    int numprocs, ID, home;
     MPI_Win win;
-    char *waitlist;
+
+    // Exposed in win: the tail of the queue (only used on the home process), the
+    // successor in the queue and the flag that is cleared when the mutex is handed over
+    int *slots;
 };
 
 int MPI_Mutex_init(MPI_Mutex **mutex, int home);
@@ -3,9 +3,16 @@
 #include <mpi.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <climits>
 #include <cstdarg>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <vector>
 
+#include "ReadCache.h"
 #include "mpi_mutex.h"
 #include <fstream>
 
@@ -24,6 +31,7 @@ void cato_initialize(bool logging)
     MPI_Errhandler_set(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
 
     _memory_handler = std::make_unique<MemoryAbstractionHandler>(MPI_RANK, MPI_SIZE);
+    _loop_scheduler = std::make_unique<LoopScheduler>();
 
     if (logging)
     {
@@ -31,9 +39,21 @@ void cato_initialize(bool logging)
     }
 }
 
+/**
+ * Waits for all reductions that have been started but not completed by reduction_wait. Their
+ * results are never used.
+ **/
+static void finish_pending_reductions();
+
 void cato_finalize()
 {
+    finish_pending_reductions();
+
     _memory_handler.reset();
+    _loop_scheduler->report_statistics();
+    _loop_scheduler.reset();
+
+    ReadCache::report_statistics();
 
     CatoRuntimeLogger::stop_logger();
 
@@ -44,7 +64,15 @@ int get_mpi_rank() { return MPI_RANK; }
 
 int get_mpi_size() { return MPI_SIZE; }
 
-void mpi_barrier() { MPI_Barrier(MPI_COMM_WORLD); }
+void mpi_barrier()
+{
+    _memory_handler->flush();
+    MPI_Barrier(MPI_COMM_WORLD);
+}
+
+void shared_memory_epoch_begin() { _memory_handler->epoch_begin(); }
+
+void shared_memory_epoch_end() { _memory_handler->epoch_end(); }
 
 void *allocate_shared_memory(long size, MPI_Datatype type, int dimensions)
 {
@@ -69,6 +97,24 @@ void shared_memory_store(void *base_ptr, void *value_ptr, int num_indices, ...)
     _memory_handler->store(base_ptr, value_ptr, indices);
 }
 
+void shared_memory_store_1d(void *base_ptr, void *value_ptr, long index0)
+{
+    _memory_handler->store(base_ptr, value_ptr, IndexSpan(&index0, 1));
+}
+
+void shared_memory_store_2d(void *base_ptr, void *value_ptr, long index0, long index1)
+{
+    long indices[2] = {index0, index1};
+    _memory_handler->store(base_ptr, value_ptr, IndexSpan(indices, 2));
+}
+
+void shared_memory_store_3d(void *base_ptr, void *value_ptr, long index0, long index1,
+                            long index2)
+{
+    long indices[3] = {index0, index1, index2};
+    _memory_handler->store(base_ptr, value_ptr, IndexSpan(indices, 3));
+}
+
 void shared_memory_load(void *base_ptr, void *dest_ptr, int num_indices, ...)
 {
     std::vector<long> indices;
@@ -85,6 +131,139 @@ void shared_memory_load(void *base_ptr, void *dest_ptr, int num_indices, ...)
     _memory_handler->load(base_ptr, dest_ptr, indices);
 }
 
+void shared_memory_load_1d(void *base_ptr, void *dest_ptr, long index0)
+{
+    _memory_handler->load(base_ptr, dest_ptr, IndexSpan(&index0, 1));
+}
+
+void shared_memory_load_2d(void *base_ptr, void *dest_ptr, long index0, long index1)
+{
+    long indices[2] = {index0, index1};
+    _memory_handler->load(base_ptr, dest_ptr, IndexSpan(indices, 2));
+}
+
+void shared_memory_load_3d(void *base_ptr, void *dest_ptr, long index0, long index1,
+                           long index2)
+{
+    long indices[3] = {index0, index1, index2};
+    _memory_handler->load(base_ptr, dest_ptr, IndexSpan(indices, 3));
+}
+
+long shared_memory_handle(void *base_ptr) { return _memory_handler->get_handle(base_ptr); }
+
+void shared_memory_store_with_handle(long handle, void *value_ptr, int num_indices, ...)
+{
+    std::vector<long> indices;
+
+    // Read the pointer access indices
+    va_list ap;
+    va_start(ap, num_indices);
+    for (int i = 0; i < num_indices; i++)
+    {
+        indices.push_back(va_arg(ap, long));
+    }
+    va_end(ap);
+
+    _memory_handler->store_with_handle(handle, value_ptr, indices);
+}
+
+void shared_memory_store_with_handle_1d(long handle, void *value_ptr, long index0)
+{
+    _memory_handler->store_with_handle(handle, value_ptr, IndexSpan(&index0, 1));
+}
+
+void shared_memory_store_with_handle_2d(long handle, void *value_ptr, long index0, long index1)
+{
+    long indices[2] = {index0, index1};
+    _memory_handler->store_with_handle(handle, value_ptr, IndexSpan(indices, 2));
+}
+
+void shared_memory_store_with_handle_3d(long handle, void *value_ptr, long index0, long index1,
+                                        long index2)
+{
+    long indices[3] = {index0, index1, index2};
+    _memory_handler->store_with_handle(handle, value_ptr, IndexSpan(indices, 3));
+}
+
+void shared_memory_load_with_handle(long handle, void *dest_ptr, int num_indices, ...)
+{
+    std::vector<long> indices;
+
+    // Read the pointer access indices
+    va_list ap;
+    va_start(ap, num_indices);
+    for (int i = 0; i < num_indices; i++)
+    {
+        indices.push_back(va_arg(ap, long));
+    }
+    va_end(ap);
+
+    _memory_handler->load_with_handle(handle, dest_ptr, indices);
+}
+
+void shared_memory_load_with_handle_1d(long handle, void *dest_ptr, long index0)
+{
+    _memory_handler->load_with_handle(handle, dest_ptr, IndexSpan(&index0, 1));
+}
+
+void shared_memory_load_with_handle_2d(long handle, void *dest_ptr, long index0, long index1)
+{
+    long indices[2] = {index0, index1};
+    _memory_handler->load_with_handle(handle, dest_ptr, IndexSpan(indices, 2));
+}
+
+void shared_memory_load_with_handle_3d(long handle, void *dest_ptr, long index0, long index1,
+                                       long index2)
+{
+    long indices[3] = {index0, index1, index2};
+    _memory_handler->load_with_handle(handle, dest_ptr, IndexSpan(indices, 3));
+}
+
+void shared_memory_atomic_with_handle(long handle, void *value_ptr, void *result_ptr,
+                                      int bin_op, int num_indices, ...)
+{
+    std::vector<long> indices;
+
+    // Read the pointer access indices
+    va_list ap;
+    va_start(ap, num_indices);
+    for (int i = 0; i < num_indices; i++)
+    {
+        indices.push_back(va_arg(ap, long));
+    }
+    va_end(ap);
+
+    MPI_Op op = get_mpi_op(bin_op);
+    if (op == MPI_OP_NULL)
+    {
+        std::cerr << "Error: unknown operation for an atomic update\n";
+        return;
+    }
+    bool unsigned_op = bin_op == BinOp::UMax || bin_op == BinOp::UMin;
+
+    _memory_handler->accumulate_with_handle(handle, value_ptr, result_ptr, indices, op,
+                                            unsigned_op);
+}
+
+void shared_memory_compare_and_swap_with_handle(long handle, void *value_ptr,
+                                                void *compare_ptr, void *result_ptr,
+                                                int num_indices, ...)
+{
+    std::vector<long> indices;
+
+    // Read the pointer access indices
+    va_list ap;
+    va_start(ap, num_indices);
+    for (int i = 0; i < num_indices; i++)
+    {
+        indices.push_back(va_arg(ap, long));
+    }
+    va_end(ap);
+
+    _memory_handler->compare_and_swap_with_handle(handle, value_ptr, compare_ptr, result_ptr,
+                                                  indices);
+}
+
 void shared_memory_sequential_store(void *base_ptr, void *value_ptr, int num_indices, ...)
 {
     std::vector<long> indices;
@@ -101,6 +280,25 @@ void shared_memory_sequential_store(void *base_ptr, void *value_ptr, int num_ind
     _memory_handler->sequential_store(base_ptr, value_ptr, indices);
 }
 
+void shared_memory_sequential_store_1d(void *base_ptr, void *value_ptr, long index0)
+{
+    _memory_handler->sequential_store(base_ptr, value_ptr, IndexSpan(&index0, 1));
+}
+
+void shared_memory_sequential_store_2d(void *base_ptr, void *value_ptr, long index0,
+                                       long index1)
+{
+    long indices[2] = {index0, index1};
+    _memory_handler->sequential_store(base_ptr, value_ptr, IndexSpan(indices, 2));
+}
+
+void shared_memory_sequential_store_3d(void *base_ptr, void *value_ptr, long index0,
+                                       long index1, long index2)
+{
+    long indices[3] = {index0, index1, index2};
+    _memory_handler->sequential_store(base_ptr, value_ptr, IndexSpan(indices, 3));
+}
+
 void shared_memory_sequential_load(void *base_ptr, void *dest_ptr, int num_indices, ...)
 {
     std::vector<long> indices;
@@ -117,6 +315,73 @@ void shared_memory_sequential_load(void *base_ptr, void *dest_ptr, int num_indic
     _memory_handler->sequential_load(base_ptr, dest_ptr, indices);
 }
 
+void shared_memory_sequential_load_1d(void *base_ptr, void *dest_ptr, long index0)
+{
+    _memory_handler->sequential_load(base_ptr, dest_ptr, IndexSpan(&index0, 1));
+}
+
+void shared_memory_sequential_load_2d(void *base_ptr, void *dest_ptr, long index0, long index1)
+{
+    long indices[2] = {index0, index1};
+    _memory_handler->sequential_load(base_ptr, dest_ptr, IndexSpan(indices, 2));
+}
+
+void shared_memory_sequential_load_3d(void *base_ptr, void *dest_ptr, long index0, long index1,
+                                      long index2)
+{
+    long indices[3] = {index0, index1, index2};
+    _memory_handler->sequential_load(base_ptr, dest_ptr, IndexSpan(indices, 3));
+}
+
+void shared_memory_store_range(void *base_ptr, void *value_ptr, long start, long count)
+{
+    _memory_handler->store_range(base_ptr, value_ptr, start, count);
+}
+
+void shared_memory_load_range(void *base_ptr, void *dest_ptr, long start, long count)
+{
+    _memory_handler->load_range(base_ptr, dest_ptr, start, count);
+}
+
+void shared_memory_store_range_2d(void *base_ptr, void *value_ptr, long index0, long start,
+                                  long count)
+{
+    _memory_handler->store_row_range(base_ptr, value_ptr, index0, start, count);
+}
+
+void shared_memory_load_range_2d(void *base_ptr, void *dest_ptr, long index0, long start,
+                                 long count)
+{
+    _memory_handler->load_row_range(base_ptr, dest_ptr, index0, start, count);
+}
+
+void shared_memory_exchange_halo(void *base_ptr, long first, long last)
+{
+    _memory_handler->exchange_halo(base_ptr, first, last);
+}
+
+void *shared_memory_sequential_local_range(void *base_ptr, long start, long count,
+                                           long *first, long *local_count)
+{
+    return _memory_handler->get_local_range(base_ptr, IndexSpan(&start, 1), count, first,
+                                            local_count);
+}
+
+void *shared_memory_sequential_local_range_2d(void *base_ptr, long index0, long start,
+                                              long count, long *first, long *local_count)
+{
+    long indices[2] = {index0, start};
+    return _memory_handler->get_local_range(base_ptr, IndexSpan(indices, 2), count, first,
+                                            local_count);
+}
+
+void shared_memory_sequential_local_end() { _memory_handler->synchronize_local_stores(); }
+
+void shared_memory_sequential_snapshot(void *base_ptr, int reader)
+{
+    _memory_handler->create_snapshot(base_ptr, reader);
+}
+
 void shared_memory_pointer_store(void *dest_ptr, void *source_ptr, long dest_index)
 {
     _memory_handler->pointer_store(dest_ptr, source_ptr, dest_index);
@@ -137,6 +402,40 @@ void shared_value_load(void *base_ptr, void *dest_ptr)
     _memory_handler->shared_value_load(base_ptr, dest_ptr);
 }
 
+void shared_value_accumulate(void *base_ptr, void *value_ptr, int bin_op)
+{
+    MPI_Op op = get_mpi_op(bin_op);
+    if (op == MPI_OP_NULL)
+    {
+        std::cerr << "Error: unknown operation for a shared value update\n";
+        return;
+    }
+    bool unsigned_op = bin_op == BinOp::UMax || bin_op == BinOp::UMin;
+
+    _memory_handler->shared_value_accumulate(base_ptr, value_ptr, nullptr, op, unsigned_op);
+}
+
+void shared_value_fetch_and_op(void *base_ptr, void *value_ptr, void *result_ptr, int bin_op)
+{
+    MPI_Op op = get_mpi_op(bin_op);
+    if (op == MPI_OP_NULL)
+    {
+        std::cerr << "Error: unknown operation for a shared value update\n";
+        return;
+    }
+    bool unsigned_op = bin_op == BinOp::UMax || bin_op == BinOp::UMin;
+
+    _memory_handler->shared_value_accumulate(base_ptr, value_ptr, result_ptr, op,
+                                             unsigned_op);
+}
+
+void shared_value_compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr,
+                                   void *result_ptr)
+{
+    _memory_handler->shared_value_compare_and_swap(base_ptr, value_ptr, compare_ptr,
+                                                   result_ptr);
+}
+
 void shared_value_synchronize(void *base_ptr)
 {
     _memory_handler->shared_value_synchronize(base_ptr);
@@ -144,18 +443,186 @@ void shared_value_synchronize(void *base_ptr)
 
 void modify_parallel_for_bounds(int *lower_bound, int *upper_bound, int increment)
 {
-    modify_parallel_for_bounds<int>(lower_bound, upper_bound, increment);
+    modify_parallel_for_bounds<int, int>(lower_bound, upper_bound, increment);
+}
+
+void modify_parallel_for_bounds(unsigned *lower_bound, unsigned *upper_bound, int increment)
+{
+    modify_parallel_for_bounds<unsigned, int>(lower_bound, upper_bound, increment);
 }
 
 void modify_parallel_for_bounds(long *lower_bound, long *upper_bound, long increment)
 {
-    modify_parallel_for_bounds<long>(lower_bound, upper_bound, increment);
+    modify_parallel_for_bounds<long, long>(lower_bound, upper_bound, increment);
+}
+
+void modify_parallel_for_bounds(unsigned long *lower_bound, unsigned long *upper_bound,
+                                long increment)
+{
+    modify_parallel_for_bounds<unsigned long, long>(lower_bound, upper_bound, increment);
+}
+
+template <typename T, typename S>
+static void modify_parallel_for_bounds_aligned(T *lower_bound, T *upper_bound, S increment,
+                                               void *base_ptr, long offset)
+{
+    long first, last, num_rows;
+    if (increment != 1 || *lower_bound > *upper_bound ||
+        (std::is_unsigned<T>::value && (unsigned long)*upper_bound > LONG_MAX) ||
+        !_memory_handler->get_local_rows(base_ptr, &first, &last, &num_rows))
+    {
+        modify_parallel_for_bounds<T, S>(lower_bound, upper_bound, increment);
+        return;
+    }
+
+    long local_lbound = *lower_bound;
+    long local_ubound = *upper_bound;
+    if (last < first)
+    {
+        local_ubound = local_lbound - 1;
+    }
+    else
+    {
+        if (first > 0)
+        {
+            local_lbound = std::max(local_lbound, first - offset);
+        }
+        if (last < num_rows - 1)
+        {
+            local_ubound = std::min(local_ubound, last - offset);
+        }
+    }
+
+    Debug(std::cout << "Local lower bound: " << local_lbound << "\nLocal upper bound: "
+                    << local_ubound << " (aligned to the elements " << first << " to "
+                    << last << ")\n";);
+
+    if (local_ubound < local_lbound)
+    {
+        // An empty range computed in T, so it neither overflows at the largest value of T
+        // nor at the smallest one, where the lower bound equals the upper bound
+        T upper = *upper_bound;
+        bool above_min = upper > std::numeric_limits<T>::min();
+        *lower_bound = above_min ? upper : (T)(upper + 1);
+        *upper_bound = above_min ? (T)(upper - 1) : upper;
+        return;
+    }
+
+    *lower_bound = local_lbound;
+    *upper_bound = local_ubound;
+}
+
+void modify_parallel_for_bounds_aligned(int *lower_bound, int *upper_bound, int increment,
+                                        void *base_ptr, long offset)
+{
+    modify_parallel_for_bounds_aligned<int, int>(lower_bound, upper_bound, increment, base_ptr,
+                                                 offset);
+}
+
+void modify_parallel_for_bounds_aligned(unsigned *lower_bound, unsigned *upper_bound,
+                                        int increment, void *base_ptr, long offset)
+{
+    modify_parallel_for_bounds_aligned<unsigned, int>(lower_bound, upper_bound, increment,
+                                                      base_ptr, offset);
+}
+
+void modify_parallel_for_bounds_aligned(long *lower_bound, long *upper_bound, long increment,
+                                        void *base_ptr, long offset)
+{
+    modify_parallel_for_bounds_aligned<long, long>(lower_bound, upper_bound, increment,
+                                                   base_ptr, offset);
+}
+
+void modify_parallel_for_bounds_aligned(unsigned long *lower_bound, unsigned long *upper_bound,
+                                        long increment, void *base_ptr, long offset)
+{
+    modify_parallel_for_bounds_aligned<unsigned long, long>(lower_bound, upper_bound,
+                                                            increment, base_ptr, offset);
+}
+
+template <typename T, typename S>
+static void parallel_for_dispatch_init(int schedule, T lower_bound, T upper_bound, S stride,
+                                       S chunk)
+{
+    long num_iterations = get_parallel_for_iterations(lower_bound, upper_bound, stride);
+    _loop_scheduler->init(schedule, num_iterations, chunk, lower_bound, stride);
+}
+
+template <typename T, typename S>
+static int parallel_for_dispatch_next(int *last, T *lower_bound, T *upper_bound, S *stride)
+{
+    long first, count;
+    if (!_loop_scheduler->next(&first, &count))
+    {
+        return 0;
+    }
+
+    T loop_lower_bound = _loop_scheduler->get_lower_bound();
+    S loop_stride = _loop_scheduler->get_stride();
+    *lower_bound = loop_lower_bound + (T)first * loop_stride;
+    *upper_bound = loop_lower_bound + (T)(first + count - 1) * loop_stride;
+    *stride = loop_stride;
+    *last = _loop_scheduler->is_last();
+    return 1;
+}
+
+void parallel_for_dispatch_init(int schedule, int lower_bound, int upper_bound, int stride,
+                                int chunk)
+{
+    parallel_for_dispatch_init<int, int>(schedule, lower_bound, upper_bound, stride, chunk);
+}
+
+void parallel_for_dispatch_init(int schedule, unsigned lower_bound, unsigned upper_bound,
+                                int stride, int chunk)
+{
+    parallel_for_dispatch_init<unsigned, int>(schedule, lower_bound, upper_bound, stride,
+                                              chunk);
+}
+
+void parallel_for_dispatch_init(int schedule, long lower_bound, long upper_bound, long stride,
+                                long chunk)
+{
+    parallel_for_dispatch_init<long, long>(schedule, lower_bound, upper_bound, stride, chunk);
+}
+
+void parallel_for_dispatch_init(int schedule, unsigned long lower_bound,
+                                unsigned long upper_bound, long stride, long chunk)
+{
+    parallel_for_dispatch_init<unsigned long, long>(schedule, lower_bound, upper_bound, stride,
+                                                    chunk);
+}
+
+int parallel_for_dispatch_next(int *last, int *lower_bound, int *upper_bound, int *stride)
+{
+    return parallel_for_dispatch_next<int, int>(last, lower_bound, upper_bound, stride);
+}
+
+int parallel_for_dispatch_next(int *last, unsigned *lower_bound, unsigned *upper_bound,
+                               int *stride)
+{
+    return parallel_for_dispatch_next<unsigned, int>(last, lower_bound, upper_bound, stride);
+}
+
+int parallel_for_dispatch_next(int *last, long *lower_bound, long *upper_bound, long *stride)
+{
+    return parallel_for_dispatch_next<long, long>(last, lower_bound, upper_bound, stride);
+}
+
+int parallel_for_dispatch_next(int *last, unsigned long *lower_bound,
+                               unsigned long *upper_bound, long *stride)
+{
+    return parallel_for_dispatch_next<unsigned long, long>(last, lower_bound, upper_bound,
+                                                           stride);
 }
 
 void *critical_section_init()
 {
+    // All processes create the mutexes in the same order, so they agree on the homes. The
+    // homes are spread over the processes to spread the traffic of the mutexes.
+    static int next_home = 0;
     MPI_Mutex *mutex = nullptr;
-    MPI_Mutex_init(&mutex, 0);
+    MPI_Mutex_init(&mutex, next_home);
+    next_home = (next_home + 1) % MPI_SIZE;
     return (void *)mutex;
 }
 
@@ -163,11 +630,18 @@ void critical_section_enter(void *mpi_mutex)
 {
     MPI_Mutex *mutex = (MPI_Mutex *)mpi_mutex;
     MPI_Mutex_lock(mutex);
+
+    // Stores of the process that left the critical section before have to be visible
+    _memory_handler->invalidate_caches();
 }
 
 void critical_section_leave(void *mpi_mutex)
 {
     MPI_Mutex *mutex = (MPI_Mutex *)mpi_mutex;
+
+    // Stores from inside the critical section have to be visible to the next process
+    // that enters it
+    _memory_handler->flush();
     MPI_Mutex_unlock(mutex);
 }
 
@@ -178,21 +652,308 @@ void critical_section_finalize(void *mpi_mutex)
     delete mutex;
 }
 
-void reduce_local_vars(void *local_var, int bin_op, MPI_Datatype type)
+MPI_Op get_mpi_op(int bin_op)
 {
     switch (bin_op)
     {
+    case BinOp::Xchg:
+        return MPI_REPLACE;
     case BinOp::Add:
-        MPI_Allreduce(MPI_IN_PLACE, local_var, 1, type, MPI_SUM, MPI_COMM_WORLD);
-        break;
+    case BinOp::FAdd:
+        return MPI_SUM;
+    case BinOp::And:
+        return MPI_BAND;
+    case BinOp::Or:
+        return MPI_BOR;
+    case BinOp::Xor:
+        return MPI_BXOR;
     case BinOp::Max:
-        MPI_Allreduce(MPI_IN_PLACE, local_var, 1, type, MPI_MAX, MPI_COMM_WORLD);
-        break;
+    case BinOp::UMax:
+        return MPI_MAX;
     case BinOp::Min:
-        MPI_Allreduce(MPI_IN_PLACE, local_var, 1, type, MPI_MIN, MPI_COMM_WORLD);
-        break;
+    case BinOp::UMin:
+        return MPI_MIN;
     default:
-        std::cerr << "Error: unknown reduction operation\n";
-        break;
+        return MPI_OP_NULL;
+    }
+}
+
+// The function of the array section reduction that is currently done by
+// reduce_scatter_local_array. Its user defined MPI operation has no other way to get it.
+static void (*_reduction_function)(void *, void *);
+
+/**
+ * Returns true if CATO_LAZY_REDUCTIONS is set to a value other than 0
+ **/
+static bool lazy_reductions_enabled()
+{
+    static bool enabled = []() {
+        const char *value = std::getenv("CATO_LAZY_REDUCTIONS");
+        return value != nullptr && std::atoi(value) != 0;
+    }();
+    return enabled;
+}
+
+/**
+ * The local reduction variables of one reduction packed into a single buffer. The MPI
+ * datatype of the buffer carries a pointer to the PackedReduction as attribute, so the user
+ * defined MPI operation finds the layout and the reduction function even while several
+ * reductions are in flight.
+ **/
+struct PackedReduction
+{
+    void (*function)(void *, void *);
+
+    // Copy of the entries of the reduction list. The pointers to the local variables are only
+    // used while packing and unpacking, the other entries are passed on unchanged.
+    std::vector<void *> list;
+
+    // Offset and size in bytes of each variable in the buffer, -1 and 0 for the entries that
+    // are no variables
+    std::vector<long> offsets, sizes;
+
+    // The variables that the result of a lazy reduction is combined into
+    std::vector<void *> targets;
+
+    long buffer_size;
+    std::vector<std::max_align_t> buffer;
+
+    MPI_Datatype type;
+    MPI_Op op;
+    MPI_Request request;
+
+    ~PackedReduction()
+    {
+        MPI_Op_free(&op);
+        MPI_Type_free(&type);
+    }
+
+    char *get_buffer() { return reinterpret_cast<char *>(buffer.data()); }
+};
+
+// Attribute key of the PackedReduction of a packed buffer datatype
+static int _reduction_keyval = MPI_KEYVAL_INVALID;
+
+// Reductions started by start_reduce_local_vars that have not been completed yet
+static std::vector<std::unique_ptr<PackedReduction>> _pending_reductions;
+
+/**
+ * User defined MPI operation for packed reductions. Combines each packed buffer in inout
+ * with the one in in by calling the reduction function on lists of pointers into them.
+ **/
+static void combine_reduction_buffers(void *in, void *inout, int *len, MPI_Datatype *type)
+{
+    PackedReduction *reduction;
+    int found;
+    MPI_Type_get_attr(*type, _reduction_keyval, &reduction, &found);
+
+    long num_entries = reduction->list.size();
+    std::vector<void *> lhs(num_entries), rhs(num_entries);
+    for (int i = 0; i < *len; i++)
+    {
+        char *in_buffer = static_cast<char *>(in) + i * reduction->buffer_size;
+        char *inout_buffer = static_cast<char *>(inout) + i * reduction->buffer_size;
+        for (long j = 0; j < num_entries; j++)
+        {
+            if (reduction->offsets[j] < 0)
+            {
+                lhs[j] = rhs[j] = reduction->list[j];
+                continue;
+            }
+            lhs[j] = inout_buffer + reduction->offsets[j];
+            rhs[j] = in_buffer + reduction->offsets[j];
+        }
+        reduction->function(lhs.data(), rhs.data());
     }
 }
+
+/**
+ * Packs the local variables of a reduction, see reduce_local_vars. args holds the size of
+ * each entry, followed by its target if with_targets is true.
+ **/
+static std::unique_ptr<PackedReduction>
+pack_local_vars(void *reduction_list, void (*reduction_function)(void *, void *),
+                int num_entries, va_list args, bool with_targets)
+{
+    auto reduction = std::make_unique<PackedReduction>();
+    reduction->function = reduction_function;
+    void **list = static_cast<void **>(reduction_list);
+    reduction->list.assign(list, list + num_entries);
+    reduction->offsets.resize(num_entries);
+    reduction->sizes.resize(num_entries);
+
+    // Every variable is aligned to the largest power of two that divides its size in the
+    // packed buffer, up to the largest alignment of a scalar type
+    long max_alignment = alignof(std::max_align_t);
+    long buffer_size = 0;
+    for (int i = 0; i < num_entries; i++)
+    {
+        long size = va_arg(args, long);
+        reduction->sizes[i] = size;
+        if (with_targets)
+        {
+            reduction->targets.push_back(va_arg(args, void *));
+        }
+        if (size == 0)
+        {
+            reduction->offsets[i] = -1;
+            continue;
+        }
+        long alignment = std::min(size & -size, max_alignment);
+        long offset = (buffer_size + alignment - 1) / alignment * alignment;
+        reduction->offsets[i] = offset;
+        buffer_size = offset + size;
+    }
+    reduction->buffer_size = (buffer_size + max_alignment - 1) / max_alignment * max_alignment;
+
+    reduction->buffer.resize((reduction->buffer_size + sizeof(std::max_align_t) - 1) /
+                             sizeof(std::max_align_t));
+    char *packed = reduction->get_buffer();
+    for (int i = 0; i < num_entries; i++)
+    {
+        if (reduction->offsets[i] >= 0)
+        {
+            std::memcpy(packed + reduction->offsets[i], list[i], reduction->sizes[i]);
+        }
+    }
+
+    if (_reduction_keyval == MPI_KEYVAL_INVALID)
+    {
+        MPI_Type_create_keyval(MPI_TYPE_NULL_COPY_FN, MPI_TYPE_NULL_DELETE_FN,
+                               &_reduction_keyval, nullptr);
+    }
+    MPI_Type_contiguous(reduction->buffer_size, MPI_BYTE, &reduction->type);
+    MPI_Type_commit(&reduction->type);
+    MPI_Type_set_attr(reduction->type, _reduction_keyval, reduction.get());
+    MPI_Op_create(&combine_reduction_buffers, 1, &reduction->op);
+    return reduction;
+}
+
+void reduce_local_vars(void *reduction_list, void (*reduction_function)(void *, void *),
+                       int num_entries, ...)
+{
+    va_list args;
+    va_start(args, num_entries);
+    auto reduction = pack_local_vars(reduction_list, reduction_function, num_entries, args,
+                                     false);
+    va_end(args);
+
+    char *packed = reduction->get_buffer();
+    MPI_Allreduce(MPI_IN_PLACE, packed, 1, reduction->type, reduction->op, MPI_COMM_WORLD);
+
+    for (int i = 0; i < num_entries; i++)
+    {
+        if (reduction->offsets[i] >= 0)
+        {
+            std::memcpy(reduction->list[i], packed + reduction->offsets[i],
+                        reduction->sizes[i]);
+        }
+    }
+}
+
+int start_reduce_local_vars(void *reduction_list, void (*reduction_function)(void *, void *),
+                            int num_entries, ...)
+{
+    if (!lazy_reductions_enabled())
+    {
+        return 0;
+    }
+
+    va_list args;
+    va_start(args, num_entries);
+    auto reduction = pack_local_vars(reduction_list, reduction_function, num_entries, args,
+                                     true);
+    va_end(args);
+
+    MPI_Iallreduce(MPI_IN_PLACE, reduction->get_buffer(), 1, reduction->type, reduction->op,
+                   MPI_COMM_WORLD, &reduction->request);
+    _pending_reductions.push_back(std::move(reduction));
+    return 1;
+}
+
+void reduction_wait(void *target_ptr)
+{
+    for (auto it = _pending_reductions.begin(); it != _pending_reductions.end();)
+    {
+        PackedReduction &reduction = **it;
+        if (std::find(reduction.targets.begin(), reduction.targets.end(), target_ptr) ==
+            reduction.targets.end())
+        {
+            ++it;
+            continue;
+        }
+
+        MPI_Wait(&reduction.request, MPI_STATUS_IGNORE);
+
+        // Every process holds the initial values of the targets, so each of them combines
+        // the reduced values into its own copy
+        long num_entries = reduction.list.size();
+        std::vector<void *> lhs(num_entries), rhs(num_entries);
+        for (long i = 0; i < num_entries; i++)
+        {
+            if (reduction.offsets[i] < 0)
+            {
+                lhs[i] = rhs[i] = reduction.list[i];
+                continue;
+            }
+            lhs[i] = reduction.targets[i];
+            rhs[i] = reduction.get_buffer() + reduction.offsets[i];
+        }
+        reduction.function(lhs.data(), rhs.data());
+        it = _pending_reductions.erase(it);
+    }
+}
+
+static void finish_pending_reductions()
+{
+    for (auto &reduction : _pending_reductions)
+    {
+        MPI_Wait(&reduction->request, MPI_STATUS_IGNORE);
+    }
+    _pending_reductions.clear();
+
+    if (_reduction_keyval != MPI_KEYVAL_INVALID)
+    {
+        MPI_Type_free_keyval(&_reduction_keyval);
+    }
+}
+
+/**
+ * Combines count elements of an array section with the elements in in by calling the
+ * reduction function on lists of an array section and its length
+ **/
+static void combine_array_section(void *elements, void *in, long count)
+{
+    void *lhs[2] = {elements, reinterpret_cast<void *>(count)};
+    void *rhs[2] = {in, reinterpret_cast<void *>(count)};
+    _reduction_function(lhs, rhs);
+}
+
+/**
+ * User defined MPI operation for reduce_scatter_local_array
+ **/
+static void combine_array_sections(void *in, void *inout, int *len, MPI_Datatype *type)
+{
+    combine_array_section(inout, in, *len);
+}
+
+int reduce_scatter_local_array(void *reduction_list,
+                               void (*reduction_function)(void *, void *), void *target_ptr,
+                               long num_elements, long element_size)
+{
+    _reduction_function = reduction_function;
+
+    MPI_Datatype element_type;
+    MPI_Type_contiguous(element_size, MPI_BYTE, &element_type);
+    MPI_Type_commit(&element_type);
+    MPI_Op op;
+    MPI_Op_create(&combine_array_sections, 1, &op);
+
+    void *local_ptr = *static_cast<void **>(reduction_list);
+    bool scattered = _memory_handler->reduce_scatter(target_ptr, local_ptr, num_elements,
+                                                     element_type, op, &combine_array_section);
+
+    MPI_Op_free(&op);
+    MPI_Type_free(&element_type);
+    return scattered;
+}
@@ -1,11 +1,15 @@
 #ifndef CATO_RTLIB_RTLIB_H
 #define CATO_RTLIB_RTLIB_H
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mpi.h>
+#include <type_traits>
 
 #include "CatoRuntimeLogger.h"
+#include "LoopScheduler.h"
 #include "MemoryAbstractionHandler.h"
 
 /**
@@ -62,6 +66,9 @@ int MPI_SIZE = 0;
 // One global instance of the MemoryAbstractionHandler class to manage shared memory objects
 std::unique_ptr<MemoryAbstractionHandler> _memory_handler;
 
+// Distributes the iterations of dynamically scheduled parallel for loops
+std::unique_ptr<LoopScheduler> _loop_scheduler;
+
 /**
  * Dummy function for testing
  **/
@@ -94,9 +101,22 @@ int get_mpi_size();
 
 /**
  * Insert MPI_Barrier call
+ * Outstanding operations on shared memory objects are completed before the barrier
  **/
 void mpi_barrier();
 
+/**
+ * Open a passive target epoch on all shared memory segments
+ * Gets called before a microtask is executed
+ **/
+void shared_memory_epoch_begin();
+
+/**
+ * Complete all outstanding operations and close the passive target epoch
+ * Gets called after a microtask has been executed
+ **/
+void shared_memory_epoch_end();
+
 /**
  * Allocate a shared memory segment
  **/
@@ -116,6 +136,15 @@ void shared_memory_free(void *base_ptr);
  **/
 void shared_memory_store(void *base_ptr, void *value_ptr, int num_indices, ...);
 
+/**
+ * Fixed arity variants of shared_memory_store for 1D, 2D and 3D accesses.
+ * They avoid reading varargs and building an index vector on every access.
+ **/
+void shared_memory_store_1d(void *base_ptr, void *value_ptr, long index0);
+void shared_memory_store_2d(void *base_ptr, void *value_ptr, long index0, long index1);
+void shared_memory_store_3d(void *base_ptr, void *value_ptr, long index0, long index1,
+                            long index2);
+
 /**
  * Load from a shared memory segment
  * Takes the base pointer of the shared memory object,
@@ -125,6 +154,81 @@ void shared_memory_store(void *base_ptr, void *value_ptr, int num_indices, ...);
  **/
 void shared_memory_load(void *base_ptr, void *dest_ptr, int num_indices, ...);
 
+/**
+ * Fixed arity variants of shared_memory_load.
+ **/
+void shared_memory_load_1d(void *base_ptr, void *dest_ptr, long index0);
+void shared_memory_load_2d(void *base_ptr, void *dest_ptr, long index0, long index1);
+void shared_memory_load_3d(void *base_ptr, void *dest_ptr, long index0, long index1,
+                           long index2);
+
+/**
+ * Returns the handle of the shared memory object with the given base pointer
+ * or -1 if the pointer does not belong to a shared memory object.
+ * The handle can be used for accesses instead of the base pointer.
+ **/
+long shared_memory_handle(void *base_ptr);
+
+/**
+ * Store to a shared memory segment
+ * Takes the handle of the shared memory object (see shared_memory_handle),
+ * a void pointer to the value that is to be stored,
+ * number of pointer access indices,
+ * a list of access indices
+ **/
+void shared_memory_store_with_handle(long handle, void *value_ptr, int num_indices, ...);
+
+/**
+ * Fixed arity variants of shared_memory_store_with_handle.
+ **/
+void shared_memory_store_with_handle_1d(long handle, void *value_ptr, long index0);
+void shared_memory_store_with_handle_2d(long handle, void *value_ptr, long index0,
+                                        long index1);
+void shared_memory_store_with_handle_3d(long handle, void *value_ptr, long index0, long index1,
+                                        long index2);
+
+/**
+ * Load from a shared memory segment
+ * Takes the handle of the shared memory object (see shared_memory_handle),
+ * a void pointer to the destination of the loaded value,
+ * number of pointer access indices,
+ * a list of access indices
+ **/
+void shared_memory_load_with_handle(long handle, void *dest_ptr, int num_indices, ...);
+
+/**
+ * Fixed arity variants of shared_memory_load_with_handle.
+ **/
+void shared_memory_load_with_handle_1d(long handle, void *dest_ptr, long index0);
+void shared_memory_load_with_handle_2d(long handle, void *dest_ptr, long index0, long index1);
+void shared_memory_load_with_handle_3d(long handle, void *dest_ptr, long index0, long index1,
+                                       long index2);
+
+/**
+ * Atomic update of an element of a shared memory segment
+ * Takes the handle of the shared memory object (see shared_memory_handle),
+ * a void pointer to the operand of the update,
+ * a void pointer to the destination of the old value or nullptr if it is not needed,
+ * the BinOp of the update,
+ * number of pointer access indices,
+ * a list of access indices
+ **/
+void shared_memory_atomic_with_handle(long handle, void *value_ptr, void *result_ptr,
+                                      int bin_op, int num_indices, ...);
+
+/**
+ * Atomic compare and swap of an element of a shared memory segment
+ * Takes the handle of the shared memory object (see shared_memory_handle),
+ * a void pointer to the new value,
+ * a void pointer to the value that is compared with the element,
+ * a void pointer to the destination of the old value,
+ * number of pointer access indices,
+ * a list of access indices
+ **/
+void shared_memory_compare_and_swap_with_handle(long handle, void *value_ptr,
+                                                void *compare_ptr, void *result_ptr,
+                                                int num_indices, ...);
+
 /**
  * Store in a non OpenMP section of the original program
  * Takes the base pointer of the shared memory object,
@@ -134,6 +238,15 @@ void shared_memory_load(void *base_ptr, void *dest_ptr, int num_indices, ...);
  **/
 void shared_memory_sequential_store(void *base_ptr, void *value_ptr, int num_indices, ...);
 
+/**
+ * Fixed arity variants of shared_memory_sequential_store.
+ **/
+void shared_memory_sequential_store_1d(void *base_ptr, void *value_ptr, long index0);
+void shared_memory_sequential_store_2d(void *base_ptr, void *value_ptr, long index0,
+                                       long index1);
+void shared_memory_sequential_store_3d(void *base_ptr, void *value_ptr, long index0,
+                                       long index1, long index2);
+
 /**
  * Load in a non OpenMP section of the original program
  * Takes the base pointer of the shared memory object,
@@ -143,6 +256,104 @@ void shared_memory_sequential_store(void *base_ptr, void *value_ptr, int num_ind
  **/
 void shared_memory_sequential_load(void *base_ptr, void *dest_ptr, int num_indices, ...);
 
+/**
+ * Fixed arity variants of shared_memory_sequential_load.
+ **/
+void shared_memory_sequential_load_1d(void *base_ptr, void *dest_ptr, long index0);
+void shared_memory_sequential_load_2d(void *base_ptr, void *dest_ptr, long index0,
+                                      long index1);
+void shared_memory_sequential_load_3d(void *base_ptr, void *dest_ptr, long index0, long index1,
+                                      long index2);
+
+/**
+ * Store count consecutive elements to a 1D shared memory segment
+ * Takes the base pointer of the shared memory object,
+ * a void pointer to the buffer with the values that are to be stored,
+ * the index of the first element of the range,
+ * the number of elements in the range
+ **/
+void shared_memory_store_range(void *base_ptr, void *value_ptr, long start, long count);
+
+/**
+ * Load count consecutive elements from a 1D shared memory segment
+ * Takes the base pointer of the shared memory object,
+ * a void pointer to the buffer the values are copied to,
+ * the index of the first element of the range,
+ * the number of elements in the range
+ **/
+void shared_memory_load_range(void *base_ptr, void *dest_ptr, long start, long count);
+
+/**
+ * Store count consecutive elements to a row of a 2D shared memory segment
+ * Takes the base pointer of the shared memory object,
+ * a void pointer to the buffer with the values that are to be stored,
+ * the index of the row,
+ * the index of the first element of the range inside of the row,
+ * the number of elements in the range
+ **/
+void shared_memory_store_range_2d(void *base_ptr, void *value_ptr, long index0, long start,
+                                  long count);
+
+/**
+ * Load count consecutive elements from a row of a 2D shared memory segment
+ * Takes the base pointer of the shared memory object,
+ * a void pointer to the buffer the values are copied to,
+ * the index of the row,
+ * the index of the first element of the range inside of the row,
+ * the number of elements in the range
+ **/
+void shared_memory_load_range_2d(void *base_ptr, void *dest_ptr, long index0, long start,
+                                 long count);
+
+/**
+ * Copies the elements first to last of a 1D shared memory segment, or the rows first to
+ * last of a 2D shared memory segment, that are stored by other processes into ghost cells
+ * Takes the base pointer of the shared memory object,
+ * the index of the first element (row),
+ * the index of the last element (row)
+ * The ghost cells serve the loads of those elements until the end of the parallel region.
+ * The shared memory object must not be modified in the parallel region.
+ **/
+void shared_memory_exchange_halo(void *base_ptr, long first, long last);
+
+/**
+ * Prepares a loop in a non OpenMP section of the original program that stores count
+ * consecutive elements of a 1D shared memory segment, with values that every process
+ * computes on its own. Each process only writes the elements it stores locally, directly
+ * to the returned address, and skips the others.
+ * Takes the base pointer of the shared memory object,
+ * the index of the first element of the range,
+ * the number of elements in the range,
+ * a pointer the position of the first local element in the range is written to,
+ * a pointer the number of local elements in the range is written to
+ * Returns the address of the first local element or nullptr if there is none.
+ * The stores are completed by shared_memory_sequential_local_end behind the loop.
+ **/
+void *shared_memory_sequential_local_range(void *base_ptr, long start, long count,
+                                           long *first, long *local_count);
+
+/**
+ * Same as shared_memory_sequential_local_range for a range inside of the row index0 of a
+ * 2D shared memory segment
+ **/
+void *shared_memory_sequential_local_range_2d(void *base_ptr, long index0, long start,
+                                              long count, long *first, long *local_count);
+
+/**
+ * Makes the elements written after shared_memory_sequential_local_range visible to all
+ * processes
+ **/
+void shared_memory_sequential_local_end();
+
+/**
+ * Lets the sequential loads from the shared memory segment that follow read from a copy
+ * of the whole segment instead of synchronizing all processes for each element.
+ * Takes the base pointer of the shared memory object and
+ * the rank of the only process that reads the elements, or -1 if all processes read them.
+ * Objects that are too large keep the synchronized loads.
+ **/
+void shared_memory_sequential_snapshot(void *base_ptr, int reader);
+
 /**
  * Store the pointer source_ptr into the MemoryAbstraction (dest_ptr) at the given index.
  **/
@@ -164,6 +375,27 @@ void shared_value_store(void *base_ptr, void *value_ptr);
  **/
 void shared_value_load(void *base_ptr, void *dest_ptr);
 
+/**
+ * Atomically combine the value at the address value_ptr with the value of the
+ *MemoryAbstractionSingleValue (base_ptr) using the BinOp bin_op. This replaces critical
+ *sections that only update one shared variable, so no mutex is needed.
+ **/
+void shared_value_accumulate(void *base_ptr, void *value_ptr, int bin_op);
+
+/**
+ * Same as shared_value_accumulate, but copies the value of the MemoryAbstractionSingleValue
+ *before the update to result_ptr.
+ **/
+void shared_value_fetch_and_op(void *base_ptr, void *value_ptr, void *result_ptr, int bin_op);
+
+/**
+ * Atomically replace the value of the MemoryAbstractionSingleValue (base_ptr) with the value
+ *at value_ptr if it equals the value at compare_ptr. The value before the operation is
+ *copied to result_ptr.
+ **/
+void shared_value_compare_and_swap(void *base_ptr, void *value_ptr, void *compare_ptr,
+                                   void *result_ptr);
+
 /**
  * Synchronize the current correct value of the MemoryAbstractionSingleValue (base_ptr) to all
  *MPI processes. This should be called for each MemoryAbstractionSingleValue at the end of a
@@ -174,37 +406,119 @@ void shared_value_synchronize(void *base_ptr);
 /**
  * Takes pointer to the upper/lower bound of a pragma omp parallel for loop and
  * modifies the values for each mpi process.
+ * The iterations are split evenly for any positive or negative increment, the unsigned
+ * variants are used for loops with an unsigned iteration variable.
  **/
 void modify_parallel_for_bounds(int *lower_bound, int *upper_bound, int increment);
+void modify_parallel_for_bounds(unsigned *lower_bound, unsigned *upper_bound, int increment);
 void modify_parallel_for_bounds(long *lower_bound, long *upper_bound, long increment);
+void modify_parallel_for_bounds(unsigned long *lower_bound, unsigned long *upper_bound,
+                                long increment);
+
+/**
+ * Same as modify_parallel_for_bounds, but each process gets the iterations i for which the
+ * element (or row) i + offset of the shared memory object at base_ptr is stored locally.
+ * Loops that access the object at that index then only work on local memory.
+ * Iterations outside of the object go to the owners of its first and last element.
+ * Falls back to the even split if the object is not distributed in blocks.
+ **/
+void modify_parallel_for_bounds_aligned(int *lower_bound, int *upper_bound, int increment,
+                                        void *base_ptr, long offset);
+void modify_parallel_for_bounds_aligned(unsigned *lower_bound, unsigned *upper_bound,
+                                        int increment, void *base_ptr, long offset);
+void modify_parallel_for_bounds_aligned(long *lower_bound, long *upper_bound, long increment,
+                                        void *base_ptr, long offset);
+void modify_parallel_for_bounds_aligned(unsigned long *lower_bound, unsigned long *upper_bound,
+                                        long increment, void *base_ptr, long offset);
 
-template <typename T>
-void modify_parallel_for_bounds(T *lower_bound, T *upper_bound, T increment)
+/**
+ * Replaces __kmpc_dispatch_init_* of parallel for loops with a dynamic, guided or runtime
+ * schedule. Takes the OpenMP schedule type, the lower and upper bound and the stride of the
+ * loop and the chunk size. Has to be called by all processes.
+ **/
+void parallel_for_dispatch_init(int schedule, int lower_bound, int upper_bound, int stride,
+                                int chunk);
+void parallel_for_dispatch_init(int schedule, unsigned lower_bound, unsigned upper_bound,
+                                int stride, int chunk);
+void parallel_for_dispatch_init(int schedule, long lower_bound, long upper_bound, long stride,
+                                long chunk);
+void parallel_for_dispatch_init(int schedule, unsigned long lower_bound,
+                                unsigned long upper_bound, long stride, long chunk);
+
+/**
+ * Replaces __kmpc_dispatch_next_*. Takes the next chunk of iterations of the loop from the
+ * LoopScheduler, writes its bounds and returns 1.
+ * Returns 0 if all iterations have been distributed.
+ **/
+int parallel_for_dispatch_next(int *last, int *lower_bound, int *upper_bound, int *stride);
+int parallel_for_dispatch_next(int *last, unsigned *lower_bound, unsigned *upper_bound,
+                               int *stride);
+int parallel_for_dispatch_next(int *last, long *lower_bound, long *upper_bound, long *stride);
+int parallel_for_dispatch_next(int *last, unsigned long *lower_bound,
+                               unsigned long *upper_bound, long *stride);
+
+/**
+ * Returns the number of iterations of a loop from lower_bound to upper_bound (inclusive)
+ * with the given increment. The difference of the bounds is computed in the unsigned type,
+ * so it does not overflow for bounds of different signs or unsigned bounds.
+ **/
+template <typename T, typename S>
+unsigned long get_parallel_for_iterations(T lower_bound, T upper_bound, S increment)
+{
+    using U = typename std::make_unsigned<T>::type;
+    if (increment > 0 && lower_bound <= upper_bound)
+    {
+        return (U)((U)upper_bound - (U)lower_bound) / (unsigned long)increment + 1;
+    }
+    if (increment < 0 && lower_bound >= upper_bound)
+    {
+        return (U)((U)lower_bound - (U)upper_bound) / (0UL - (unsigned long)increment) + 1;
+    }
+    return 0;
+}
+
+template <typename T, typename S>
+void modify_parallel_for_bounds(T *lower_bound, T *upper_bound, S increment)
 {
     Debug(std::cout << "Modifing parallel for loop bounds.\n";);
     Debug(std::cout << "Lower bound: " << *lower_bound << "\nUpper bound: " << *upper_bound
                     << "\nIncrement: " << increment << "\n";);
 
-    if (increment != 1)
+    unsigned long total_iterations =
+        get_parallel_for_iterations(*lower_bound, *upper_bound, increment);
+    if (total_iterations == 0)
     {
-        std::cerr << "Warning: Currently only loop increments of value 1 are supported\n";
+        return;
     }
-
-    T local_lbound, local_ubound;
-
-    T total_iterations = *upper_bound - *lower_bound + 1;
-    T div = total_iterations / MPI_SIZE;
-    T rest = total_iterations % MPI_SIZE;
-
-    if (MPI_RANK < rest)
+    unsigned long div = total_iterations / MPI_SIZE;
+    unsigned long rest = total_iterations % MPI_SIZE;
+    unsigned long rank = MPI_RANK;
+
+    // Split the iterations, not the values of the iteration variable. The bounds are
+    // computed with unsigned wrap around, which gives the right values for negative
+    // increments as well.
+    using U = typename std::make_unsigned<T>::type;
+    unsigned long first = rank * div + std::min(rank, rest);
+    unsigned long count = div + (rank < rest ? 1 : 0);
+    T local_lbound = (T)((U)*lower_bound + (U)(first * (unsigned long)increment));
+    T local_ubound;
+    if (count > 0)
+    {
+        local_ubound = (T)((U)local_lbound + (U)((count - 1) * (unsigned long)increment));
+    }
+    else if (increment > 0)
     {
-        local_lbound = *lower_bound + MPI_RANK * (div + 1);
-        local_ubound = local_lbound + div;
+        // An empty range behind the end of the loop, or before its start if the upper bound
+        // is the largest value of the type
+        bool at_end = *upper_bound < std::numeric_limits<T>::max();
+        local_ubound = at_end ? *upper_bound : (T)((U)*lower_bound - 1);
+        local_lbound = at_end ? (T)((U)*upper_bound + 1) : *lower_bound;
     }
     else
     {
-        local_lbound = *lower_bound + MPI_RANK * div + rest;
-        local_ubound = local_lbound + div - 1;
+        bool at_end = *upper_bound > std::numeric_limits<T>::min();
+        local_ubound = at_end ? *upper_bound : (T)((U)*lower_bound + 1);
+        local_lbound = at_end ? (T)((U)*upper_bound - 1) : *lower_bound;
     }
 
     Debug(std::cout << "Local lower bound: " << local_lbound << "\nLocal upper bound: "
@@ -236,12 +550,58 @@ void critical_section_leave(void *mpi_mutex);
 void critical_section_finalize(void *mpi_mutex);
 
 /**
- * Performs the given reduction operation on the given values.
- * This is used to get a reduction result for the local reduction variables
- * of the processes.
+ * Returns the MPI reduction operation for the BinOp bin_op, or MPI_OP_NULL if there is none
+ **/
+MPI_Op get_mpi_op(int bin_op);
+
+/**
+ * Reduces the local reduction variables of one OpenMP reduction over all processes.
+ * reduction_list is the list that is given to __kmpc_reduce and reduction_function the
+ * function of the OpenMP program that combines two such lists. The list holds a pointer to
+ * each local variable, followed by its length for variable length array sections. The
+ * varargs are the sizes in bytes of the num_entries entries as longs, 0 for the entries
+ * that are no variables.
+ *
+ * All variables are packed into one buffer, which is reduced with a single MPI_Allreduce
+ * and a user defined operation that calls reduction_function, so every reduction operator
+ * is supported. Afterwards the local variables of all processes hold the reduced values.
  * The Pass itself still needs to combine this result with the initial value of
- * the shared variable that is reduced
+ * the shared variables that are reduced
+ **/
+void reduce_local_vars(void *reduction_list, void (*reduction_function)(void *, void *),
+                       int num_entries, ...);
+
+/**
+ * Starts the same reduction as reduce_local_vars with MPI_Iallreduce if lazy reductions are
+ * enabled (CATO_LAZY_REDUCTIONS=1) and returns 1. The varargs are the size of each entry
+ * followed by the shared variable it is reduced into, nullptr for the entries that are no
+ * variables. The reduction is completed by reduction_wait, which has to be called with one
+ * of the targets before any of them is accessed again.
+ * Returns 0 without doing anything if lazy reductions are disabled, then reduce_local_vars
+ * has to be used instead.
+ **/
+int start_reduce_local_vars(void *reduction_list, void (*reduction_function)(void *, void *),
+                            int num_entries, ...);
+
+/**
+ * Completes the reductions started by start_reduce_local_vars that reduce into target_ptr.
+ * The reduced values are combined with the values of their targets, which every process
+ * holds on its own. Does nothing if there is no such reduction.
+ **/
+void reduction_wait(void *target_ptr);
+
+/**
+ * Reduces the local copy of an array section of num_elements elements into the shared
+ * array section that starts at target_ptr, if target_ptr points into a distributed shared
+ * memory object. reduction_list and reduction_function are the ones of a reduction with
+ * this array section as its only variable.
+ * The elements are reduced with one MPI_Reduce_scatter_block, so each process only gets
+ * the part of the section it owns and combines it with its part of the shared memory
+ * object. Returns 1 if this has been done and 0 if target_ptr is not in a shared memory
+ * object, then nothing has been reduced. Has to be called by all processes.
  **/
-void reduce_local_vars(void *local_var, int bin_op, MPI_Datatype type);
+int reduce_scatter_local_array(void *reduction_list,
+                               void (*reduction_function)(void *, void *), void *target_ptr,
+                               long num_elements, long element_size);
 
 #endif
@@ -0,0 +1,47 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+// Measures the cost of single element loads on a shared array.
+// The accessed indices are scattered over the whole array, so the loads can not be
+// combined and every access has to look up the owning process of its element.
+// The time per access should not depend on the number of processes.
+
+#define N 1048576
+#define ACCESSES 100000
+
+int main()
+{
+    int* array = (int*)malloc(sizeof(int) * N);
+
+    #pragma omp parallel for
+    for(int i = 0; i < N; i++)
+    {
+        array[i] = i;
+    }
+
+    long sum = 0;
+    double start = omp_get_wtime();
+
+    #pragma omp parallel reduction(+:sum)
+    {
+        for(long i = 0; i < ACCESSES; i++)
+        {
+            sum += array[(i * 7919) % N];
+        }
+    }
+
+    double time = omp_get_wtime() - start;
+
+    #pragma omp parallel
+    {
+        if(omp_get_thread_num() == 0)
+        {
+            printf("processes: %d\n", omp_get_num_threads());
+            printf("time per access: %.3f us\n", time / ACCESSES * 1e6);
+            printf("checksum: %ld\n", sum);
+        }
+    }
+
+    free(array);
+}
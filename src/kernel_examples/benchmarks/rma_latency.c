@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+// Measures the latency of single element stores and loads on array elements that are
+// stored by another process. Each thread (process) accesses the block of its right
+// neighbour, so with CATO_STORE_BUFFER=0 and CATO_NODE_SHARING=0 every access is one
+// MPI_Accumulate or MPI_Get_accumulate. Running it once more with CATO_WINDOW_ALLOCATE=0,
+// which creates the windows with MPI_Win_create on malloc'ed memory instead of
+// MPI_Win_allocate, shows the effect of MPI allocated memory.
+
+#define N 1048576
+#define ACCESSES 100000
+
+int main()
+{
+    int* array = (int*)malloc(sizeof(int) * N);
+
+    #pragma omp parallel for
+    for(int i = 0; i < N; i++)
+    {
+        array[i] = i;
+    }
+
+    double put_time = 0, get_time = 0;
+    long sum = 0;
+
+    #pragma omp parallel reduction(+:sum, put_time, get_time)
+    {
+        int threads = omp_get_num_threads();
+        long block = N / threads;
+        long neighbour = (omp_get_thread_num() + 1) % threads * block;
+
+        double start = omp_get_wtime();
+        for(long i = 0; i < ACCESSES; i++)
+        {
+            array[neighbour + (i * 7919) % block] = i;
+        }
+        put_time += omp_get_wtime() - start;
+
+        #pragma omp barrier
+
+        start = omp_get_wtime();
+        for(long i = 0; i < ACCESSES; i++)
+        {
+            sum += array[neighbour + (i * 7919) % block];
+        }
+        get_time += omp_get_wtime() - start;
+    }
+
+    #pragma omp parallel
+    {
+        if(omp_get_thread_num() == 0)
+        {
+            printf("processes: %d\n", omp_get_num_threads());
+            int threads = omp_get_num_threads();
+            printf("time per store: %.3f us\n", put_time / threads / ACCESSES * 1e6);
+            printf("time per load: %.3f us\n", get_time / threads / ACCESSES * 1e6);
+            printf("checksum: %ld\n", sum);
+        }
+    }
+
+    free(array);
+}
@@ -0,0 +1,53 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    // Separately allocated rows
+    int** in = (int**)malloc(sizeof(int*) * 6);
+    for(int i = 0; i < 6; i++)
+    {
+        in[i] = (int*)malloc(sizeof(int) * 5);
+    }
+
+    // Rows inside of one contiguous allocation
+    int* data = (int*)malloc(sizeof(int) * 6 * 5);
+    int** out = (int**)malloc(sizeof(int*) * 6);
+    for(int i = 0; i < 6; i++)
+    {
+        out[i] = data + i * 5;
+    }
+
+    #pragma omp parallel for
+    for(int i = 0; i < 6; i++)
+    {
+        for(int j = 0; j < 5; j++)
+        {
+            in[i][j] = i * 5 + j;
+            out[i][j] = 0;
+        }
+    }
+
+    #pragma omp parallel for
+    for(int i = 1; i < 6; i++)
+    {
+        for(int j = 0; j < 5; j++)
+        {
+            out[i][j] = in[i - 1][j] + in[i][j];
+        }
+    }
+
+    printf("[%d, %d, %d, %d, %d]\n", out[0][0], out[1][1], out[2][2], out[3][3], out[4][4]);
+    printf("[%d, %d, %d, %d, %d]\n", out[5][0], out[5][1], out[5][2], out[5][3], out[5][4]);
+
+    for(int i = 0; i < 6; i++)
+    {
+        free(in[i]);
+    }
+    free(in);
+    free(out);
+    free(data);
+}
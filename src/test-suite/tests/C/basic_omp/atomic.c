@@ -0,0 +1,28 @@
+// PASS: *
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main()
+{
+    int *hist = malloc(sizeof(int) * 2);
+    hist[0] = 0;
+    hist[1] = 0;
+    int count = 0;
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+
+        #pragma omp atomic
+        hist[thread % 2] += thread + 1;
+
+        #pragma omp atomic
+        count++;
+    }
+
+    printf("hist: %d %d count: %d\n", hist[0], hist[1], count);
+    free(hist);
+}
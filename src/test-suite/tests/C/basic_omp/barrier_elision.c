@@ -0,0 +1,52 @@
+// PASS: *
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main()
+{
+    int n = 16;
+    int *array = (int *)malloc(sizeof(int) * n);
+
+    for (int i = 0; i < n; i++)
+    {
+        array[i] = i;
+    }
+
+    // Only reads the array
+    int sum = 0;
+    #pragma omp parallel for reduction(+:sum)
+    for (int i = 0; i < n; i++)
+    {
+        sum += array[i];
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++)
+    {
+        array[i] = 2 * array[i];
+    }
+
+    // Reads the elements of the other processes, which the next loop overwrites
+    int max = 0;
+    #pragma omp parallel for reduction(max:max)
+    for (int i = 0; i < n; i++)
+    {
+        if (array[n - 1 - i] > max)
+        {
+            max = array[n - 1 - i];
+        }
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++)
+    {
+        array[i] = 0;
+    }
+
+    printf("sum: %d max: %d first: %d\n", sum, max, array[0]);
+    free(array);
+    return 0;
+}
@@ -0,0 +1,27 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <omp.h>
+
+int main()
+{
+    int count = 0;
+    int sum = 0;
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+
+        // All threads enter the critical section over and over, so they queue for the lock
+        for(int i = 0; i < 50; i++)
+        {
+            #pragma omp critical
+            {
+                count = count + 1;
+                sum = sum + thread;
+            }
+        }
+    }
+
+    printf("count: %d sum: %d\n", count, sum);
+}
@@ -0,0 +1,35 @@
+// PASS: *
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+
+int main()
+{
+    double max = 0.0;
+    int count = 100;
+    int flags = 0;
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        double value = 1.5 * thread;
+
+        #pragma omp critical
+        {
+            max = max > value ? max : value;
+        }
+
+        #pragma omp critical
+        {
+            count -= thread + 1;
+        }
+
+        #pragma omp critical
+        {
+            flags |= 1 << thread;
+        }
+    }
+
+    printf("max: %.1f count: %d flags: %d\n", max, count, flags);
+}
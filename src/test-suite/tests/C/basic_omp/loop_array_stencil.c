@@ -0,0 +1,30 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    int* in = (int*)malloc(sizeof(int)*12);
+    int* out = (int*)malloc(sizeof(int)*12);
+
+    #pragma omp parallel for
+    for(int i = 0; i < 12; i++)
+    {
+        in[i] = i;
+        out[i] = 0;
+    }
+
+    #pragma omp parallel for
+    for(int i = 1; i < 11; i++)
+    {
+        out[i] = in[i-1] + in[i] + in[i+1];
+    }
+
+    printf("[%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d]\n", out[0], out[1], out[2], out[3],
+           out[4], out[5], out[6], out[7], out[8], out[9], out[10], out[11]);
+
+    free(in);
+    free(out);
+}
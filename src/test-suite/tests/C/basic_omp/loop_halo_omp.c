@@ -0,0 +1,29 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    int* in = (int*)malloc(sizeof(int)*16);
+    int* out = (int*)malloc(sizeof(int)*16);
+
+    #pragma omp parallel for
+    for(int i = 0; i < 16; i++)
+    {
+        in[i] = i * i;
+    }
+
+    // Reads two neighbours on each side, which lie at other processes at the block borders
+    #pragma omp parallel for
+    for(int i = 2; i < 14; i++)
+    {
+        out[i] = in[i-2] + in[i-1] + in[i] + in[i+1] + in[i+2];
+    }
+
+    printf("%d %d %d %d %d\n", out[3], out[4], out[8], out[12], out[13]);
+
+    free(in);
+    free(out);
+}
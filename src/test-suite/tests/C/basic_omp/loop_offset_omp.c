@@ -0,0 +1,32 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    int* in = (int*)malloc(sizeof(int)*14);
+    int* out = (int*)malloc(sizeof(int)*14);
+
+    #pragma omp parallel for
+    for(int i = 0; i < 14; i++)
+    {
+        in[i] = i;
+        out[i] = 0;
+    }
+
+    // The loop covers only a part of the arrays and accesses them with an offset
+    #pragma omp parallel for
+    for(int i = 1; i < 10; i++)
+    {
+        out[i + 3] = in[i + 3] * 2 + in[i + 2];
+    }
+
+    printf("[%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d]\n", out[0], out[1],
+           out[2], out[3], out[4], out[5], out[6], out[7], out[8], out[9], out[10], out[11],
+           out[12], out[13]);
+
+    free(in);
+    free(out);
+}
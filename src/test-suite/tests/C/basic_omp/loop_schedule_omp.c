@@ -0,0 +1,29 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    int* arr = (int*)malloc(sizeof(int)*20);
+
+    #pragma omp parallel for schedule(dynamic, 3)
+    for(int i = 0; i < 20; i++)
+    {
+        arr[i] = i;
+    }
+
+    #pragma omp parallel for schedule(guided)
+    for(int i = 1; i < 20; i += 2)
+    {
+        arr[i] = arr[i] * 10;
+    }
+
+    printf("[%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d]\n",
+           arr[0], arr[1], arr[2], arr[3], arr[4], arr[5], arr[6], arr[7], arr[8], arr[9],
+           arr[10], arr[11], arr[12], arr[13], arr[14], arr[15], arr[16], arr[17], arr[18],
+           arr[19]);
+
+    free(arr);
+}
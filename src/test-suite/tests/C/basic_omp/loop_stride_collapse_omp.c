@@ -0,0 +1,55 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    int* arr = (int*)malloc(sizeof(int)*20);
+    int* grid = (int*)malloc(sizeof(int)*20);
+
+    #pragma omp parallel for
+    for(int i = 0; i < 20; i++)
+    {
+        arr[i] = 0;
+    }
+
+    // Negative stride
+    #pragma omp parallel for
+    for(int i = 19; i >= 0; i -= 3)
+    {
+        arr[i] += 1;
+    }
+
+    // Unsigned iteration variable with a stride
+    #pragma omp parallel for
+    for(unsigned u = 2; u < 20; u += 4)
+    {
+        arr[u] += 10;
+    }
+
+    #pragma omp parallel for collapse(2)
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 5; j++)
+        {
+            grid[i * 5 + j] = i * 10 + j;
+        }
+    }
+
+    int row_sums[4] = {0, 0, 0, 0};
+    for(int i = 0; i < 20; i++)
+    {
+        row_sums[i / 5] += grid[i];
+    }
+
+    printf("[%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d] "
+           "[%d, %d, %d, %d]\n",
+           arr[0], arr[1], arr[2], arr[3], arr[4], arr[5], arr[6], arr[7], arr[8], arr[9],
+           arr[10], arr[11], arr[12], arr[13], arr[14], arr[15], arr[16], arr[17], arr[18],
+           arr[19], row_sums[0], row_sums[1], row_sums[2], row_sums[3]);
+
+    free(arr);
+    free(grid);
+}
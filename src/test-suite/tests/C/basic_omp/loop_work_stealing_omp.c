@@ -0,0 +1,50 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(CATO_WORK_STEALING=1 mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <omp.h>
+
+int main()
+{
+    int n = 1003;
+    int* count = (int*)malloc(sizeof(int)*n);
+
+    for(int i = 0; i < n; i++)
+    {
+        count[i] = 0;
+    }
+
+    // The first iterations are slow, so the other processes steal chunks of the first block
+    #pragma omp parallel for schedule(dynamic, 4)
+    for(int i = 0; i < n; i++)
+    {
+        count[i] += 1;
+        if(i < 100)
+        {
+            usleep(1000);
+        }
+    }
+
+    #pragma omp parallel for schedule(guided, 2)
+    for(int i = 1; i < n; i += 3)
+    {
+        count[i] += 10;
+    }
+
+    // Every iteration has to be executed exactly once
+    int wrong = 0;
+    int sum = 0;
+    for(int i = 0; i < n; i++)
+    {
+        if(count[i] != (i % 3 == 1 ? 11 : 1))
+        {
+            wrong++;
+        }
+        sum += count[i];
+    }
+
+    printf("wrong: %d sum: %d\n", wrong, sum);
+
+    free(count);
+}
@@ -0,0 +1,30 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    int* in = (int*)malloc(sizeof(int)*16);
+    int* out = (int*)malloc(sizeof(int)*16);
+
+    #pragma omp parallel for
+    for(int i = 0; i < 16; i++)
+    {
+        in[i] = i;
+    }
+
+    // Every process stores into the partitions of other processes, which are accessed
+    // directly when the processes run on the same node
+    #pragma omp parallel for
+    for(int i = 0; i < 16; i++)
+    {
+        out[15 - i] = in[i] * 3;
+    }
+
+    printf("%d %d %d %d\n", out[0], out[5], out[10], out[15]);
+
+    free(in);
+    free(out);
+}
@@ -0,0 +1,68 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(CATO_READ_CACHE=64 CATO_NODE_SHARING=0 mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Runs with 4 processes. Without node sharing all other partitions are remote, so their
+// loads go through the read cache even if the processes run on one node.
+int main()
+{
+    int n = 100;
+    int *array = (int *)malloc(sizeof(int) * n);
+    int *result = (int *)malloc(sizeof(int) * 12);
+
+    #pragma omp parallel
+    {
+        int thread = omp_get_thread_num();
+        int start = thread * 25;
+        int next = ((thread + 1) % 4) * 25;
+
+        for (int i = start; i < start + 25; i++)
+        {
+            array[i] = i;
+        }
+
+        #pragma omp barrier
+
+        // Reads the partition of the next process twice out of order, the 64 byte lines
+        // cross the borders of the partitions
+        int sum = 0;
+        for (int k = 0; k < 50; k++)
+        {
+            sum += array[next + (k * 7) % 25];
+        }
+
+        // The own store updates the cached line
+        array[next + 5] = -1;
+        int own = array[next + 5];
+
+        #pragma omp barrier
+
+        for (int i = start; i < start + 25; i++)
+        {
+            array[i] = 1000 + i;
+        }
+
+        #pragma omp barrier
+
+        // The barrier dropped the cache, so the new values of the next process are read
+        int updated = 0;
+        for (int k = 0; k < 25; k++)
+        {
+            updated += array[next + (k * 7) % 25];
+        }
+
+        result[thread] = sum;
+        result[4 + thread] = own;
+        result[8 + thread] = updated;
+    }
+
+    printf("%d %d %d %d, %d %d %d %d, %d %d %d %d\n", result[0], result[1], result[2],
+           result[3], result[4], result[5], result[6], result[7], result[8], result[9],
+           result[10], result[11]);
+
+    free(array);
+    free(result);
+    return 0;
+}
@@ -0,0 +1,28 @@
+// PASS: *
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main()
+{
+    int n = 10;
+    int *hist = malloc(sizeof(int) * n);
+    for (int i = 0; i < n; i++)
+    {
+        hist[i] = 100;
+    }
+
+    #pragma omp parallel reduction(+:hist[0:n])
+    {
+        int thread = omp_get_thread_num();
+        for (int i = 0; i < n; i++)
+        {
+            hist[i] += thread + i;
+        }
+    }
+
+    printf("hist: %d %d %d\n", hist[0], hist[5], hist[9]);
+    free(hist);
+}
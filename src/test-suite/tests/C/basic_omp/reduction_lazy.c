@@ -0,0 +1,27 @@
+// PASS: *
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(CATO_LAZY_REDUCTIONS=1 mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+
+int main()
+{
+    int result = 100;
+    int total = 0;
+
+    for (int i = 0; i < 5; i++)
+    {
+        #pragma omp parallel reduction(+:result)
+        {
+            result += omp_get_thread_num();
+        }
+
+        if (i % 2 == 1)
+        {
+            total += result;
+        }
+    }
+
+    printf("result: %d total: %d\n", result, total);
+    return 0;
+}
@@ -0,0 +1,35 @@
+// PASS: *
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+
+int main()
+{
+    int product = 1;
+    int bits_and = 0xff;
+    int bits_or = 0;
+    int bits_xor = 0;
+    int all = 1;
+    int any = 0;
+    unsigned int umax = 0;
+    unsigned int umin = 100;
+
+    #pragma omp parallel reduction(*:product) reduction(&:bits_and) reduction(|:bits_or) \
+        reduction(^:bits_xor) reduction(&&:all) reduction(||:any) reduction(max:umax)     \
+        reduction(min:umin)
+    {
+        int thread = omp_get_thread_num();
+        product *= thread + 1;
+        bits_and &= ~(1 << thread);
+        bits_or |= 1 << thread;
+        bits_xor ^= thread + 1;
+        all = all && thread < 3;
+        any = any || thread == 3;
+        umax = thread == 1 ? -1u : thread;
+        umin = thread == 1 ? -1u : 10 - thread;
+    }
+
+    printf("product: %d and: %d or: %d xor: %d all: %d any: %d umax: %u umin: %u\n", product,
+           bits_and, bits_or, bits_xor, all, any, umax, umin);
+}
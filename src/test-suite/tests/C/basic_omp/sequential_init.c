@@ -0,0 +1,63 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main()
+{
+    int n = 100;
+    int *array = (int *)malloc(sizeof(int) * n);
+    int *copy = (int *)malloc(sizeof(int) * n);
+
+    int *data = (int *)malloc(sizeof(int) * 8 * 10);
+    int **matrix = (int **)malloc(sizeof(int *) * 8);
+    for (int i = 0; i < 8; i++)
+    {
+        matrix[i] = data + i * 10;
+    }
+
+    // The values only depend on the index, so each process writes its own partition
+    for (int i = 0; i < n; i++)
+    {
+        array[i] = 3 * i + 1;
+    }
+
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 10; j++)
+        {
+            matrix[i][j] = i * 10 + j;
+        }
+    }
+
+    // Reads the array, so every element is still stored on its own
+    for (int i = 0; i < n; i++)
+    {
+        copy[i] = array[n - 1 - i];
+    }
+
+    int sum = 0;
+    #pragma omp parallel for reduction(+:sum)
+    for (int i = 0; i < n; i++)
+    {
+        sum += array[i];
+    }
+
+    int matrix_sum = 0;
+    #pragma omp parallel for reduction(+:matrix_sum)
+    for (int i = 0; i < 8; i++)
+    {
+        for (int j = 0; j < 10; j++)
+        {
+            matrix_sum += matrix[i][j];
+        }
+    }
+
+    printf("sum: %d matrix: %d copy: %d\n", sum, matrix_sum, copy[0]);
+    free(array);
+    free(copy);
+    free(matrix);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,68 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main()
+{
+    int n = 100;
+    int *array = (int *)malloc(sizeof(int) * n);
+
+    for (int i = 0; i < n; i++)
+    {
+        array[i] = 2 * i;
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < n; i++)
+    {
+        array[i] += 1;
+    }
+
+    // Only reads the array, so the loads are served from a copy of the whole array
+    int sum = 0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += array[i];
+    }
+
+    // Only the first process reads here, the copy is created in front of the branch
+    if (omp_get_thread_num() == 0)
+    {
+        printf("sum: %d\n", sum);
+        for (int i = 0; i < n; i += 25)
+        {
+            printf("array[%d] = %d\n", i, array[i]);
+        }
+    }
+
+    // The parallel write drops the copies, so both read loops of every step create their own
+    for (int step = 1; step <= 3; step++)
+    {
+        int before = 0;
+        for (int i = 0; i < n; i++)
+        {
+            before += array[i];
+        }
+
+        #pragma omp parallel for
+        for (int i = 0; i < n; i++)
+        {
+            array[i] += step;
+        }
+
+        if (omp_get_thread_num() == 0)
+        {
+            int after = 0;
+            for (int i = 0; i < n; i++)
+            {
+                after += array[i];
+            }
+            printf("step %d: %d %d\n", step, before, after);
+        }
+    }
+
+    free(array);
+    return 0;
+}
@@ -0,0 +1,21 @@
+// RUN: ${CATO_ROOT}/scripts/cexecute_pass.py %s -o %t
+// RUN: diff <(mpirun -np 4 %t) %s.reference_output
+#include <stdio.h>
+#include <stdlib.h>
+#include <omp.h>
+
+int main()
+{
+    // Fewer elements than MPI processes, so the last process stores none of them
+    int* arr = (int*)malloc(sizeof(int)*3);
+
+    #pragma omp parallel for
+    for(int i = 0; i < 3; i++)
+    {
+        arr[i] = (i + 1) * 10;
+    }
+
+    printf("[%d, %d, %d]\n", arr[0], arr[1], arr[2]);
+
+    free(arr);
+}